@@ -0,0 +1,797 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "buffer_mgr.h"
+#include "buffer_scan.h"
+#include "storage_mgr.h"
+#include "dberror.h"
+
+/*
+    # bench_buffer_mgr replays a synthetic workload or a trace file against a buffer pool and reports
+      the hit rate, the pin throughput, the latency percentiles of pinPage and the I/O of the pool.
+    # With -T it sweeps the number of threads sharing a concurrent pool, each with its own generator
+      over the same workload, and reports the profile of each kind of latch of the pool as well.
+      -M runs the sweep over preset mixes instead of the given workload.
+    # The page file is created for each run and removed afterwards, see usage() for the options.
+*/
+
+// page file created for a run
+#define BENCH_FILE "bench_buffer_mgr.bin"
+
+// kinds of synthetic workloads, or a trace file
+typedef enum WorkloadKind
+{
+    WL_UNIFORM,  // every page equally likely
+    WL_ZIPF,     // page ranks follow a Zipf distribution with the given skew
+    WL_SCAN,     // sequential scans over the whole file
+    WL_SCAN_HOT, // a sequential scan mixed with uniform accesses to a hot set
+    WL_TRACE     // the pages of a trace file in order
+} WorkloadKind;
+
+// one request of a trace file
+typedef struct TraceEntry
+{
+    PageNumber pageNum;
+    bool write;
+} TraceEntry;
+
+// the requests to replay, shared by all generators of a run
+typedef struct Workload
+{
+    WorkloadKind kind;
+    int filePages;
+    double skew;          // Zipf exponent
+    double writeRatio;    // fraction of synthetic requests that modify the page
+    int hotPages;         // size of the hot set of WL_SCAN_HOT
+    double scanFraction;  // fraction of WL_SCAN_HOT requests that continue the scan
+    double *zipfCdf;      // cumulative probability of the Zipf ranks
+    PageNumber *rankPage; // page of each rank, so hot pages are spread over the file
+    TraceEntry *trace;
+    long traceLength;
+} Workload;
+
+// state of one stream of requests over a workload
+typedef struct Generator
+{
+    const Workload *workload;
+    uint64_t rng;
+    PageNumber scanNext;
+    long tracePos;
+} Generator;
+
+// what a run measured
+typedef struct BenchResult
+{
+    long pins;
+    long errors;
+    double seconds;
+    uint64_t *latencies; // nanoseconds of each pinPage call
+    BM_PoolStats pool;
+    BM_LatchStats latches[BM_NUM_LATCH_KINDS];
+} BenchResult;
+
+// one thread of a run, it replays its share of the pins
+typedef struct BenchThread
+{
+    BM_BufferPool *bm;
+    Generator gen;
+    long pins;
+    uint64_t *latencies; // the slice of the latencies of the run for this thread
+    long errors;
+    pthread_barrier_t *start;
+    pthread_t thread;
+} BenchThread;
+
+// preset mixes of -M
+typedef enum MixKind
+{
+    MIX_HOT,   // uniform reads of a hot set that fits half the pool, nearly all hits
+    MIX_MISS,  // uniform reads of the whole file, mostly misses when the file is larger than the pool
+    MIX_WRITE, // Zipf accesses of which half modify the page
+    NUM_MIXES
+} MixKind;
+
+// xorshift64*, fast and good enough to pick pages
+static uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ull;
+}
+
+// uniform double in [0, 1)
+static double nextUniform(uint64_t *state)
+{
+    return (double)(nextRandom(state) >> 11) / (double)(1ull << 53);
+}
+
+static uint64_t nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// returns the next request of the generator
+static void nextRequest(Generator *gen, PageNumber *pageNum, bool *write)
+{
+    const Workload *wl = gen->workload;
+
+    if (wl->kind == WL_TRACE)
+    {
+        const TraceEntry *entry = &wl->trace[gen->tracePos];
+        gen->tracePos = (gen->tracePos + 1) % wl->traceLength;
+        *pageNum = entry->pageNum;
+        *write = entry->write;
+        return;
+    }
+
+    switch (wl->kind)
+    {
+    case WL_UNIFORM:
+        *pageNum = (PageNumber)(nextRandom(&gen->rng) % (uint64_t)wl->filePages);
+        break;
+    case WL_ZIPF:
+    {
+        // binary search for the first rank whose cumulative probability exceeds u
+        double u = nextUniform(&gen->rng);
+        int low = 0, high = wl->filePages - 1;
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (wl->zipfCdf[mid] > u)
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        *pageNum = wl->rankPage[low];
+        break;
+    }
+    case WL_SCAN:
+        *pageNum = gen->scanNext;
+        gen->scanNext = (gen->scanNext + 1) % wl->filePages;
+        break;
+    default:
+        if (nextUniform(&gen->rng) < wl->scanFraction)
+        {
+            *pageNum = gen->scanNext;
+            gen->scanNext = (gen->scanNext + 1) % wl->filePages;
+        }
+        else
+        {
+            *pageNum = wl->rankPage[nextRandom(&gen->rng) % (uint64_t)wl->hotPages];
+        }
+        break;
+    }
+    *write = nextUniform(&gen->rng) < wl->writeRatio;
+}
+
+/*
+    # Reads a trace file, one request per line: a page number, optionally preceded by r or w for a
+      read or a write. Empty lines and lines starting with # are skipped.
+    # Returns the number of requests or -1 if the file cannot be read, maxPage gets the largest page.
+*/
+static long readTrace(const char *fileName, TraceEntry **trace, PageNumber *maxPage)
+{
+    FILE *file = fopen(fileName, "r");
+    char line[256];
+    long length = 0, capacity = 1024;
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+    *trace = (TraceEntry *)malloc(sizeof(TraceEntry) * capacity);
+    *maxPage = 0;
+
+    while (*trace != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        char *p = line;
+        bool write = false;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '#' || *p == '\n' || *p == '\0')
+            continue;
+        if (*p == 'r' || *p == 'R' || *p == 'w' || *p == 'W')
+        {
+            write = *p == 'w' || *p == 'W';
+            p++;
+        }
+
+        char *end;
+        long pageNum = strtol(p, &end, 10);
+        if (end == p || pageNum < 0)
+        {
+            fprintf(stderr, "bad trace line: %s", line);
+            fclose(file);
+            return -1;
+        }
+        if (length == capacity)
+        {
+            capacity *= 2;
+            *trace = (TraceEntry *)realloc(*trace, sizeof(TraceEntry) * capacity);
+            if (*trace == NULL)
+                break;
+        }
+        (*trace)[length].pageNum = (PageNumber)pageNum;
+        (*trace)[length].write = write;
+        if (pageNum > *maxPage)
+            *maxPage = (PageNumber)pageNum;
+        length++;
+    }
+    fclose(file);
+    return *trace != NULL ? length : -1;
+}
+
+// fills the Zipf table and the random rank to page mapping of the workload
+static int prepareWorkload(Workload *wl, uint64_t seed)
+{
+    uint64_t rng = seed;
+
+    wl->rankPage = (PageNumber *)malloc(sizeof(PageNumber) * wl->filePages);
+    if (wl->rankPage == NULL)
+        return -1;
+    for (int i = 0; i < wl->filePages; i++)
+        wl->rankPage[i] = i;
+    for (int i = wl->filePages - 1; i > 0; i--)
+    {
+        int j = (int)(nextRandom(&rng) % (uint64_t)(i + 1));
+        PageNumber swap = wl->rankPage[i];
+        wl->rankPage[i] = wl->rankPage[j];
+        wl->rankPage[j] = swap;
+    }
+
+    if (wl->kind == WL_ZIPF)
+    {
+        double sum = 0;
+        wl->zipfCdf = (double *)malloc(sizeof(double) * wl->filePages);
+        if (wl->zipfCdf == NULL)
+            return -1;
+        for (int i = 0; i < wl->filePages; i++)
+        {
+            sum += 1.0 / pow(i + 1, wl->skew);
+            wl->zipfCdf[i] = sum;
+        }
+        for (int i = 0; i < wl->filePages; i++)
+            wl->zipfCdf[i] /= sum;
+    }
+    return 0;
+}
+
+// creates the page file of the run with the given number of pages
+static RC createBenchFile(int filePages)
+{
+    SM_FileHandle fh;
+    RC rc = createPageFile(BENCH_FILE);
+
+    if (rc == RC_OK)
+        rc = openPageFile(BENCH_FILE, &fh);
+    if (rc == RC_OK)
+    {
+        rc = ensureCapacity(filePages, &fh);
+        closePageFile(&fh);
+    }
+    return rc;
+}
+
+/*
+    # Pins, optionally modifies, and unpins pins pages of the generator, recording the latency of
+      each pinPage call and counting the pins that failed.
+*/
+static void runRequests(BM_BufferPool *bm, Generator *gen, long pins, uint64_t *latencies, long *errors)
+{
+    BM_PageHandle h;
+
+    for (long i = 0; i < pins; i++)
+    {
+        PageNumber pageNum;
+        bool write;
+        nextRequest(gen, &pageNum, &write);
+
+        uint64_t t0 = nowNanos();
+        RC rc = pinPage(bm, &h, pageNum);
+        latencies[i] = nowNanos() - t0;
+
+        if (rc != RC_OK)
+        {
+            (*errors)++;
+            continue;
+        }
+        if (write)
+        {
+            h.data[0]++;
+            markDirty(bm, &h);
+        }
+        unpinPage(bm, &h);
+    }
+}
+
+static void *benchThread(void *arg)
+{
+    BenchThread *t = (BenchThread *)arg;
+
+    pthread_barrier_wait(t->start);
+    runRequests(t->bm, &t->gen, t->pins, t->latencies, &t->errors);
+    return NULL;
+}
+
+/*
+    # Runs the pins of the workload on a new pool shared by the given number of threads, which split
+      the pins evenly and start together. Every thread gets its own generator, seeded from seed.
+*/
+static RC runBench(const Workload *wl, int frames, ReplacementStrategy strategy, const BM_PoolOptions *options,
+                   int threads, long pins, uint64_t seed, BenchResult *result)
+{
+    BM_BufferPool bm;
+    BenchThread *workers = (BenchThread *)calloc(threads, sizeof(BenchThread));
+    pthread_barrier_t start;
+    RC rc = workers != NULL ? createBenchFile(wl->filePages) : RC_MEMORY_ALLOCATION_FAIL;
+
+    if (rc == RC_OK)
+        rc = initBufferPoolWithOptions(&bm, BENCH_FILE, frames, strategy, NULL, options);
+    if (rc != RC_OK)
+    {
+        destroyPageFile(BENCH_FILE);
+        free(workers);
+        return rc;
+    }
+
+    pthread_barrier_init(&start, NULL, threads + 1);
+    long first = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        BenchThread *t = &workers[i];
+        t->bm = &bm;
+        t->gen.workload = wl;
+        t->gen.rng = (seed + (uint64_t)i * 0x9E3779B97F4A7C15ull) | 1;
+        // the scans of the threads start spread over the file
+        t->gen.scanNext = (PageNumber)((long)wl->filePages * i / threads);
+        t->gen.tracePos = wl->kind == WL_TRACE ? wl->traceLength * i / threads : 0;
+        t->pins = pins / threads + (i < pins % threads ? 1 : 0);
+        t->latencies = result->latencies + first;
+        t->start = &start;
+        first += t->pins;
+        pthread_create(&t->thread, NULL, benchThread, t);
+    }
+
+    pthread_barrier_wait(&start);
+    uint64_t begin = nowNanos();
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        result->errors += workers[i].errors;
+    }
+    result->seconds = (double)(nowNanos() - begin) / 1e9;
+    result->pins = pins;
+
+    // the I/O of the run and not the final flush of the dirty pages
+    getPoolStats(&bm, &result->pool);
+    getLatchStats(&bm, result->latches);
+    shutdownBufferPool(&bm);
+    destroyPageFile(BENCH_FILE);
+    pthread_barrier_destroy(&start);
+    free(workers);
+    return RC_OK;
+}
+
+static int compareLatencies(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// returns the given quantile of the sorted latencies
+static uint64_t percentile(const uint64_t *sorted, long count, double quantile)
+{
+    long index = (long)(quantile * (double)count);
+    if (index >= count)
+        index = count - 1;
+    return count > 0 ? sorted[index] : 0;
+}
+
+static const char *strategyNames[] = {"fifo", "lru", "clock", "lfu", "lru-k", "arc", "2q"};
+static const char *workloadNames[] = {"uniform", "zipf", "scan", "scan-hot", "trace"};
+static const char *backendNames[] = {"stdio", "mmap", "direct", "direct-threads"};
+static const char *framePageNames[] = {"normal", "thp", "2m", "1g"};
+static const char *mixNames[] = {"hot", "miss", "write"};
+static const char *latchNames[] = {"table_shared", "table_exclusive", "frame", "file", "replacement", "cleaner"};
+
+// returns the index of name in names or -1
+static int lookupName(const char *name, const char **names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// parses a comma separated list of mixes, "all" selects every one, returns false on an unknown name
+static bool parseMixes(const char *list, bool selected[NUM_MIXES])
+{
+    char names[64];
+    snprintf(names, sizeof(names), "%s", list);
+
+    for (char *name = strtok(names, ","); name != NULL; name = strtok(NULL, ","))
+    {
+        int index = lookupName(name, mixNames, NUM_MIXES);
+        if (strcmp(name, "all") == 0)
+        {
+            for (int i = 0; i < NUM_MIXES; i++)
+                selected[i] = true;
+        }
+        else if (index >= 0)
+            selected[index] = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+// changes the workload into the given mix, keeping its file size and skew
+static void applyMix(Workload *wl, MixKind mix, int frames)
+{
+    switch (mix)
+    {
+    case MIX_HOT:
+        wl->kind = WL_SCAN_HOT;
+        wl->scanFraction = 0;
+        wl->hotPages = frames / 2 > 0 ? frames / 2 : 1;
+        if (wl->hotPages > wl->filePages)
+            wl->hotPages = wl->filePages;
+        wl->writeRatio = 0;
+        break;
+    case MIX_MISS:
+        wl->kind = WL_UNIFORM;
+        wl->writeRatio = 0;
+        break;
+    default:
+        wl->kind = WL_ZIPF;
+        wl->writeRatio = 0.5;
+        break;
+    }
+}
+
+/*
+    # Prints what a run measured, as "name: value" lines or as one JSON object per run. The hit rate
+      is the fraction of pins that found their page in the pool, see getPoolStats.
+    # The latch profile is only printed for profiled runs, the throughput of a latch is the number
+      of times it was taken per second of the run.
+*/
+static void printResult(const char *workload, ReplacementStrategy strategy, int frames, int filePages,
+                        int threads, bool latches, bool json, BenchResult *result)
+{
+    const BM_PoolStats *pool = &result->pool;
+    long long lookups = pool->hits + pool->misses;
+    double hitRate = lookups > 0 ? (double)pool->hits / (double)lookups : 0;
+    uint64_t p50, p99, p999;
+
+    qsort(result->latencies, result->pins, sizeof(uint64_t), compareLatencies);
+    p50 = percentile(result->latencies, result->pins, 0.50);
+    p99 = percentile(result->latencies, result->pins, 0.99);
+    p999 = percentile(result->latencies, result->pins, 0.999);
+
+    if (!json)
+    {
+        printf("strategy: %s\n", strategyNames[strategy]);
+        printf("workload: %s\n", workload);
+        printf("threads: %d\n", threads);
+        printf("frames: %d\n", frames);
+        printf("file_pages: %d\n", filePages);
+        printf("pins: %ld\n", result->pins);
+        printf("errors: %ld\n", result->errors);
+        printf("hit_rate: %.4f\n", hitRate);
+        printf("pins_per_sec: %.0f\n", (double)result->pins / result->seconds);
+        printf("pin_latency_p50_ns: %llu\n", (unsigned long long)p50);
+        printf("pin_latency_p99_ns: %llu\n", (unsigned long long)p99);
+        printf("pin_latency_p999_ns: %llu\n", (unsigned long long)p999);
+        printf("prefetch_hits: %lld\n", pool->prefetchHits);
+        printf("evictions: %lld\n", pool->evictions);
+        printf("dirty_evictions: %lld\n", pool->dirtyEvictions);
+        printf("io_stall_ns: %lld\n", pool->ioStallNanos);
+        printf("read_io: %lld\n", pool->readIO);
+        printf("write_io: %lld\n", pool->writeIO);
+        printf("compressed_hits: %lld\n", pool->compressedHits);
+        printf("compression_ratio: %.2f\n", pool->compressionRatio);
+        printf("scan_kernel: %s\n", scanKernelName());
+        printf("frame_pages: %s\n", framePageNames[pool->framePages]);
+        printf("frames_locked: %d\n", pool->framesLocked ? 1 : 0);
+        for (int kind = 0; latches && kind < BM_NUM_LATCH_KINDS; kind++)
+        {
+            const BM_LatchStats *latch = &result->latches[kind];
+            printf("latch_%s_acquisitions: %lld\n", latchNames[kind], latch->acquisitions);
+            printf("latch_%s_per_sec: %.0f\n", latchNames[kind], (double)latch->acquisitions / result->seconds);
+            printf("latch_%s_contended: %lld\n", latchNames[kind], latch->contended);
+            printf("latch_%s_wait_ns: %lld\n", latchNames[kind], latch->waitNanos);
+            printf("latch_%s_hold_ns: %lld\n", latchNames[kind], latch->holdNanos);
+        }
+        printf("\n");
+        return;
+    }
+
+    printf("{\"strategy\":\"%s\",\"workload\":\"%s\",\"threads\":%d,\"frames\":%d,\"file_pages\":%d,",
+           strategyNames[strategy], workload, threads, frames, filePages);
+    printf("\"pins\":%ld,\"errors\":%ld,\"hit_rate\":%.4f,\"pins_per_sec\":%.0f,", result->pins, result->errors,
+           hitRate, (double)result->pins / result->seconds);
+    printf("\"pin_latency_p50_ns\":%llu,\"pin_latency_p99_ns\":%llu,\"pin_latency_p999_ns\":%llu,",
+           (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)p999);
+    printf("\"prefetch_hits\":%lld,\"evictions\":%lld,\"dirty_evictions\":%lld,\"io_stall_ns\":%lld,",
+           pool->prefetchHits, pool->evictions, pool->dirtyEvictions, pool->ioStallNanos);
+    printf("\"read_io\":%lld,\"write_io\":%lld,", pool->readIO, pool->writeIO);
+    printf("\"compressed_hits\":%lld,\"compression_ratio\":%.2f,", pool->compressedHits, pool->compressionRatio);
+    printf("\"scan_kernel\":\"%s\",\"frame_pages\":\"%s\",\"frames_locked\":%d", scanKernelName(),
+           framePageNames[pool->framePages], pool->framesLocked ? 1 : 0);
+    if (latches)
+    {
+        printf(",\"latches\":{");
+        for (int kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+        {
+            const BM_LatchStats *latch = &result->latches[kind];
+            printf("%s\"%s\":{\"acquisitions\":%lld,\"per_sec\":%.0f,\"contended\":%lld,\"wait_ns\":%lld,\"hold_ns\":%lld}",
+                   kind > 0 ? "," : "", latchNames[kind], latch->acquisitions,
+                   (double)latch->acquisitions / result->seconds, latch->contended, latch->waitNanos,
+                   latch->holdNanos);
+        }
+        printf("}");
+    }
+    printf("}\n");
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: bench_buffer_mgr [options]\n"
+            "  -s strategy   fifo, lru, clock, lfu, lru-k, arc or 2q (lru)\n"
+            "  -f frames     frames of the pool (1000)\n"
+            "  -p pages      pages of the page file (10000)\n"
+            "  -n pins       number of pins (1000000, the length of the trace for -t)\n"
+            "  -w workload   uniform, zipf, scan or scan-hot (zipf)\n"
+            "  -z skew       Zipf exponent (0.99)\n"
+            "  -r ratio      fraction of pins that modify the page (0)\n"
+            "  -H fraction   hot set of scan-hot as a fraction of the pages (0.05)\n"
+            "  -m fraction   fraction of scan-hot pins that continue the scan (0.5)\n"
+            "  -t file       replay a trace file instead, lines of [r|w] pageNum\n"
+            "  -R file       record the pins of the pool to a trace file for sim_buffer_mgr, the last run is kept\n"
+            "  -a pages      read ahead window (0, off)\n"
+            "  -x shards     number of shards of the pool (1)\n"
+            "  -c pages      keep evicted clean pages compressed in a tier of this many pages (0, off)\n"
+            "  -b backend    stdio, mmap, direct or direct-threads (stdio)\n"
+            "  -g pages      memory pages of the frames: normal, thp, 2m or 1g (normal)\n"
+            "  -S seed       seed of the random generator (1)\n"
+            "  -T threads    sweep 1, 2, 4, ... up to this many threads on a profiled concurrent pool,\n"
+            "                0 for the number of online cores (off, one thread on a plain pool)\n"
+            "  -M mixes      sweep comma separated preset mixes instead of -w: hot, miss, write or all\n"
+            "  -O            pin hits without latches (optimisticHits)\n"
+            "  -L            lock the frames in memory (lockFrames)\n"
+            "  -P            fault the frames in at init (prefaultFrames)\n"
+            "  -j            print one JSON object per run instead of name: value lines\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Workload base = {0};
+    BM_PoolOptions options = {0};
+    ReplacementStrategy strategy = RS_LRU;
+    int frames = 1000;
+    long pins = -1;
+    uint64_t seed = 1;
+    const char *traceFile = NULL;
+    int maxThreads = -1;
+    bool mixes[NUM_MIXES] = {false};
+    bool useMixes = false;
+    bool json = false;
+    int opt;
+
+    base.kind = WL_ZIPF;
+    base.filePages = 10000;
+    base.skew = 0.99;
+    base.writeRatio = 0;
+    double hotFraction = 0.05;
+    base.scanFraction = 0.5;
+
+    while ((opt = getopt(argc, argv, "s:f:p:n:w:z:r:H:m:t:R:a:x:c:b:g:S:T:M:OLPj")) != -1)
+    {
+        int index;
+        switch (opt)
+        {
+        case 's':
+            if ((index = lookupName(optarg, strategyNames, 7)) < 0)
+            {
+                usage();
+                return 1;
+            }
+            strategy = (ReplacementStrategy)index;
+            break;
+        case 'f':
+            frames = atoi(optarg);
+            break;
+        case 'p':
+            base.filePages = atoi(optarg);
+            break;
+        case 'n':
+            pins = atol(optarg);
+            break;
+        case 'w':
+            if ((index = lookupName(optarg, workloadNames, 4)) < 0)
+            {
+                usage();
+                return 1;
+            }
+            base.kind = (WorkloadKind)index;
+            break;
+        case 'z':
+            base.skew = atof(optarg);
+            break;
+        case 'r':
+            base.writeRatio = atof(optarg);
+            break;
+        case 'H':
+            hotFraction = atof(optarg);
+            break;
+        case 'm':
+            base.scanFraction = atof(optarg);
+            break;
+        case 't':
+            traceFile = optarg;
+            break;
+        case 'R':
+            options.traceFile = optarg;
+            break;
+        case 'a':
+            options.readAheadPages = atoi(optarg);
+            break;
+        case 'x':
+            options.numShards = atoi(optarg);
+            break;
+        case 'c':
+            options.compressedTierPages = atoi(optarg);
+            break;
+        case 'b':
+            if ((index = lookupName(optarg, backendNames, 4)) < 0)
+            {
+                usage();
+                return 1;
+            }
+            options.storageBackend = (SM_Backend)index;
+            break;
+        case 'g':
+            if ((index = lookupName(optarg, framePageNames, 4)) < 0)
+            {
+                usage();
+                return 1;
+            }
+            options.framePages = (BM_FramePages)index;
+            break;
+        case 'S':
+            seed = strtoull(optarg, NULL, 10) | 1;
+            break;
+        case 'T':
+            maxThreads = atoi(optarg);
+            break;
+        case 'M':
+            if (!parseMixes(optarg, mixes))
+            {
+                usage();
+                return 1;
+            }
+            useMixes = true;
+            break;
+        case 'O':
+            options.optimisticHits = true;
+            break;
+        case 'L':
+            options.lockFrames = true;
+            break;
+        case 'P':
+            options.prefaultFrames = true;
+            break;
+        case 'j':
+            json = true;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if (traceFile != NULL)
+    {
+        PageNumber maxPage;
+        base.kind = WL_TRACE;
+        base.traceLength = readTrace(traceFile, &base.trace, &maxPage);
+        if (base.traceLength <= 0)
+        {
+            fprintf(stderr, "cannot read trace %s\n", traceFile);
+            return 1;
+        }
+        base.filePages = maxPage + 1;
+        if (pins < 0)
+            pins = base.traceLength;
+    }
+    if (pins < 0)
+        pins = 1000000;
+    if (maxThreads == 0)
+        maxThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    base.hotPages = (int)(hotFraction * base.filePages) > 0 ? (int)(hotFraction * base.filePages) : 1;
+    if (frames <= 0 || base.filePages <= 0 || pins <= 0 || (useMixes && traceFile != NULL) ||
+        (maxThreads < 0 && maxThreads != -1))
+    {
+        usage();
+        return 1;
+    }
+
+    // a sweep shares a concurrent pool between the threads and profiles its latches
+    if (maxThreads > 0)
+    {
+        options.concurrent = true;
+        options.profileLatches = true;
+    }
+    if (!useMixes)
+    {
+        // the given workload is swept as the only mix
+        mixes[0] = true;
+    }
+
+    BenchResult result = {0};
+    result.latencies = (uint64_t *)malloc(sizeof(uint64_t) * pins);
+    if (result.latencies == NULL)
+    {
+        fprintf(stderr, "cannot allocate the latencies of %ld pins\n", pins);
+        return 1;
+    }
+
+    for (int mix = 0; mix < NUM_MIXES; mix++)
+    {
+        if (!mixes[mix])
+            continue;
+
+        Workload wl = base;
+        wl.zipfCdf = NULL;
+        wl.rankPage = NULL;
+        if (useMixes)
+            applyMix(&wl, (MixKind)mix, frames);
+        if (prepareWorkload(&wl, seed) != 0)
+        {
+            fprintf(stderr, "cannot prepare the workload\n");
+            return 1;
+        }
+        const char *name = useMixes ? mixNames[mix] : traceFile != NULL ? traceFile : workloadNames[wl.kind];
+
+        // thread counts double up to the largest, which is run as well
+        for (int threads = 1; threads > 0;)
+        {
+            memset(&result.latches, 0, sizeof(result.latches));
+            result.errors = 0;
+            RC rc = runBench(&wl, frames, strategy, &options, threads, pins, seed, &result);
+            if (rc != RC_OK)
+            {
+                fprintf(stderr, "cannot set up the buffer pool: %s\n", errorMessage(rc));
+                return 1;
+            }
+            printResult(name, strategy, frames, wl.filePages, threads, options.profileLatches, json, &result);
+            fflush(stdout);
+
+            if (threads >= maxThreads)
+                threads = 0;
+            else
+                threads = 2 * threads < maxThreads ? 2 * threads : maxThreads;
+        }
+        free(wl.zipfCdf);
+        free(wl.rankPage);
+    }
+
+    free(result.latencies);
+    free(base.trace);
+    return 0;
+}
@@ -0,0 +1,504 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "buffer_compress.h"
+
+/*
+    # Pages are compressed with a byte oriented LZ77 coder in the manner of LZ4: a sequence is a token,
+      whose high nibble is the number of literals and whose low nibble is the length of the match
+      minus LZ_MIN_MATCH, the literals, a two byte little endian offset back to the match and the
+      extensions of both lengths, 15 in the nibble followed by bytes that are added until one is not 255.
+    # The last sequence only has literals and ends the input. Matches are found with a hash table of
+      the positions of the last four bytes seen at each hash, so compressing is one pass over the page.
+*/
+
+// shortest match that is coded as one
+#define LZ_MIN_MATCH 4
+// farthest a match can be behind the bytes it replaces
+#define LZ_MAX_OFFSET 65535
+// the hash table has 2^LZ_HASH_BITS positions
+#define LZ_HASH_BITS 12
+
+/*
+    # The arena of the tier is a log. Pages are appended at head, a logical position that only grows,
+      to byte head % capacity of the arena, a page that does not fit before the end of the arena
+      starts at the next lap. Appending overwrites the oldest pages, which are dropped first, so the
+      tier forgets pages in the order they were evicted from the frames.
+    # The entries of the pages are found through a hash table. A hit takes the page out of the tier,
+      the frame holds it from then on, and its bytes are reclaimed when the log comes round to them.
+    # The pool reserves the entry of a page under its page table latch while it evicts the page, and
+      fills it in after compressing the page outside that latch. A miss that finds the entry still
+      reserved cancels it and reads the page from the page file, so the tier never holds a page
+      that is also in a frame, which might be changed and written.
+    # One latch protects all of it, only the compression runs outside. The statistics are updated
+      under the latch with atomic adds and read without it.
+*/
+
+// the tier has an entry for every TIER_BYTES_PER_ENTRY bytes of its arena
+#define TIER_BYTES_PER_ENTRY 256
+// a page is only kept if it compresses to at most pageSize - pageSize / TIER_MIN_SAVING bytes
+#define TIER_MIN_SAVING 8
+
+// states of an entry
+#define ENTRY_FREE 0      // on the free list
+#define ENTRY_RESERVED 1  // reserved for a page being evicted, in the hash table but not in the log
+#define ENTRY_CANCELLED 2 // reserved but taken out of the hash table again, the fill frees it
+#define ENTRY_STORED 3    // holds a compressed page, in the hash table and in the log
+#define ENTRY_DEAD 4      // taken out of the hash table, in the log until its bytes are reclaimed
+
+typedef struct TierEntry
+{
+    int file;
+    PageNumber pageNum;
+    int state;
+    int next;       // next entry of the same hash bucket or of the free list
+    uint64_t start; // logical position of the compressed page in the log
+    int length;     // bytes of the compressed page
+} TierEntry;
+
+struct BM_CompressedTier
+{
+    char *arena;
+    size_t capacity;      // bytes of the arena
+    int pageSize;
+    TierEntry *entries;
+    int numEntries;
+    int freeEntries;      // first entry of the free list
+    int *buckets;         // hash table of the reserved and stored entries
+    int bucketMask;       // number of buckets minus one, a power of two
+    int *log;             // ring of the entries in the log, oldest first
+    int logFirst;         // position of the oldest entry in log
+    int logCount;         // number of entries in the log
+    uint64_t head;        // logical position the next page is appended at
+    pthread_mutex_t latch;
+    long long hits;       // pages taken out of the tier
+    long long misses;     // lookups that did not find a stored page
+    long long stores;     // pages stored
+    long long rejects;    // pages that did not compress well enough
+    long long pages;      // pages stored now
+    long long bytes;      // bytes those pages take in the arena
+};
+
+// Page Compression
+
+static uint32_t lzHash(const uint8_t *p)
+{
+    uint32_t sequence;
+    memcpy(&sequence, p, sizeof(sequence));
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// appends the extension bytes of a length of at least 15
+static void lzPutLength(uint8_t *dst, int *op, int length)
+{
+    for (length -= 15; length >= 255; length -= 255)
+    {
+        dst[(*op)++] = 255;
+    }
+    dst[(*op)++] = (uint8_t)length;
+}
+
+/*
+    # Appends a sequence of literals literals and a match of matchLength bytes at offset, matchLength 0
+      for the last sequence. Returns false if it does not fit into capacity.
+*/
+static bool lzPutSequence(uint8_t *dst, int *op, int capacity, const uint8_t *literals, int numLiterals,
+                          int offset, int matchLength)
+{
+    // token, both length extensions and the offset
+    int worst = 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchLength / 255 + 1;
+    if (worst > capacity - *op)
+    {
+        return false;
+    }
+
+    int matchCode = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    dst[(*op)++] = (uint8_t)((numLiterals < 15 ? numLiterals : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    if (numLiterals >= 15)
+    {
+        lzPutLength(dst, op, numLiterals);
+    }
+    memcpy(dst + *op, literals, numLiterals);
+    *op += numLiterals;
+
+    if (matchLength > 0)
+    {
+        dst[(*op)++] = (uint8_t)(offset & 0xff);
+        dst[(*op)++] = (uint8_t)(offset >> 8);
+        if (matchCode >= 15)
+        {
+            lzPutLength(dst, op, matchCode);
+        }
+    }
+    return true;
+}
+
+// compresses size bytes of src into dst, returns the compressed size or 0 if it is larger than capacity
+static int lzCompress(const uint8_t *src, int size, uint8_t *dst, int capacity)
+{
+    int table[1 << LZ_HASH_BITS];
+    int anchor = 0;
+    int ip = 0;
+    int op = 0;
+
+    memset(table, 0xff, sizeof(table));
+    while (ip + LZ_MIN_MATCH <= size)
+    {
+        uint32_t h = lzHash(src + ip);
+        int ref = table[h];
+        table[h] = ip;
+        if (ref < 0 || ip - ref > LZ_MAX_OFFSET || memcmp(src + ref, src + ip, LZ_MIN_MATCH) != 0)
+        {
+            ip++;
+            continue;
+        }
+
+        // the match is extended eight bytes at a time, then byte by byte
+        int length = LZ_MIN_MATCH;
+        while (ip + length + 8 <= size && memcmp(src + ref + length, src + ip + length, 8) == 0)
+        {
+            length += 8;
+        }
+        while (ip + length < size && src[ref + length] == src[ip + length])
+        {
+            length++;
+        }
+        if (!lzPutSequence(dst, &op, capacity, src + anchor, ip - anchor, ip - ref, length))
+        {
+            return 0;
+        }
+        ip += length;
+        anchor = ip;
+    }
+
+    if (!lzPutSequence(dst, &op, capacity, src + anchor, size - anchor, 0, 0))
+    {
+        return 0;
+    }
+    return op;
+}
+
+// reads the extension bytes of a length, returns false if the input ends first
+static bool lzGetLength(const uint8_t *src, int size, int *ip, int *length)
+{
+    int b;
+    do
+    {
+        if (*ip >= size)
+        {
+            return false;
+        }
+        b = src[(*ip)++];
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+// decompresses size bytes of src into dst, returns false unless they give exactly capacity bytes
+static bool lzDecompress(const uint8_t *src, int size, uint8_t *dst, int capacity)
+{
+    int ip = 0;
+    int op = 0;
+
+    while (ip < size)
+    {
+        int token = src[ip++];
+        int numLiterals = token >> 4;
+        if ((numLiterals == 15 && !lzGetLength(src, size, &ip, &numLiterals)) || numLiterals > size - ip ||
+            numLiterals > capacity - op)
+        {
+            return false;
+        }
+        memcpy(dst + op, src + ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        // the last sequence has no match
+        if (ip == size)
+        {
+            break;
+        }
+        if (size - ip < 2)
+        {
+            return false;
+        }
+        int offset = src[ip] | src[ip + 1] << 8;
+        ip += 2;
+        int length = token & 15;
+        if (length == 15 && !lzGetLength(src, size, &ip, &length))
+        {
+            return false;
+        }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || length > capacity - op)
+        {
+            return false;
+        }
+        // a match closer than its length repeats the last offset bytes, copied in chunks that stay a
+        // multiple of offset long, so every chunk only reads bytes written before
+        for (int done = 0; done < length;)
+        {
+            int chunk = done == 0 ? offset : done;
+            if (chunk > length - done)
+            {
+                chunk = length - done;
+            }
+            memcpy(dst + op + done, dst + op - offset, chunk);
+            done += chunk;
+        }
+        op += length;
+    }
+    return op == capacity;
+}
+
+// Compressed Tier
+
+static int bucketOf(BM_CompressedTier *tier, int file, PageNumber pageNum)
+{
+    return (int)(((unsigned)pageNum * 2654435761u ^ (unsigned)file * 40503u) & (unsigned)tier->bucketMask);
+}
+
+// returns the reserved or stored entry of the page, BM_NO_TIER_ENTRY if there is none
+static int findEntry(BM_CompressedTier *tier, int file, PageNumber pageNum)
+{
+    int id = tier->buckets[bucketOf(tier, file, pageNum)];
+    while (id != BM_NO_TIER_ENTRY && (tier->entries[id].pageNum != pageNum || tier->entries[id].file != file))
+    {
+        id = tier->entries[id].next;
+    }
+    return id;
+}
+
+static void freeEntry(BM_CompressedTier *tier, int id)
+{
+    tier->entries[id].state = ENTRY_FREE;
+    tier->entries[id].next = tier->freeEntries;
+    tier->freeEntries = id;
+}
+
+/*
+    # Takes an entry out of the hash table: a reserved one is cancelled and a stored one is dead
+      from then on, its bytes stay in the log until they are reclaimed.
+*/
+static void removeEntry(BM_CompressedTier *tier, int id)
+{
+    TierEntry *entry = &tier->entries[id];
+    int *link = &tier->buckets[bucketOf(tier, entry->file, entry->pageNum)];
+
+    while (*link != id)
+    {
+        link = &tier->entries[*link].next;
+    }
+    *link = entry->next;
+
+    if (entry->state == ENTRY_RESERVED)
+    {
+        entry->state = ENTRY_CANCELLED;
+        return;
+    }
+    entry->state = ENTRY_DEAD;
+    __atomic_fetch_add(&tier->pages, -1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&tier->bytes, -entry->length, __ATOMIC_RELAXED);
+}
+
+// drops the oldest entry of the log, a page that is still stored in it is lost
+static void dropOldest(BM_CompressedTier *tier)
+{
+    int id = tier->log[tier->logFirst];
+
+    tier->logFirst = (tier->logFirst + 1) % tier->numEntries;
+    tier->logCount--;
+    if (tier->entries[id].state == ENTRY_STORED)
+    {
+        removeEntry(tier, id);
+    }
+    freeEntry(tier, id);
+}
+
+BM_CompressedTier *compressedTierCreate(size_t capacity, int pageSize)
+{
+    BM_CompressedTier *tier = (BM_CompressedTier *)calloc(1, sizeof(BM_CompressedTier));
+    if (tier == NULL)
+    {
+        return NULL;
+    }
+
+    int buckets = 1;
+    tier->capacity = capacity;
+    tier->pageSize = pageSize;
+    tier->numEntries = (int)(capacity / TIER_BYTES_PER_ENTRY) + 1;
+    while (buckets < 2 * tier->numEntries)
+    {
+        buckets <<= 1;
+    }
+    tier->bucketMask = buckets - 1;
+    tier->arena = (char *)malloc(capacity);
+    tier->entries = (TierEntry *)malloc(sizeof(TierEntry) * tier->numEntries);
+    tier->buckets = (int *)malloc(sizeof(int) * buckets);
+    tier->log = (int *)malloc(sizeof(int) * tier->numEntries);
+    pthread_mutex_init(&tier->latch, NULL);
+    if (tier->arena == NULL || tier->entries == NULL || tier->buckets == NULL || tier->log == NULL)
+    {
+        compressedTierDestroy(tier);
+        return NULL;
+    }
+
+    for (int i = 0; i < buckets; i++)
+    {
+        tier->buckets[i] = BM_NO_TIER_ENTRY;
+    }
+    tier->freeEntries = BM_NO_TIER_ENTRY;
+    for (int i = tier->numEntries - 1; i >= 0; i--)
+    {
+        freeEntry(tier, i);
+    }
+    return tier;
+}
+
+int compressedTierReserve(BM_CompressedTier *tier, int file, PageNumber pageNum)
+{
+    pthread_mutex_lock(&tier->latch);
+
+    // a page is only evicted while it is in a frame, so it has no entry unless the pool lost track of it
+    int id = findEntry(tier, file, pageNum);
+    if (id != BM_NO_TIER_ENTRY)
+    {
+        removeEntry(tier, id);
+    }
+
+    // the oldest pages give up their entries, reserved ones are not in the log and cannot
+    while (tier->freeEntries == BM_NO_TIER_ENTRY && tier->logCount > 0)
+    {
+        dropOldest(tier);
+    }
+    id = tier->freeEntries;
+    if (id != BM_NO_TIER_ENTRY)
+    {
+        TierEntry *entry = &tier->entries[id];
+        int bucket = bucketOf(tier, file, pageNum);
+
+        tier->freeEntries = entry->next;
+        entry->file = file;
+        entry->pageNum = pageNum;
+        entry->state = ENTRY_RESERVED;
+        entry->next = tier->buckets[bucket];
+        tier->buckets[bucket] = id;
+    }
+
+    pthread_mutex_unlock(&tier->latch);
+    return id;
+}
+
+void compressedTierFill(BM_CompressedTier *tier, int entry, const char *page)
+{
+    uint8_t *compressed = (uint8_t *)malloc(tier->pageSize);
+    int length = 0;
+
+    if (compressed != NULL)
+    {
+        length = lzCompress((const uint8_t *)page, tier->pageSize, compressed,
+                            tier->pageSize - tier->pageSize / TIER_MIN_SAVING);
+    }
+
+    pthread_mutex_lock(&tier->latch);
+    TierEntry *e = &tier->entries[entry];
+    // a page that is not kept is cancelled like one a miss asked for in the meantime
+    if (e->state == ENTRY_RESERVED && length == 0)
+    {
+        removeEntry(tier, entry);
+        __atomic_fetch_add(&tier->rejects, 1, __ATOMIC_RELAXED);
+    }
+    if (e->state == ENTRY_CANCELLED)
+    {
+        freeEntry(tier, entry);
+        pthread_mutex_unlock(&tier->latch);
+        free(compressed);
+        return;
+    }
+
+    // a page that does not fit before the end of the arena starts at the next lap
+    size_t offset = (size_t)(tier->head % tier->capacity);
+    if (offset + length > tier->capacity)
+    {
+        tier->head += tier->capacity - offset;
+        offset = 0;
+    }
+    // the pages whose bytes are overwritten are dropped
+    while (tier->logCount > 0 && tier->entries[tier->log[tier->logFirst]].start + tier->capacity < tier->head + length)
+    {
+        dropOldest(tier);
+    }
+
+    memcpy(tier->arena + offset, compressed, length);
+    e->start = tier->head;
+    e->length = length;
+    e->state = ENTRY_STORED;
+    tier->log[(tier->logFirst + tier->logCount) % tier->numEntries] = entry;
+    tier->logCount++;
+    tier->head += length;
+    __atomic_fetch_add(&tier->stores, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&tier->pages, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&tier->bytes, length, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&tier->latch);
+    free(compressed);
+}
+
+bool compressedTierTake(BM_CompressedTier *tier, int file, PageNumber pageNum, char *page)
+{
+    pthread_mutex_lock(&tier->latch);
+
+    // the arena may be overwritten as soon as the latch is released, so the page is decompressed under it
+    int id = findEntry(tier, file, pageNum);
+    bool found = id != BM_NO_TIER_ENTRY && tier->entries[id].state == ENTRY_STORED &&
+                 lzDecompress((const uint8_t *)tier->arena + tier->entries[id].start % tier->capacity,
+                              tier->entries[id].length, (uint8_t *)page, tier->pageSize);
+    if (id != BM_NO_TIER_ENTRY)
+    {
+        removeEntry(tier, id);
+    }
+    __atomic_fetch_add(found ? &tier->hits : &tier->misses, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&tier->latch);
+    return found;
+}
+
+void compressedTierDropFile(BM_CompressedTier *tier, int file)
+{
+    pthread_mutex_lock(&tier->latch);
+    for (int id = 0; id < tier->numEntries; id++)
+    {
+        TierEntry *entry = &tier->entries[id];
+        if ((entry->state == ENTRY_RESERVED || entry->state == ENTRY_STORED) && entry->file == file)
+        {
+            removeEntry(tier, id);
+        }
+    }
+    pthread_mutex_unlock(&tier->latch);
+}
+
+void compressedTierStats(BM_CompressedTier *tier, BM_PoolStats *stats)
+{
+    stats->compressedHits = __atomic_load_n(&tier->hits, __ATOMIC_RELAXED);
+    stats->compressedMisses = __atomic_load_n(&tier->misses, __ATOMIC_RELAXED);
+    stats->compressedStores = __atomic_load_n(&tier->stores, __ATOMIC_RELAXED);
+    stats->compressedRejects = __atomic_load_n(&tier->rejects, __ATOMIC_RELAXED);
+    stats->compressedPages = __atomic_load_n(&tier->pages, __ATOMIC_RELAXED);
+    stats->compressedBytes = __atomic_load_n(&tier->bytes, __ATOMIC_RELAXED);
+    stats->compressedCapacity = (long long)tier->capacity;
+    stats->compressionRatio = stats->compressedBytes > 0
+                                  ? (double)stats->compressedPages * tier->pageSize / stats->compressedBytes
+                                  : 0;
+}
+
+void compressedTierDestroy(BM_CompressedTier *tier)
+{
+    pthread_mutex_destroy(&tier->latch);
+    free(tier->arena);
+    free(tier->entries);
+    free(tier->buckets);
+    free(tier->log);
+    free(tier);
+}
@@ -0,0 +1,43 @@
+#ifndef BUFFER_COMPRESS_H
+#define BUFFER_COMPRESS_H
+
+#include <stddef.h>
+
+// Include the buffer pool types
+#include "buffer_mgr.h"
+
+/*
+    # The compressed tier of a pool created with the compressedTierPages option keeps clean pages
+      evicted from the frames in an arena, compressed, so a later miss of one of them decompresses it
+      instead of reading it from the page file.
+    # Pages are compressed with the LZ77 coder of buffer_compress.c, a page that does not shrink by
+      at least an eighth is not kept.
+*/
+
+// returned by compressedTierReserve when the tier has no entry to spare
+#define BM_NO_TIER_ENTRY -1
+
+typedef struct BM_CompressedTier BM_CompressedTier;
+
+// Creates a tier of capacity bytes for pages of pageSize, capacity is at least pageSize, returns NULL on failure
+BM_CompressedTier *compressedTierCreate(size_t capacity, int pageSize);
+
+// Reserves the entry of a page that is being evicted, returns BM_NO_TIER_ENTRY if none is free
+int compressedTierReserve(BM_CompressedTier *tier, int file, PageNumber pageNum);
+
+// Compresses the page of a reserved entry into the tier, dropping the oldest pages to make room
+void compressedTierFill(BM_CompressedTier *tier, int entry, const char *page);
+
+// Takes a page out of the tier, decompressing it into page, returns false if the tier does not hold it
+bool compressedTierTake(BM_CompressedTier *tier, int file, PageNumber pageNum, char *page);
+
+// Drops all pages of a file, reserved ones included
+void compressedTierDropFile(BM_CompressedTier *tier, int file);
+
+// Fills in the compressed tier statistics of stats, without taking the latch of the tier
+void compressedTierStats(BM_CompressedTier *tier, BM_PoolStats *stats);
+
+// Frees the tier, no other call may still be running
+void compressedTierDestroy(BM_CompressedTier *tier);
+
+#endif
@@ -1,740 +1,3999 @@
+// getcpu
+#define _GNU_SOURCE
+
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "buffer_mgr.h"
+#include "buffer_policy.h"
+#include "buffer_trace.h"
+#include "buffer_compress.h"
+#include "buffer_scan.h"
 #include "storage_mgr.h"
 
-typedef struct PageFrame
+/*
+    # Frames are identified by their index in the buffer pool.
+    # The data of frame i lives at frameData + i * pageSize inside one aligned slab and its
+      metadata is stored at index i of dense parallel arrays, so scans over the frames walk
+      memory sequentially instead of chasing list pointers.
+    # The slab of each shard is an anonymous mapping, which starts out zero and only takes
+      memory for the frames that are touched. With the framePages option it is mapped from
+      hugetlb pages of 1 GB or 2 MB or from transparent huge pages, each kind falling back to the
+      next smaller one when the system cannot give it, down to normal pages (see mapFrameSlab).
+    # lockFrames locks the whole slab with mlock, which also faults it in, and prefaultFrames
+      touches the memory of the frames in use, so the first pin of a frame does not fault.
+*/
+
+// alignment of the frame slab, that of memory pages and of the buffers of O_DIRECT
+#define FRAME_ALIGNMENT 4096
+// log2 of the sizes of the hugetlb pages the frames can be mapped from, 2 MB pages are also the
+// size of transparent huge pages
+#define HUGE_2MB_SHIFT 21
+#define HUGE_1GB_SHIFT 30
+
+// state of the page held by a frame
+#define FRAME_EMPTY 0   // no page, or loading the last page failed
+#define FRAME_LOADING 1 // a thread is reading the page from disk, other pinners wait for it
+#define FRAME_VALID 2   // the frame holds the page
+
+/*
+    # Concurrency control, used when the pool is created with the concurrent option:
+    # tableLatch is a reader/writer latch over the page table and the replacement state.
+      Buffer hits, unpins and dirty marks only take it shared, loading or evicting a page takes it exclusive.
+    # frameLatches serialise the disk I/O of each frame, the disk read of a missing page happens
+      under the frame latch only, pinners of a page that is still loading wait on frameLoaded.
+    # fileLatch serialises adding pages to the files and opening or closing files. Reads and writes of existing pages use positional
+      I/O and run without it, except with the mmap backend, which maps chunks of the file on first use.
+    # replacementLatch serialises the onHit calls of replacement policies that do not handle
+      concurrent hits themselves, as those pinners only hold the page table latch shared.
+    # Fix counts, dirty flags, reference bits and the I/O counters are updated atomically.
+    # With the optimisticHits option a hit takes no latch at all: the page table is walked with
+      atomic loads, the fix count is incremented atomically and the pin is validated against the
+      version of the frame (see pinOptimistic). The version is odd while the page of the frame
+      changes, so pinners see either the old or the new page, never a mix.
+    # A frame is only given to another page after its fix count was changed from 0 to 1 with a
+      compare and swap, which fails if an optimistic pinner got to the frame first.
+*/
+#define ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define ATOMIC_ADD(ptr, value) __atomic_add_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+#define ATOMIC_EXCHANGE(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_ACQ_REL)
+
+/*
+    # The page cleaner, started with the backgroundFlush option, is a thread that writes dirty
+      unpinned frames back once dirtyCount reaches cleanerThreshold, until at most half of that
+      is left, so that a pin that misses rarely has to write a victim itself.
+    # It writes the frames in batches of at most a BACKGROUND_PIN_SHARE of the frames, which it keeps
+      pinned while they are written, so pins that miss meanwhile still find a victim in a small pool.
+    # It sleeps on cleanerWake, which markDirty signals when the threshold is reached.
+*/
+
+// default fraction of dirty frames at which the page cleaner starts
+#define DEFAULT_DIRTY_RATIO 0.25
+// wait before the cleaner looks again when all dirty pages were pinned
+#define CLEANER_RETRY_MS 10
+// the page cleaner and the warm thread pin at most 1 / BACKGROUND_PIN_SHARE of the frames at once
+#define BACKGROUND_PIN_SHARE 4
+// times closing a file waits CLEANER_RETRY_MS for the page cleaner to drop its pins of the file
+#define CLOSE_FILE_RETRIES 10
+
+/*
+    # Flushes and the page cleaner collect the dirty frames first and write them back sorted by
+      page number, each run of adjacent pages with one vectored write, and several runs together
+      with submitBlocks, which the direct storage backends keep in flight at once (see writeBackFrames).
+*/
+
+// a dirty frame collected for a batched write back
+typedef struct FlushEntry
+{
+    int file;
+    PageNumber pageNum;
+    int frame;
+} FlushEntry;
+
+// longest run of adjacent pages written with one request
+#define MAX_WRITE_RUN 64
+// most runs handed to the storage manager at once with submitBlocks
+#define MAX_WRITE_BATCH 16
+
+/*
+    # Read ahead, enabled with the readAheadPages option, reads the pages following a miss that
+      continues a sequential scan together with the missing page, so a scan reads the file in
+      large batches instead of one page per call.
+    # The window starts at READ_AHEAD_MIN_PAGES and doubles with every further sequential miss,
+      up to readAheadMax, which is at most half the pool. Read ahead and prefetchPages only use
+      free or clean frames, they never write back a page to make room.
+*/
+
+// first read ahead window of a sequential scan
+#define READ_AHEAD_MIN_PAGES 4
+// most pages read with one call to submitBlocks
+#define MAX_READ_RUN 64
+
+/*
+    # With the numShards option the frames are split into shards, each with its own page table,
+      replacement state, latches, I/O counters and page cleaner, so pins of pages in different
+      shards never meet on a latch or a replacement cursor.
+    # A page always lives in the shard picked by a hash of its extent, the SHARD_EXTENT_PAGES pages
+      around it, so runs of adjacent pages still land in one shard and are read and written together.
+    # The first shard is the root, it holds the page files with the file latch, the read ahead state
+      and the statistics arrays, which give the pooled view of all shards one after the other.
+    # A pool without the option is a root that is its only shard.
+*/
+
+// number of adjacent pages that always share a shard
+#define SHARD_EXTENT_PAGES 16
+
+/*
+    # A pool created with the maxPages option can be resized by resizeBufferPool while it is in use.
+      Every shard allocates the metadata of maxFrames frames and the slab for their data up front,
+      numFrames of them are in use. Pins hold pointers into the slab and optimistic pinners walk the
+      frame arrays without latches, so neither is ever moved.
+    # The frames past numFrames hold no page and keep a fix count of 1, so no replacement policy picks
+      them and every claim of them fails. The free frames of a shard are always those from
+      occupiedFrameCount to numFrames - 1, as frames are filled in order and only a resize empties them.
+    # Only the part of the slab in use is touched, and the memory pages of the frames a resize gives up
+      are handed back to the kernel, which zeroes them when they are used again.
+*/
+
+/*
+    # With the numaPlacement option the frame slab of every shard is bound to a NUMA node, the
+      shards going round robin over the online nodes, and extents are not hashed to a shard:
+      the first thread that uses an extent places it in a shard of its own node (see placedShardOf).
+      A workload whose threads each work on their own pages then pins local memory only.
+    # The placement of the extents is kept in extentShards, which covers twice the pages the file
+      had when the pool was opened, extents beyond that and those of files opened by openPoolFile
+      are hashed as without the option.
+    # Pins of a page in a shard of another node than that of the pinning thread are counted.
+*/
+
+/*
+    # A pool caches the pages of up to maxFiles page files, the one it was created with and those
+      opened by openPoolFile. All of them share the frames and the replacement policy of the pool,
+      so the frames go to the pages of whichever files are used most.
+    # The files are kept in a registry in the root, the slot of a file is its fileId. Frame i holds
+      page pageNums[i] of file fileIds[i], the page table, the shards and read ahead work on both,
+      the replacement policies are given pageKeyOf them (see buffer_policy.h).
+    # A slot is only reused once every page of the file it held was written back and evicted, so
+      no frame refers to a file that is closed.
+*/
+
+// a page file of the pool
+typedef struct PoolFile
+{
+    SM_FileHandle handle;           // open while the slot is in use
+    char *name;                     // name of the file, the pageFile of its handle, which owns it
+    BM_BufferPool *pool;            // handle of the file, whose numPages resizeBufferPool keeps up to date
+    bool open;                      // the slot holds a file, changed under the file latch
+    int readAheadWindow;            // current read ahead window, 0 until a sequential scan is detected
+    PageNumber nextSequentialPage;  // page a miss has to ask for to continue the sequential scan
+} PoolFile;
+
+/*
+    # With the compressedTierPages option the root keeps a compressed tier (see buffer_compress.c)
+      that all shards share. A clean page that assignFrame takes a frame from gets an entry reserved
+      under the page table latch, and the thread loading the frame compresses the page into it under
+      the frame latch before the frame is overwritten, so no page table latch is held while pages
+      are compressed.
+    # Every load of a page, by a miss, read ahead, prefetchPages, pinPages or the hot set, takes it
+      out of the tier if it is there instead of reading it, so a page is never in a frame and the
+      tier at once and the tier only holds pages the page file has in the same state.
+*/
+
+// most NUMA nodes a pool spreads its shards over
+#define MAX_NUMA_NODES 64
+// extents of extentShards beyond those of the page file when the pool is opened
+#define MIN_PLACED_EXTENTS 4096
+// extent not placed in a shard yet
+#define NO_SHARD -1
+// mbind policy binding memory to the given nodes, as in <numaif.h>
+#define NUMA_MPOL_BIND 2
+
+/*
+    # With the profileLatches option every latch helper below counts its acquisitions and times
+      the wait for and the hold of the latch, in latchStats of the shard the latch belongs to. A latch
+      that is free is taken with a try lock first, so only contended acquisitions read the clock twice.
+    # The hold of a frame latch does not include the time its holder waits on frameLoaded, during
+      which the latch is released.
+    # The file latch is counted in the root and only the wake up of the page cleaner is profiled
+      of the cleaner latch, as the cleaner sleeps holding it.
+*/
+
+// a thread never holds more than one page table latch, so when and how it got it is kept per thread
+static __thread long long tableLatchedAt;
+static __thread BM_LatchKind tableLatchedKind;
+
+/*
+    # The statistics of getPoolStats are kept in STAT_SLOTS slots in the root, each on cache lines
+      of its own. A thread always updates the same slot, handed out round robin the first time it
+      counts something, so threads only share a slot when there are more of them than slots.
+      getPoolStats sums up the slots without stopping the threads that update them.
+    # Concurrent pools update the slots with relaxed atomic adds, which do not order anything else.
+    # Latencies go into log2 buckets, see BM_Histogram. Disk I/O is always timed, pins only with
+      the timePins option, as that costs two clock reads on every hit.
+*/
+#define STAT_SLOTS 16
+// size of a cache line, slots start on one of their own
+#define STAT_SLOT_ALIGNMENT 64
+
+// counters of a statistics slot
+#define STAT_HITS 0
+#define STAT_MISSES 1
+#define STAT_PREFETCH_HITS 2
+#define STAT_EVICTIONS 3
+#define STAT_DIRTY_EVICTIONS 4
+#define STAT_IO_STALL_NANOS 5
+#define NUM_STATS 6
+
+// histograms of a statistics slot
+#define HISTOGRAM_PIN 0
+#define HISTOGRAM_READ 1
+#define HISTOGRAM_WRITE 2
+#define NUM_HISTOGRAMS 3
+
+// the statistics updated by the threads using one slot
+typedef struct StatSlot
+{
+    long long counts[NUM_STATS];
+    BM_Histogram histograms[NUM_HISTOGRAMS];
+} __attribute__((aligned(STAT_SLOT_ALIGNMENT))) StatSlot;
+
+// slot of the calling thread, -1 until it first counts something
+static __thread int statSlotOfThread = -1;
+// slot handed to the next thread
+static int nextStatSlot;
+
+/*
+    # With the hotSetFile option every pin of a resident page counts a use of its frame and notes
+      when it happened, a load counting as the first use. saveHotSet, shutdownBufferPool and the
+      checkpoints of checkpointSeconds write the resident pages with their uses and idle times to
+      the file, and a pool created with the option reads the file before it returns.
+    # The pages are ranked by their uses, then by how recently they were used, and every shard takes
+      the best ranked pages of its own until its frames are full. They are read sorted by page number
+      into free frames only, every run of adjacent pages with one request (see warmShard), so a pool
+      that already serves pins never loses a page to them. Their first hits count as prefetch hits.
+    # warmInBackground leaves the reads to the warm thread of the pool, which also writes the
+      checkpoints. Both need a concurrent pool, otherwise the hot set is read before initBufferPool
+      returns and only saved by saveHotSet and shutdownBufferPool.
+    # The file is written under another name first and renamed, so a crash during a save keeps the
+      previous hot set.
+*/
+#define HOT_SET_MAGIC "BMHOTSET"
+// appended to the name of the file while the hot set is written
+#define HOT_SET_TMP_SUFFIX ".tmp"
+
+typedef struct HotSetHeader
+{
+    char magic[8];       // HOT_SET_MAGIC without its terminating zero
+    uint32_t entrySize;  // sizeof(HotSetEntry)
+    uint32_t numEntries;
+} HotSetHeader;
+
+// a resident page at the time the hot set was saved, the most recently used first
+typedef struct HotSetEntry
 {
-    int frameNum;                  // number associated with each Page frame
-    int pageNum;                   // Page Number of the Page present in the Page frame
-    int dirtyFlagSignal;           // determine if page was modified or not
-    int fixCount;                  // Fix count to mark whether the page is in use by other users
-    int referenceBit;              // Reference bit used in CLOCK Algorithm to mark the page which is referred
-    char *data;                    // Actual data present in the page
-    struct pageFrame *next, *prev; // Nodes of the Doubly linked List where each node is a frame, pointing to other frames
-} PageFrame;
+    int32_t pageNum;
+    uint32_t uses;       // pins since the page was loaded, including the load
+    int64_t idleNanos;   // time since the last of them
+} HotSetEntry;
 
 /*Structure for Buffer Pool to store Management Information*/
 typedef struct BM_BufferPool_Mgmt
 {
     int occupiedFrameCount;         // to keep count of number of frames occupied inside the pool
     void *replacementData;          // to pass parameters for page replacement strategies
-    PageFrame *head, *tail, *start; // keep track of nodes in linked list
+    char *frameData;                // one aligned slab holding the page data of all frames
+    size_t frameBytes;              // length of the mapping of frameData
+    size_t frameMemPageSize;        // size of the memory pages frameData is mapped from
+    BM_FramePages framePages;       // kind of memory pages frameData is mapped from
+    bool framesLocked;              // frameData is locked in memory
+    BM_FramePages wantedFramePages; // the framePages option, root only
+    bool lockFrames;                // the lockFrames option, root only
+    bool prefaultFrames;            // the prefaultFrames option, root only
+    PageNumber *pageNums;           // page number of the page present in each frame, NO_PAGE if empty
+    int *fileIds;                   // file of the page present in each frame
+    int *fixCounts;                 // fix count of each frame to mark whether the page is in use by other users
+    bool *dirtyFlags;               // determine if the page in each frame was modified or not
+    int *frameStates;               // FRAME_EMPTY, FRAME_LOADING or FRAME_VALID for each frame
+    int head;                       // next free frame while the pool fills up
     PageNumber *frameContent;       // an array of page numbers to store the statistics of number of pages stored in the page frame
     int *fixCount;                  // an array of integers to store the statistics of fix counts for a page
     bool *markDirty;                // an array of bool's to store the statistics of dirty bits for modified page
     int getNumReadIO;               // to give total number of pages read from the buffer pool
     int getNumWriteIO;              // to give total number of pages wrote into the buffer pool
+    int *pageTable;                 // hash table mapping resident page numbers to their frames
+    int *hashNext;                  // next frame in the same page table bucket
+    int pageTableMask;              // number of buckets in the page table minus one (bucket count is a power of two)
+    PoolFile *files;                // registry of the page files, file 0 is kept open for the lifetime of the pool, root only
+    int maxFiles;                   // number of slots of the registry, root only
+    SM_Backend backend;             // storage backend the page files are opened with, root only
+    bool mappedStorage;             // the page file uses SM_BACKEND_MMAP, read only pins may point into it
+    bool parallelIO;                // the storage backend allows reads and writes without the file latch
+    int pageSize;                   // size of the pages of the page file and of the frames
+    bool concurrent;                // the latches below are only used when the pool is shared between threads
+    bool optimisticHits;            // hits are pinned without the page table latch, see pinOptimistic
+    unsigned *frameVersions;        // incremented before and after the page of a frame changes
+    pthread_rwlock_t tableLatch;    // protects the page table and the replacement state
+    pthread_mutex_t *frameLatches;  // one latch per frame held during its disk I/O
+    pthread_cond_t *frameLoaded;    // signalled when a frame leaves FRAME_LOADING
+    pthread_mutex_t fileLatch;      // serialises access to the storage manager, used in the root
+    pthread_mutex_t replacementLatch; // serialises policy updates of buffer hits under the shared page table latch
+    const BM_ReplacementPolicy *policy; // replacement policy of the strategy the pool was created with
+    void *policyState;              // state of the policy for this pool
+    int numFrames;                  // number of frames of this shard in use, numPages of the pool if it has one shard
+    int maxFrames;                  // number of frames allocated for this shard, see resizeBufferPool
+    int maxPages;                   // number of frames allocated over all shards, root only
+    double dirtyRatio;              // fraction of the frames in use at which the page cleaner starts
+    int firstFrame;                 // index of the first frame of this shard in the statistics of the pool
+    struct BM_BufferPool_Mgmt *root; // first shard of the pool, the shard itself if it is the root
+    struct BM_BufferPool_Mgmt **shards; // all shards of the pool, the root first, only set in the root
+    int numShards;                  // number of shards, only set in the root
+    int numaNode;                   // NUMA node the frames of this shard are bound to, -1 without numaPlacement
+    int crossNodePins;              // pins of pages of this shard by threads running on another node
+    bool numaPlacement;             // extents are placed in shards of the node of their first user, root only
+    int numNodes;                   // number of nodes the shards are spread over, root only
+    int nodeIds[MAX_NUMA_NODES];    // node of each node index, shard i is on nodeIds[i % numNodes], root only
+    int *extentShards;              // shard of each placed extent or NO_SHARD, root only
+    int numExtents;                 // number of extents in extentShards
+    bool profileLatches;            // the latch helpers fill in latchStats
+    BM_LatchStats latchStats[BM_NUM_LATCH_KINDS]; // profile of the latches of this shard
+    long long *frameLatchedAt;      // when each frame latch was taken, only with profileLatches
+    long long fileLatchedAt;        // when the file latch was taken, used in the root
+    long long replacementLatchedAt; // when the replacement latch was taken
+    StatSlot *statSlots;            // statistics of getPoolStats, root only
+    bool timePins;                  // pins are timed into the pin histogram
+    bool *prefetched;               // the frame was read ahead or prefetched and has not been hit since
+    BM_CompressedTier *compressedTier; // clean pages evicted from the frames, with compressedTierPages, root only
+    int *spillEntries;              // tier entry reserved for the page each frame gave up, with a compressed tier
+    BM_TraceWriter *trace;          // records the pins, unpins and dirty marks with the traceFile option, root only
+    bool trackUses;                 // pins update useCounts and lastUses, with the hotSetFile option
+    unsigned *useCounts;            // uses of the page of each frame, with trackUses
+    long long *lastUses;            // clockNanos of the last use of each frame, with trackUses
+    char *hotSetFile;               // own copy of the hotSetFile option, root only
+    HotSetEntry *warmEntries;       // pages read from the hot set that are still to be loaded, root only
+    int numWarmEntries;
+    long long checkpointNanos;      // time between the checkpoints of the warm thread, 0 for none, root only
+    bool warmRunning;               // the warm thread belongs to the pool, root only
+    bool warmStop;                  // asks the warm thread to exit, protected by warmLatch
+    pthread_t warmThread;
+    pthread_mutex_t warmLatch;      // protects warmStop and the wake ups of the warm thread
+    pthread_cond_t warmWake;        // signalled on shutdown
+    int dirtyCount;                 // number of frames whose dirty flag is set
+    bool cleanerRunning;            // a page cleaner thread belongs to the pool
+    bool cleanerStop;               // asks the page cleaner to exit, protected by cleanerLatch
+    int cleanerThreshold;           // dirtyCount at which the page cleaner starts writing
+    int cleanerCursor;              // frame where the next cleaning pass starts
+    FlushEntry *cleanerBatch;       // dirty frames collected by a cleaning pass
+    pthread_t cleanerThread;
+    pthread_mutex_t cleanerLatch;   // protects cleanerStop and the wake ups of the page cleaner
+    pthread_cond_t cleanerWake;     // signalled when dirtyCount reaches the threshold or on shutdown
+    int readAheadPages;             // the readAheadPages option, readAheadMax is capped to the size of the pool
+    int readAheadMax;               // largest read ahead window, 0 if read ahead is off, the read ahead state is kept per file
 } BM_BufferPool_Mgmt;
 
-/*
-    # This function creates a buffer pool with a specified number of page frames, organized as a
-      linked list.
-    # Each frame has default values, with the first frame as the head and the last as the tail.
-    # It is called by the initBufferPool() function, which passes the buffer management information.
-*/
-void createPageFrame(BM_BufferPool_Mgmt *mgmt)
+// returns the start of the page data of the given frame
+static char *frameDataOf(BM_BufferPool_Mgmt *mgmt, int frame)
 {
-    PageFrame *newFrame = (PageFrame *)malloc(sizeof(PageFrame));
+    return mgmt->frameData + (size_t)frame * mgmt->pageSize;
+}
 
-    // Check if memory allocation was successful
-    if (newFrame == NULL)
+// monotonic time in nanoseconds used by the latch profile and the statistics
+static long long clockNanos(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// returns the statistics slot of the calling thread
+static StatSlot *statSlotOf(BM_BufferPool_Mgmt *mgmt)
+{
+    if (statSlotOfThread < 0)
     {
-        printf("Memory allocation for new frame failed.\n");
-        return;
+        statSlotOfThread = __atomic_fetch_add(&nextStatSlot, 1, __ATOMIC_RELAXED) % STAT_SLOTS;
     }
+    return &mgmt->root->statSlots[statSlotOfThread];
+}
 
-    // Initialize the page properties for the new frame
-    newFrame->dirtyFlagSignal = 0;
-    newFrame->fixCount = 0;
-    newFrame->frameNum = 0;
-    newFrame->pageNum = -1;
-    newFrame->referenceBit = 0;
+// adds to a statistics counter, only concurrent pools need an atomic add
+static void addStat(BM_BufferPool_Mgmt *mgmt, long long *counter, long long amount)
+{
+    if (mgmt->concurrent)
+        __atomic_fetch_add(counter, amount, __ATOMIC_RELAXED);
+    else
+        *counter += amount;
+}
 
-    // Allocate memory for the page's data within the frame
-    newFrame->data = (char *)calloc(PAGE_SIZE, sizeof(char));
+static void countStat(BM_BufferPool_Mgmt *mgmt, int stat, long long amount)
+{
+    addStat(mgmt, &statSlotOf(mgmt)->counts[stat], amount);
+}
 
-    // Initialize the pointers to maintain the doubly linked list structure
-    mgmt->head = mgmt->start;
-    newFrame->next = NULL;
-    newFrame->prev = NULL;
+// records a latency in its log2 bucket of the given histogram
+static void recordLatency(BM_BufferPool_Mgmt *mgmt, int histogram, long long nanos)
+{
+    BM_Histogram *h = &statSlotOf(mgmt)->histograms[histogram];
+    int bucket = nanos > 1 ? 63 - __builtin_clzll((unsigned long long)nanos) : 0;
 
-    // Check if the buffer pool is empty
-    if (mgmt->head == NULL)
+    if (bucket >= BM_HISTOGRAM_BUCKETS)
     {
-        // The new frame becomes the head
-        mgmt->head = newFrame;
-        mgmt->tail = newFrame;
-        // The start pointer also points to the new frame
-        mgmt->start = newFrame;
+        bucket = BM_HISTOGRAM_BUCKETS - 1;
     }
-    else
+    addStat(mgmt, &h->counts[bucket], 1);
+    addStat(mgmt, &h->totalNanos, nanos);
+}
+
+// appends a record to the trace of the pool, if it has one
+static void traceOp(BM_BufferPool_Mgmt *mgmt, int file, PageNumber pageNum, int op)
+{
+    if (mgmt->root->trace != NULL)
     {
-        // If the buffer pool already has frames, append the new frame to the tail
-        // The current tail's next points to the new frame
-        mgmt->tail->next = newFrame;
-        // The new frame's previous points to the current tail
-        newFrame->prev = mgmt->tail;
-        // The new frame becomes the new tail
-        mgmt->tail = newFrame;
+        traceWriterAppend(mgmt->root->trace, file, pageNum, op);
     }
-    // Tail's next points to the head to form a loop
-    mgmt->tail->next = mgmt->head;
-    // Head's previous points to the new tail
-    mgmt->head->prev = mgmt->tail;
 }
 
-// Buffer Manager Interface Pool Handling
-/*
-    This function creates a buffer pool for an existing page file. It uses parameters:
-    bm: Stores the mgmtData.
-    pageFileName: The name of the page file whose pages will be cached.
-    numPages: The number of frames in the buffer pool.
-    strategy: The page replacement strategy to use.
-    replacementData: Any additional parameters needed for the chosen page replacement strategy.
-*/
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
-                  const int numPages, ReplacementStrategy strategy,
-                  void *replacementData)
+// counts a use of the frame for the hot set
+static void noteUse(BM_BufferPool_Mgmt *mgmt, int frame)
 {
-    BM_BufferPool_Mgmt *bp_mgmt = (BM_BufferPool_Mgmt *)malloc(sizeof(BM_BufferPool_Mgmt));
-
-    // Check if memory allocation was successful
-    if (bp_mgmt == NULL)
+    if (mgmt->trackUses)
     {
-        printf("Memory allocation for buffer pool management failed.\n");
-        // return RC_MEMORY_ALLOCATION_FAIL;
+        __atomic_add_fetch(&mgmt->useCounts[frame], 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&mgmt->lastUses[frame], clockNanos(), __ATOMIC_RELAXED);
     }
+}
 
-    // Initialize the Storage Manager file handle
-    SM_FileHandle fHandleandle;
-
-    // Open the page file that will be cached in the buffer pool
-    RC status = openPageFile((char *)pageFileName, &fHandleandle);
-    if (status != RC_OK)
+// counts a pin of a resident page, the first one after the page was read ahead or prefetched is a prefetch hit
+static void countHit(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    countStat(mgmt, STAT_HITS, 1);
+    noteUse(mgmt, frame);
+    if (ATOMIC_LOAD(&mgmt->prefetched[frame]) && ATOMIC_EXCHANGE(&mgmt->prefetched[frame], false))
     {
-        // Free allocated memory if file opening fails
-        free(bp_mgmt);
-        // Return the error code from file handling
-        return status;
+        countStat(mgmt, STAT_PREFETCH_HITS, 1);
     }
+}
 
-    // Create the frames for the buffer pool
-    for (int i = 0; i < numPages; i++)
+// counts an acquisition of a latch that waited since waitStart, 0 if it was free, returns when it was taken
+static long long latchAcquired(BM_BufferPool_Mgmt *mgmt, BM_LatchKind kind, long long waitStart)
+{
+    BM_LatchStats *stats = &mgmt->latchStats[kind];
+    long long now = clockNanos();
+
+    ATOMIC_ADD(&stats->acquisitions, 1);
+    if (waitStart != 0)
     {
-        createPageFrame(bp_mgmt);
+        ATOMIC_ADD(&stats->contended, 1);
+        ATOMIC_ADD(&stats->waitNanos, now - waitStart);
     }
+    return now;
+}
 
-    // Initialize buffer pool management data
-    // Set tail to head after creating frames
-    bp_mgmt->tail = bp_mgmt->head;
-    // Set the strategy data
-    bp_mgmt->replacementData = replacementData;
-    // No frames are occupied initially
-    bp_mgmt->occupiedFrameCount = 0;
-    // No pages read initially
-    bp_mgmt->getNumReadIO = 0;
-    // No pages written initially
-    bp_mgmt->getNumWriteIO = 0;
-
-    // Initialize buffer pool structure
-    // Set the number of pages
-    bm->numPages = numPages;
-    // Store the page file name
-    bm->pageFile = strdup(pageFileName);
-    // Set the replacement strategy
-    bm->strategy = strategy;
-    // Set the management data
-    bm->mgmtData = bp_mgmt;
+// adds the time since the latch was taken to its hold time
+static void latchReleased(BM_BufferPool_Mgmt *mgmt, BM_LatchKind kind, long long latchedAt)
+{
+    ATOMIC_ADD(&mgmt->latchStats[kind].holdNanos, clockNanos() - latchedAt);
+}
 
-    // Close the page file after initialization
-    closePageFile(&fHandleandle);
+// takes a mutex of the shard and returns when it was taken
+static long long mutexLatchProfiled(BM_BufferPool_Mgmt *mgmt, pthread_mutex_t *latch, BM_LatchKind kind)
+{
+    long long waitStart = 0;
 
-    return RC_OK;
+    if (pthread_mutex_trylock(latch) != 0)
+    {
+        waitStart = clockNanos();
+        pthread_mutex_lock(latch);
+    }
+    return latchAcquired(mgmt, kind, waitStart);
 }
 
-/*
-    # This function shuts down the buffer pool and frees associated resources.
-*/
-RC shutdownBufferPool(BM_BufferPool *const bm)
+// latch helpers, all of them do nothing unless the pool is concurrent
+static void tableLatchShared(BM_BufferPool_Mgmt *mgmt)
 {
-    // Load the management data of the buffer pool
-    if (bm == NULL || bm->mgmtData == NULL)
+    if (!mgmt->concurrent)
+        return;
+    if (!mgmt->profileLatches)
     {
-        // Return if buffer pool or management data is invalid
-        // return RC_INVALID_INPUT;
+        pthread_rwlock_rdlock(&mgmt->tableLatch);
+        return;
     }
 
-    BM_BufferPool_Mgmt *bp_mgmt = (BM_BufferPool_Mgmt *)bm->mgmtData;
-
-    // Ensure the buffer pool is not already empty
-    if (bp_mgmt->head == NULL)
+    long long waitStart = 0;
+    if (pthread_rwlock_tryrdlock(&mgmt->tableLatch) != 0)
     {
-        // No frames to free, already empty
-        return RC_OK;
+        waitStart = clockNanos();
+        pthread_rwlock_rdlock(&mgmt->tableLatch);
     }
+    tableLatchedAt = latchAcquired(mgmt, BM_LATCH_TABLE_SHARED, waitStart);
+    tableLatchedKind = BM_LATCH_TABLE_SHARED;
+}
 
-    // Point to the head node
-    PageFrame *currentFrame = bp_mgmt->head;
-
-    RC status = forceFlushPool(bm);
-    if (status != RC_OK)
+static void tableLatchExclusive(BM_BufferPool_Mgmt *mgmt)
+{
+    if (!mgmt->concurrent)
+        return;
+    if (!mgmt->profileLatches)
     {
-        // Return error if flush fails
-        return status;
+        pthread_rwlock_wrlock(&mgmt->tableLatch);
+        return;
     }
 
-    // Free all the page data in each frame, traversing the circular linked list
-    do
+    long long waitStart = 0;
+    if (pthread_rwlock_trywrlock(&mgmt->tableLatch) != 0)
     {
-        PageFrame *temp = currentFrame;
-        currentFrame = currentFrame->next;
-
-        // Free the data in the frame and then the frame itself
-        // Free the page data
-        free(temp->data);
-        // Free the frame
-        free(temp);
-    } while (currentFrame != bp_mgmt->head);
-
-    // Nullify all the management pointers and reset the buffer pool structure
-    bp_mgmt->start = NULL;
-    bp_mgmt->head = NULL;
-    bp_mgmt->tail = NULL;
+        waitStart = clockNanos();
+        pthread_rwlock_wrlock(&mgmt->tableLatch);
+    }
+    tableLatchedAt = latchAcquired(mgmt, BM_LATCH_TABLE_EXCLUSIVE, waitStart);
+    tableLatchedKind = BM_LATCH_TABLE_EXCLUSIVE;
+}
 
-    // Free the buffer pool management structure
-    free(bp_mgmt);
+static void tableLatchRelease(BM_BufferPool_Mgmt *mgmt)
+{
+    if (!mgmt->concurrent)
+        return;
+    if (mgmt->profileLatches)
+        latchReleased(mgmt, tableLatchedKind, tableLatchedAt);
+    pthread_rwlock_unlock(&mgmt->tableLatch);
+}
 
-    // Set all buffer pool values to 0 or NULL
-    bm->numPages = 0;
-    bm->mgmtData = NULL;
-    bm->pageFile = NULL;
+static void frameLatchAcquire(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (!mgmt->concurrent)
+        return;
+    if (mgmt->profileLatches)
+        mgmt->frameLatchedAt[frame] = mutexLatchProfiled(mgmt, &mgmt->frameLatches[frame], BM_LATCH_FRAME);
+    else
+        pthread_mutex_lock(&mgmt->frameLatches[frame]);
+}
 
-    return RC_OK;
+static void frameLatchRelease(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (!mgmt->concurrent)
+        return;
+    if (mgmt->profileLatches)
+        latchReleased(mgmt, BM_LATCH_FRAME, mgmt->frameLatchedAt[frame]);
+    pthread_mutex_unlock(&mgmt->frameLatches[frame]);
 }
-/*
-    This function flushes any dirty pages in the buffer pool to disk.
-*/
-RC forceFlushPool(BM_BufferPool *const bm)
+
+// waits on frameLoaded holding the frame latch, the wait counts as waiting for the latch
+static void frameLatchWaitLoaded(BM_BufferPool_Mgmt *mgmt, int frame)
 {
-    // Check for valid buffer pool and management data
-    if (bm == NULL || bm->mgmtData == NULL)
+    if (!mgmt->profileLatches)
     {
-        // return RC_INVALID_INPUT;
+        pthread_cond_wait(&mgmt->frameLoaded[frame], &mgmt->frameLatches[frame]);
+        return;
     }
 
-    // Load the management data
-    BM_BufferPool_Mgmt *bp_mgmt = (BM_BufferPool_Mgmt *)bm->mgmtData;
+    BM_LatchStats *stats = &mgmt->latchStats[BM_LATCH_FRAME];
+    long long waitStart = clockNanos();
+    ATOMIC_ADD(&stats->holdNanos, waitStart - mgmt->frameLatchedAt[frame]);
+    pthread_cond_wait(&mgmt->frameLoaded[frame], &mgmt->frameLatches[frame]);
+    mgmt->frameLatchedAt[frame] = clockNanos();
+    ATOMIC_ADD(&stats->waitNanos, mgmt->frameLatchedAt[frame] - waitStart);
+}
 
-    // Point to the head of the circular linked list of frames
-    PageFrame *currentFrame = bp_mgmt->head;
+// the file latch of the root serialises the storage manager calls of all shards
+static void fileLatchAcquire(BM_BufferPool_Mgmt *mgmt)
+{
+    BM_BufferPool_Mgmt *root = mgmt->root;
 
-    // Open the page file
-    SM_FileHandle fHandleandle;
-    if (openPageFile((char *)bm->pageFile, &fHandleandle) != RC_OK)
-    {
-        return RC_FILE_NOT_FOUND;
-    }
+    if (!mgmt->concurrent)
+        return;
+    if (root->profileLatches)
+        root->fileLatchedAt = mutexLatchProfiled(root, &root->fileLatch, BM_LATCH_FILE);
+    else
+        pthread_mutex_lock(&root->fileLatch);
+}
 
-    // Traverse through the circular linked list and check for dirty pages to flush
-    do
-    {
-        if (currentFrame->dirtyFlagSignal == true && currentFrame->fixCount == 0)
-        {
-            // Write the dirty page back to disk
-            if (writeBlock(currentFrame->pageNum, &fHandleandle, currentFrame->data) != RC_OK)
-            {
-                // Ensure the file is closed before returning
-                closePageFile(&fHandleandle);
-                return RC_WRITE_FAILED;
-            }
+static void fileLatchRelease(BM_BufferPool_Mgmt *mgmt)
+{
+    BM_BufferPool_Mgmt *root = mgmt->root;
 
-            // Mark the frame as clean (not dirty anymore)
-            currentFrame->dirtyFlagSignal = false;
-            // Increment the write count
-            bp_mgmt->getNumWriteIO++;
-        }
+    if (!mgmt->concurrent)
+        return;
+    if (root->profileLatches)
+        latchReleased(root, BM_LATCH_FILE, root->fileLatchedAt);
+    pthread_mutex_unlock(&root->fileLatch);
+}
+
+// taken around the onHit calls of policies without concurrentHits, only used by concurrent pools
+static void replacementLatchAcquire(BM_BufferPool_Mgmt *mgmt)
+{
+    if (mgmt->profileLatches)
+        mgmt->replacementLatchedAt = mutexLatchProfiled(mgmt, &mgmt->replacementLatch, BM_LATCH_REPLACEMENT);
+    else
+        pthread_mutex_lock(&mgmt->replacementLatch);
+}
 
-        // Move to the next frame in the linked list
-        currentFrame = currentFrame->next;
-        // Stop when we return to the head frame
-    } while (currentFrame != bp_mgmt->head);
+static void replacementLatchRelease(BM_BufferPool_Mgmt *mgmt)
+{
+    if (mgmt->profileLatches)
+        latchReleased(mgmt, BM_LATCH_REPLACEMENT, mgmt->replacementLatchedAt);
+    pthread_mutex_unlock(&mgmt->replacementLatch);
+}
 
-    // Close the page file after all dirty pages are written
-    closePageFile(&fHandleandle);
+// taken around reads and writes of existing pages
+static void blockIOLatchAcquire(BM_BufferPool_Mgmt *mgmt)
+{
+    if (!mgmt->parallelIO)
+        fileLatchAcquire(mgmt);
+}
 
-    return RC_OK;
+static void blockIOLatchRelease(BM_BufferPool_Mgmt *mgmt)
+{
+    if (!mgmt->parallelIO)
+        fileLatchRelease(mgmt);
 }
 
-/*Function to create a PageFrame*/
+// returns the handle of a page file of the pool, which all shards share
+static SM_FileHandle *fileOf(BM_BufferPool_Mgmt *mgmt, int file)
+{
+    return &mgmt->root->files[file].handle;
+}
 
-// Buffer Manager Interface Access Pages
+// returns the number of pages of the page file, which only grows while the pool is open
+static int filePagesOf(BM_BufferPool_Mgmt *mgmt, int file)
+{
+    return ATOMIC_LOAD(&fileOf(mgmt, file)->totalNumPages);
+}
 
-/* This function is used to mark a page dirty when it is modified by the user and it is set to 1  */
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+// makes sure the page file has numPages pages, the file latch is only taken if it has to grow
+static RC growFile(BM_BufferPool_Mgmt *mgmt, int file, int numPages)
 {
-    // check if the page is present in the buffer pool and get the management info of the buffer pool
-    BM_BufferPool_Mgmt *bp_mgmt;
-    bp_mgmt = bm->mgmtData;
-    // get the head node of the linked list of frames
-    PageFrame *frame = bp_mgmt->head;
+    if (numPages <= filePagesOf(mgmt, file))
+        return RC_OK;
 
-    // check if the page number is present in the linked list
-    do
-    {
-        // check if the pageNum is same as the page to be marked dirty
-        if (page->pageNum == frame->pageNum)
-        {
-            // mark the page as dirty and return success
-            frame->dirtyFlagSignal = 1;
-            return RC_OK;
-        }
-        // go to next frame
-        frame = frame->next;
-    } while (frame != bp_mgmt->head);
+    fileLatchAcquire(mgmt);
+    RC status = ensureCapacity(numPages, fileOf(mgmt, file));
+    fileLatchRelease(mgmt);
+    return status;
+}
 
-    // if not found return error
-    return RC_OK;
+// returns the NUMA node the calling thread runs on, -1 if it is not known
+static int currentNode(void)
+{
+    unsigned int cpu, node;
+    return getcpu(&cpu, &node) == 0 ? (int)node : -1;
 }
 
-/* This function is used to unpin a page from the buffer pool when it is no longer in use by the user means it is set to free
-this method called as "unpinning" a page in the buffer pool */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+// returns the index of the node of the calling thread among the nodes of the pool, -1 if it is none of them
+static int currentNodeIndex(BM_BufferPool_Mgmt *root)
 {
-    // check if the page is present in the buffer pool and get the management info of the buffer pool
-    BM_BufferPool_Mgmt *bp_mgmt;
-    bp_mgmt = bm->mgmtData;
-    PageFrame *frame = bp_mgmt->head;
+    int node = currentNode();
 
-    // check if the page number is present in the linked list
-    do
+    for (int i = 0; i < root->numNodes; i++)
     {
-        // check if the pageNum is the same as the page to be unpinned
-        if (page->pageNum == frame->pageNum)
+        if (root->nodeIds[i] == node)
         {
-            // decrement the fix count and return success if it is 0
-            frame->fixCount--;
-            return RC_OK;
+            return i;
         }
-        // go to next frame if not found
-        frame = frame->next;
-    } while (frame != bp_mgmt->head);
+    }
+    return -1;
+}
 
-    // if not found return error
-    return RC_OK;
+/*
+    # Returns the shard of an extent of a pool with numaPlacement. An extent used for the first time
+      goes to one of the shards of the node of the calling thread, picked by the hash of the extent,
+      and stays in that shard while the pool is open.
+*/
+static int placedShardOf(BM_BufferPool_Mgmt *root, unsigned int extent, unsigned int hash)
+{
+    int shard = ATOMIC_LOAD(&root->extentShards[extent]);
+    if (shard != NO_SHARD)
+    {
+        return shard;
+    }
+
+    int node = currentNodeIndex(root);
+    if (node < 0)
+    {
+        shard = (int)(hash % (unsigned int)root->numShards);
+    }
+    else
+    {
+        // the shards of node index n are n, n + numNodes, n + 2 * numNodes and so on
+        int nodeShards = (root->numShards - node + root->numNodes - 1) / root->numNodes;
+        shard = node + root->numNodes * (int)(hash % (unsigned int)nodeShards);
+    }
+
+    // a thread using the extent at the same time may have placed it first, its choice stands
+    int unplaced = NO_SHARD;
+    if (!__atomic_compare_exchange_n(&root->extentShards[extent], &unplaced, shard, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+    {
+        shard = unplaced;
+    }
+    return shard;
 }
 
-/* This function is used to pin a page passed to it in BM_PageHandle and writes back to the disk file
-    when it is no longer in use by the user means it is set to free */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+// whether an extent of the file goes to the shard placedShardOf picks for it rather than to a hashed one
+static bool isPlacedExtent(BM_BufferPool_Mgmt *root, int file, unsigned int extent)
 {
-    // check if the page is present in the buffer pool and get the management info of the buffer pool
-    BM_BufferPool_Mgmt *bp_mgmt;
-    bp_mgmt = bm->mgmtData;
-    // get the head node of the linked list of frames
-    PageFrame *Frame = bp_mgmt->head;
-    SM_FileHandle fHandle;
+    return root->numShards > 1 && root->numaPlacement && file == 0 && extent < (unsigned int)root->numExtents;
+}
+
+// returns the index of the shard that holds pageNum of the file when it is resident
+static int shardIndexOf(BM_BufferPool_Mgmt *root, int file, PageNumber pageNum)
+{
+    if (root->numShards == 1)
+    {
+        return 0;
+    }
+    // multiplicative hashing of the extent, as for the buckets of the page table, the pages of an
+    // extent of another file share a key extent as well
+    unsigned int extent = (unsigned int)(pageNum / SHARD_EXTENT_PAGES);
+    unsigned int hash = (unsigned int)(pageKeyOf(file, pageNum) / SHARD_EXTENT_PAGES) * 2654435761u;
+    if (isPlacedExtent(root, file, extent))
+    {
+        return placedShardOf(root, extent, hash);
+    }
+    return (int)(hash % (unsigned int)root->numShards);
+}
 
-    // open the file for writing
-    if (openPageFile((char *)(bm->pageFile), &fHandle) != RC_OK)
+static BM_BufferPool_Mgmt *shardOf(BM_BufferPool_Mgmt *root, int file, PageNumber pageNum)
+{
+    return root->numShards == 1 ? root : root->shards[shardIndexOf(root, file, pageNum)];
+}
+
+// counts a pin of a page of the shard by a thread running on another node than the frames of the shard
+static void countNodeAccess(BM_BufferPool_Mgmt *mgmt)
+{
+    if (mgmt->numaNode >= 0 && currentNode() != mgmt->numaNode)
+    {
+        ATOMIC_ADD(&mgmt->crossNodePins, 1);
+    }
+}
+
+// reads the online NUMA nodes, a list such as 0-1,3, into nodeIds and returns their number, at least one
+static int onlineNodes(int *nodeIds)
+{
+    FILE *file = fopen("/sys/devices/system/node/online", "r");
+    int first, last;
+    int count = 0;
+
+    if (file != NULL)
+    {
+        while (count < MAX_NUMA_NODES && fscanf(file, "%d", &first) == 1)
+        {
+            if (fscanf(file, "-%d", &last) != 1)
+            {
+                last = first;
+            }
+            for (int node = first; node <= last && count < MAX_NUMA_NODES; node++)
+            {
+                nodeIds[count++] = node;
+            }
+            if (fgetc(file) != ',')
+            {
+                break;
+            }
+        }
+        fclose(file);
+    }
+    if (count == 0)
+    {
+        nodeIds[0] = 0;
+        count = 1;
+    }
+    return count;
+}
+
+// binds memory that was not touched yet to the node, if that fails it stays where first touch puts it
+static void bindToNode(void *addr, size_t length, int node)
+{
+    unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {0};
+
+    if (node < 0 || node >= MAX_NUMA_NODES)
+    {
+        return;
+    }
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, addr, length, NUMA_MPOL_BIND, mask, (unsigned long)MAX_NUMA_NODES + 1, 0);
+}
+
+static size_t roundUpTo(size_t length, size_t unit)
+{
+    return (length + unit - 1) / unit * unit;
+}
+
+// false if transparent huge pages are turned off for the whole system, madvise would not get any then
+static bool transparentHugePagesEnabled(void)
+{
+    char setting[128] = "";
+    FILE *file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+    bool gotLine = fgets(setting, sizeof(setting), file) != NULL;
+    fclose(file);
+    return gotLine && strstr(setting, "[never]") == NULL;
+}
+
+// maps at least length bytes of hugetlb pages of 2^shift bytes, NULL if the system has not reserved enough of them
+static char *mapHugeTLB(size_t length, int shift, size_t *mapped)
+{
+    size_t size = roundUpTo(length, (size_t)1 << shift);
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    *mapped = size;
+    return (char *)addr;
+}
+
+// maps at least length bytes aligned to 2 MB and asks for transparent huge pages, NULL if they cannot be had
+static char *mapTransparent(size_t length, size_t *mapped)
+{
+    size_t hugeSize = (size_t)1 << HUGE_2MB_SHIFT;
+    size_t size = roundUpTo(length, hugeSize);
+
+    if (!transparentHugePagesEnabled())
+    {
+        return NULL;
+    }
+    char *addr = (char *)mmap(NULL, size + hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    // only the aligned part is kept, the bytes before and after it are given back
+    char *start = (char *)roundUpTo((uintptr_t)addr, hugeSize);
+    if (start > addr)
+    {
+        munmap(addr, start - addr);
+    }
+    if (addr + hugeSize > start)
+    {
+        munmap(start + size, addr + hugeSize - start);
+    }
+    if (madvise(start, size, MADV_HUGEPAGE) != 0)
+    {
+        munmap(start, size);
+        return NULL;
+    }
+    *mapped = size;
+    return start;
+}
+
+/*
+    # Maps the frame slab of the shard, of at least length bytes, from the largest kind of pages
+      the framePages option of the pool allows and the system gives.
+*/
+static RC mapFrameSlab(BM_BufferPool_Mgmt *mgmt, size_t length)
+{
+    BM_FramePages wanted = mgmt->root->wantedFramePages;
+    char *slab = NULL;
+
+    mgmt->frameMemPageSize = (size_t)sysconf(_SC_PAGESIZE);
+    if (wanted == BM_FRAME_PAGES_HUGE_1GB)
+    {
+        slab = mapHugeTLB(length, HUGE_1GB_SHIFT, &mgmt->frameBytes);
+        mgmt->framePages = BM_FRAME_PAGES_HUGE_1GB;
+        mgmt->frameMemPageSize = (size_t)1 << HUGE_1GB_SHIFT;
+    }
+    if (slab == NULL && wanted >= BM_FRAME_PAGES_HUGE_2MB)
+    {
+        slab = mapHugeTLB(length, HUGE_2MB_SHIFT, &mgmt->frameBytes);
+        mgmt->framePages = BM_FRAME_PAGES_HUGE_2MB;
+        mgmt->frameMemPageSize = (size_t)1 << HUGE_2MB_SHIFT;
+    }
+    // transparent huge pages can be split, so the slab is still handled in normal pages
+    if (slab == NULL && wanted >= BM_FRAME_PAGES_TRANSPARENT)
+    {
+        slab = mapTransparent(length, &mgmt->frameBytes);
+        mgmt->framePages = BM_FRAME_PAGES_TRANSPARENT;
+        mgmt->frameMemPageSize = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    if (slab == NULL)
+    {
+        mgmt->framePages = BM_FRAME_PAGES_DEFAULT;
+        mgmt->frameMemPageSize = (size_t)sysconf(_SC_PAGESIZE);
+        mgmt->frameBytes = roundUpTo(length, mgmt->frameMemPageSize);
+        slab = (char *)mmap(NULL, mgmt->frameBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (slab == (char *)MAP_FAILED)
+        {
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+    }
+    mgmt->frameData = slab;
+    return RC_OK;
+}
+
+// writes to every memory page of the frames first to last - 1 without changing them, so they are faulted in now
+static void prefaultFrameMemory(BM_BufferPool_Mgmt *mgmt, int first, int last)
+{
+    char *end = frameDataOf(mgmt, last);
+
+    for (char *byte = frameDataOf(mgmt, first); byte < end;)
+    {
+        // an atomic or with 0 writes the page but keeps the data other threads may change next to it
+        __atomic_fetch_or(byte, 0, __ATOMIC_RELAXED);
+        byte = (char *)roundUpTo((uintptr_t)byte + 1, mgmt->frameMemPageSize);
+    }
+}
+
+/*
+    # The page table is a chained hash table from the file and PageNumber of a page to the frame holding it.
+    # It is kept up to date whenever a page is loaded into or evicted from a frame, so that
+      finding a resident page does not need to walk the frames.
+*/
+static int pageTableBucket(BM_BufferPool_Mgmt *mgmt, int file, PageNumber pageNum)
+{
+    // multiplicative hashing spreads sequential page numbers over the buckets
+    return (int)(((unsigned int)pageKeyOf(file, pageNum) * 2654435761u) & (unsigned int)mgmt->pageTableMask);
+}
+
+// returns the frame holding pageNum of the file or NO_FRAME if the page is not in the buffer pool,
+// the caller holds the page table latch
+static int pageTableLookup(BM_BufferPool_Mgmt *mgmt, int file, PageNumber pageNum)
+{
+    int frame = mgmt->pageTable[pageTableBucket(mgmt, file, pageNum)];
+
+    while (frame != NO_FRAME && (mgmt->pageNums[frame] != pageNum || mgmt->fileIds[frame] != file))
+    {
+        frame = mgmt->hashNext[frame];
+    }
+    return frame;
+}
+
+// adds the frame under its current page
+static void pageTableInsert(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    int bucket = pageTableBucket(mgmt, mgmt->fileIds[frame], mgmt->pageNums[frame]);
+
+    // optimistic pinners walk the chains without the latch, so the frame is linked before it is published
+    ATOMIC_STORE(&mgmt->hashNext[frame], mgmt->pageTable[bucket]);
+    ATOMIC_STORE(&mgmt->pageTable[bucket], frame);
+}
+
+// removes the frame from the bucket of its current page, if it is there
+static void pageTableRemove(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (mgmt->pageNums[frame] == NO_PAGE)
+    {
+        return;
+    }
+
+    int *link = &mgmt->pageTable[pageTableBucket(mgmt, mgmt->fileIds[frame], mgmt->pageNums[frame])];
+
+    while (*link != NO_FRAME && *link != frame)
+    {
+        link = &mgmt->hashNext[*link];
+    }
+    if (*link == frame)
+    {
+        ATOMIC_STORE(link, mgmt->hashNext[frame]);
+    }
+    ATOMIC_STORE(&mgmt->hashNext[frame], NO_FRAME);
+}
+
+// starts changing the page held by a frame, optimistic pins validated after this fail
+static void frameChangeBegin(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    // sequentially consistent, so the odd version is ordered before the claim of the frame and the new page number
+    __atomic_add_fetch(&mgmt->frameVersions[frame], 1, __ATOMIC_SEQ_CST);
+}
+
+static void frameChangeEnd(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    ATOMIC_ADD(&mgmt->frameVersions[frame], 1);
+}
+
+/*
+    # This function allocates the frames of a buffer pool: one aligned slab for the page data of
+      all frames and one dense array per frame attribute, each frame starting empty.
+    # It is called by the initBufferPool() function, which passes the buffer management information.
+    # numPages frames are allocated, only the data of the first numFrames of them is touched, and only
+      with the prefaultFrames or lockFrames option.
+*/
+static RC createPageFrames(BM_BufferPool_Mgmt *mgmt, int numPages)
+{
+    // mapped, so frames of pages of at least FRAME_ALIGNMENT start on their own memory page
+    if (mapFrameSlab(mgmt, (size_t)numPages * mgmt->pageSize) != RC_OK)
+    {
+        printf("Memory allocation for page frames failed.\n");
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    // bound before anything touches the slab, so its memory is allocated on the node
+    if (mgmt->numaNode >= 0)
+    {
+        bindToNode(mgmt->frameData, mgmt->frameBytes, mgmt->numaNode);
+    }
+    // a slab that cannot be locked is still used, getPoolStats tells
+    if (mgmt->root->lockFrames)
+    {
+        mgmt->framesLocked = mlock(mgmt->frameData, mgmt->frameBytes) == 0;
+    }
+    if (mgmt->root->prefaultFrames)
+    {
+        prefaultFrameMemory(mgmt, 0, mgmt->numFrames);
+    }
+
+    mgmt->pageNums = (PageNumber *)malloc(sizeof(PageNumber) * numPages);
+    mgmt->fileIds = (int *)calloc(numPages, sizeof(int));
+    mgmt->fixCounts = (int *)calloc(numPages, sizeof(int));
+    mgmt->dirtyFlags = (bool *)calloc(numPages, sizeof(bool));
+    mgmt->frameStates = (int *)calloc(numPages, sizeof(int));
+    mgmt->hashNext = (int *)malloc(sizeof(int) * numPages);
+    mgmt->frameVersions = (unsigned *)calloc(numPages, sizeof(unsigned));
+    mgmt->prefetched = (bool *)calloc(numPages, sizeof(bool));
+    if (mgmt->root->compressedTier != NULL)
+    {
+        mgmt->spillEntries = (int *)malloc(sizeof(int) * numPages);
+    }
+    if (mgmt->trackUses)
+    {
+        mgmt->useCounts = (unsigned *)calloc(numPages, sizeof(unsigned));
+        mgmt->lastUses = (long long *)calloc(numPages, sizeof(long long));
+    }
+
+    if (mgmt->pageNums == NULL || mgmt->fileIds == NULL || mgmt->fixCounts == NULL || mgmt->dirtyFlags == NULL ||
+        mgmt->frameStates == NULL || mgmt->hashNext == NULL || mgmt->frameVersions == NULL ||
+        mgmt->prefetched == NULL || (mgmt->trackUses && (mgmt->useCounts == NULL || mgmt->lastUses == NULL)) ||
+        (mgmt->root->compressedTier != NULL && mgmt->spillEntries == NULL))
+    {
+        printf("Memory allocation for page frames failed.\n");
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int i = 0; i < numPages; i++)
+    {
+        mgmt->pageNums[i] = NO_PAGE;
+        mgmt->hashNext[i] = NO_FRAME;
+        if (mgmt->spillEntries != NULL)
+        {
+            mgmt->spillEntries[i] = BM_NO_TIER_ENTRY;
+        }
+    }
+
+    // the latches are only needed when the pool is shared between threads
+    if (mgmt->concurrent)
+    {
+        mgmt->frameLatches = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t) * numPages);
+        mgmt->frameLoaded = (pthread_cond_t *)malloc(sizeof(pthread_cond_t) * numPages);
+        if (mgmt->profileLatches)
+        {
+            mgmt->frameLatchedAt = (long long *)calloc(numPages, sizeof(long long));
+        }
+        if (mgmt->frameLatches == NULL || mgmt->frameLoaded == NULL || (mgmt->profileLatches && mgmt->frameLatchedAt == NULL))
+        {
+            printf("Memory allocation for frame latches failed.\n");
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        for (int i = 0; i < numPages; i++)
+        {
+            pthread_mutex_init(&mgmt->frameLatches[i], NULL);
+            pthread_cond_init(&mgmt->frameLoaded[i], NULL);
+        }
+        pthread_rwlock_init(&mgmt->tableLatch, NULL);
+        pthread_mutex_init(&mgmt->fileLatch, NULL);
+        pthread_mutex_init(&mgmt->replacementLatch, NULL);
+    }
+    return RC_OK;
+}
+
+// releases everything allocated by createPageFrames, arrays that were never allocated are NULL
+static void freePageFrames(BM_BufferPool_Mgmt *mgmt, int numPages)
+{
+    if (mgmt->concurrent && mgmt->frameLatches != NULL && mgmt->frameLoaded != NULL)
+    {
+        for (int i = 0; i < numPages; i++)
+        {
+            pthread_mutex_destroy(&mgmt->frameLatches[i]);
+            pthread_cond_destroy(&mgmt->frameLoaded[i]);
+        }
+        pthread_rwlock_destroy(&mgmt->tableLatch);
+        pthread_mutex_destroy(&mgmt->fileLatch);
+        pthread_mutex_destroy(&mgmt->replacementLatch);
+    }
+    free(mgmt->frameLatches);
+    free(mgmt->frameLoaded);
+    free(mgmt->frameLatchedAt);
+
+    if (mgmt->frameData != NULL)
+    {
+        munmap(mgmt->frameData, mgmt->frameBytes);
+    }
+    free(mgmt->pageNums);
+    free(mgmt->fileIds);
+    free(mgmt->fixCounts);
+    free(mgmt->dirtyFlags);
+    free(mgmt->frameStates);
+    free(mgmt->hashNext);
+    free(mgmt->frameVersions);
+    free(mgmt->prefetched);
+    free(mgmt->spillEntries);
+    free(mgmt->useCounts);
+    free(mgmt->lastUses);
+    free(mgmt->frameContent);
+    free(mgmt->fixCount);
+    free(mgmt->markDirty);
+    free(mgmt->pageTable);
+
+    if (mgmt->policyState != NULL && mgmt->policy->shutdown != NULL)
+    {
+        mgmt->policy->shutdown(mgmt->policyState);
+    }
+}
+
+// the page cleaner is defined after the flush functions it uses
+static RC startPageCleaner(BM_BufferPool_Mgmt *mgmt);
+static void stopPageCleaner(BM_BufferPool_Mgmt *mgmt);
+
+// the hot set is loaded with the functions that load pages, which are defined after the pin functions
+static RC readHotSet(BM_BufferPool_Mgmt *root);
+static RC startWarm(BM_BufferPool_Mgmt *root, bool background);
+static void stopWarm(BM_BufferPool_Mgmt *root);
+static RC writeHotSet(BM_BufferPool_Mgmt *root);
+
+// the replacement policy learns which frames are in use with the resize functions, defined after the hot set
+static void resizePolicy(BM_BufferPool_Mgmt *mgmt, int numFrames);
+
+// the files opened with openPoolFile are closed by the functions defined after the resize functions
+static RC closePoolFile(BM_BufferPool *const bm);
+
+/*
+    # Sets up one shard of numFrames frames out of maxFrames: its page table, its frames, the state of
+      the replacement policy and its counters. The settings all shards share are taken from the root.
+    # On failure the caller releases what was created with freePageFrames.
+*/
+static RC initShard(BM_BufferPool_Mgmt *mgmt, BM_BufferPool_Mgmt *root, int numFrames, int maxFrames,
+                    int firstFrame, int numaNode, void *replacementData, double dirtyRatio)
+{
+    mgmt->root = root;
+    mgmt->numFrames = numFrames;
+    mgmt->maxFrames = maxFrames;
+    mgmt->firstFrame = firstFrame;
+    mgmt->numaNode = numaNode;
+    mgmt->crossNodePins = 0;
+    mgmt->concurrent = root->concurrent;
+    mgmt->optimisticHits = root->optimisticHits;
+    mgmt->profileLatches = root->profileLatches;
+    mgmt->timePins = root->timePins;
+    mgmt->trackUses = root->trackUses;
+    mgmt->mappedStorage = root->mappedStorage;
+    mgmt->parallelIO = root->parallelIO;
+    mgmt->pageSize = root->pageSize;
+    mgmt->policy = root->policy;
+
+    // Size the page table to at least twice the number of frames to keep the chains short
+    int buckets = 1;
+    while (buckets < 2 * maxFrames)
+    {
+        buckets <<= 1;
+    }
+    mgmt->pageTable = (int *)malloc(sizeof(int) * buckets);
+    mgmt->pageTableMask = buckets - 1;
+
+    // Create the frames for the shard
+    RC status = createPageFrames(mgmt, maxFrames);
+    if (status == RC_OK && mgmt->pageTable == NULL)
+    {
+        status = RC_MEMORY_ALLOCATION_FAIL;
+    }
+    // Create the state of the replacement policy, which also checks the strategy data
+    if (status == RC_OK)
+    {
+        status = mgmt->policy->init(&mgmt->policyState, maxFrames, replacementData);
+    }
+    if (status != RC_OK)
+    {
+        return status;
+    }
+    for (int i = 0; i < buckets; i++)
+    {
+        mgmt->pageTable[i] = NO_FRAME;
+    }
+
+    // The frames the pool may grow into are left pinned until it does
+    for (int i = numFrames; i < maxFrames; i++)
+    {
+        mgmt->fixCounts[i] = 1;
+    }
+    if (numFrames < maxFrames)
+    {
+        resizePolicy(mgmt, numFrames);
+    }
+
+    // Frames are filled from the first one
+    mgmt->head = 0;
+    // Set the strategy data
+    mgmt->replacementData = replacementData;
+    // No frames are occupied initially
+    mgmt->occupiedFrameCount = 0;
+    // No pages read initially
+    mgmt->getNumReadIO = 0;
+    // No pages written initially
+    mgmt->getNumWriteIO = 0;
+    // No pages are dirty initially
+    mgmt->dirtyCount = 0;
+
+    // The page cleaner starts once the given fraction of the frames is dirty, at least one
+    mgmt->dirtyRatio = dirtyRatio;
+    mgmt->cleanerThreshold = (int)(dirtyRatio * numFrames) > 0 ? (int)(dirtyRatio * numFrames) : 1;
+    return RC_OK;
+}
+
+// frees all shards of the pool including the root, the page files are closed by the caller
+static void freeShards(BM_BufferPool_Mgmt *root)
+{
+    for (int i = 1; root->shards != NULL && i < root->numShards; i++)
+    {
+        if (root->shards[i] != NULL)
+        {
+            freePageFrames(root->shards[i], root->shards[i]->maxFrames);
+            free(root->shards[i]);
+        }
+    }
+    free(root->shards);
+    free(root->files);
+    free(root->extentShards);
+    free(root->statSlots);
+    free(root->hotSetFile);
+    free(root->warmEntries);
+    freePageFrames(root, root->maxFrames);
+    if (root->compressedTier != NULL)
+    {
+        compressedTierDestroy(root->compressedTier);
+    }
+    free(root);
+}
+
+// Buffer Manager Interface Pool Handling
+/*
+    This function creates a buffer pool for an existing page file. It uses parameters:
+    bm: Stores the mgmtData.
+    pageFileName: The name of the page file whose pages will be cached.
+    numPages: The number of frames in the buffer pool.
+    strategy: The page replacement strategy to use.
+    replacementData: Any additional parameters needed for the chosen page replacement strategy.
+*/
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy,
+                  void *replacementData)
+{
+    return initBufferPoolWithOptions(bm, pageFileName, numPages, strategy, replacementData, NULL);
+}
+
+/*
+    # Same as initBufferPool, options selects optional behaviour of the pool.
+    # Passing NULL, or a zero initialised BM_PoolOptions, gives the defaults of initBufferPool.
+*/
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                             const int numPages, ReplacementStrategy strategy,
+                             void *replacementData, const BM_PoolOptions *options)
+{
+    // The strategy has to be one of the built in ones or a registered policy
+    const BM_ReplacementPolicy *policy = getReplacementPolicy(strategy);
+    if (bm == NULL || pageFileName == NULL || numPages <= 0 || policy == NULL ||
+        (options != NULL && (options->dirtyRatio < 0 || options->dirtyRatio > 1 || options->readAheadPages < 0 ||
+                             options->numShards < 0 || options->numShards > numPages || options->checkpointSeconds < 0 ||
+                             (options->maxPages != 0 && options->maxPages < numPages) || options->maxFiles < 0 ||
+                             options->compressedTierPages < 0 || options->framePages < BM_FRAME_PAGES_DEFAULT ||
+                             options->framePages > BM_FRAME_PAGES_HUGE_1GB)))
+    {
+        return RC_INVALID_INPUT;
+    }
+    int maxPages = (options != NULL && options->maxPages != 0) ? options->maxPages : numPages;
+    int maxFiles = (options != NULL && options->maxFiles != 0) ? options->maxFiles : 1;
+
+    BM_BufferPool_Mgmt *bp_mgmt = (BM_BufferPool_Mgmt *)calloc(1, sizeof(BM_BufferPool_Mgmt));
+    // The registry of the page files never moves, the I/O paths read it without a latch
+    PoolFile *files = (PoolFile *)calloc(maxFiles, sizeof(PoolFile));
+
+    // Check if memory allocation was successful
+    if (bp_mgmt == NULL || files == NULL)
+    {
+        printf("Memory allocation for buffer pool management failed.\n");
+        free(bp_mgmt);
+        free(files);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    bp_mgmt->files = files;
+    bp_mgmt->maxFiles = maxFiles;
+    // The page cleaner runs next to the users of the pool, so it needs the latches as well
+    bool backgroundFlush = (options != NULL && options->backgroundFlush);
+    bool optimisticHits = (options != NULL && options->optimisticHits);
+    bp_mgmt->concurrent = (options != NULL && options->concurrent) || backgroundFlush || optimisticHits;
+
+    // Hits can only skip the latch if the policy does not track them or copes with that
+    bp_mgmt->optimisticHits = optimisticHits && (policy->onHit == NULL || policy->optimisticHits);
+    // Only the latches of a concurrent pool can be profiled
+    bp_mgmt->profileLatches = bp_mgmt->concurrent && options->profileLatches;
+    bp_mgmt->timePins = options != NULL && options->timePins;
+    bp_mgmt->trackUses = options != NULL && options->hotSetFile != NULL;
+    // The shards map their frames as createPageFrames finds these in the root
+    bp_mgmt->wantedFramePages = options != NULL ? options->framePages : BM_FRAME_PAGES_DEFAULT;
+    bp_mgmt->lockFrames = options != NULL && options->lockFrames;
+    bp_mgmt->prefaultFrames = options != NULL && options->prefaultFrames;
+
+    // Keep our own copy of the file name, the open file handle refers to it
+    char *fileName = strdup(pageFileName);
+
+    // Open the page file that will be cached in the buffer pool, it stays open until shutdown
+    SM_Backend backend = options != NULL ? options->storageBackend : SM_BACKEND_STDIO;
+    RC status = openPageFileWithBackend(fileName, &files[0].handle, backend);
+    if (status != RC_OK)
+    {
+        // Free allocated memory if file opening fails
+        free(fileName);
+        free(files);
+        free(bp_mgmt);
+        // Return the error code from file handling
+        return status;
+    }
+
+    // The frames take the page size of the file, a pool asking for another one is rejected
+    bp_mgmt->pageSize = files[0].handle.pageSize;
+    if (options != NULL && options->pageSize != 0 && options->pageSize != bp_mgmt->pageSize)
+    {
+        closePageFile(&files[0].handle);
+        free(fileName);
+        free(files);
+        free(bp_mgmt);
+        return RC_INVALID_INPUT;
+    }
+    files[0].name = fileName;
+    files[0].pool = bm;
+    files[0].open = true;
+    files[0].nextSequentialPage = NO_PAGE;
+    bp_mgmt->backend = backend;
+    bp_mgmt->policy = policy;
+    bp_mgmt->mappedStorage = backend == SM_BACKEND_MMAP;
+    bp_mgmt->parallelIO = backend != SM_BACKEND_MMAP;
+
+    // The root is the first shard, the frames are spread evenly over the shards
+    int numShards = (options != NULL && options->numShards > 1) ? options->numShards : 1;
+    bp_mgmt->numShards = numShards;
+    bp_mgmt->maxPages = maxPages;
+    bp_mgmt->shards = (BM_BufferPool_Mgmt **)calloc(numShards, sizeof(BM_BufferPool_Mgmt *));
+
+    // the statistics arrays are filled in by the statistics interface, they cover the largest size of the pool
+    bp_mgmt->frameContent = (PageNumber *)malloc(sizeof(PageNumber) * maxPages);
+    bp_mgmt->fixCount = (int *)malloc(sizeof(int) * maxPages);
+    bp_mgmt->markDirty = (bool *)malloc(sizeof(bool) * maxPages);
+    if (bp_mgmt->shards == NULL || bp_mgmt->frameContent == NULL || bp_mgmt->fixCount == NULL ||
+        bp_mgmt->markDirty == NULL)
+    {
+        status = RC_MEMORY_ALLOCATION_FAIL;
+    }
+    // the slots of getPoolStats, aligned so that no two slots share a cache line
+    if (status == RC_OK && posix_memalign((void **)&bp_mgmt->statSlots, STAT_SLOT_ALIGNMENT,
+                                          sizeof(StatSlot) * STAT_SLOTS) != 0)
+    {
+        bp_mgmt->statSlots = NULL;
+        status = RC_MEMORY_ALLOCATION_FAIL;
+    }
+    if (bp_mgmt->statSlots != NULL)
+    {
+        memset(bp_mgmt->statSlots, 0, sizeof(StatSlot) * STAT_SLOTS);
+    }
+
+    // The compressed tier is created before the shards, which keep the entries reserved for their frames
+    if (status == RC_OK && options != NULL && options->compressedTierPages > 0)
+    {
+        bp_mgmt->compressedTier = compressedTierCreate((size_t)options->compressedTierPages * bp_mgmt->pageSize,
+                                                       bp_mgmt->pageSize);
+        if (bp_mgmt->compressedTier == NULL)
+        {
+            status = RC_MEMORY_ALLOCATION_FAIL;
+        }
+    }
+
+    // Spread the shards over the NUMA nodes, there are no more nodes in use than shards
+    bp_mgmt->numaPlacement = options != NULL && options->numaPlacement && numShards > 1;
+    if (bp_mgmt->numaPlacement && status == RC_OK)
+    {
+        bp_mgmt->numNodes = onlineNodes(bp_mgmt->nodeIds);
+        if (bp_mgmt->numNodes > numShards)
+        {
+            bp_mgmt->numNodes = numShards;
+        }
+        bp_mgmt->numExtents = 2 * files[0].handle.totalNumPages / SHARD_EXTENT_PAGES + MIN_PLACED_EXTENTS;
+        bp_mgmt->extentShards = (int *)malloc(sizeof(int) * bp_mgmt->numExtents);
+        if (bp_mgmt->extentShards == NULL)
+        {
+            status = RC_MEMORY_ALLOCATION_FAIL;
+        }
+        for (int i = 0; i < bp_mgmt->numExtents && status == RC_OK; i++)
+        {
+            bp_mgmt->extentShards[i] = NO_SHARD;
+        }
+    }
+
+    double dirtyRatio = (options != NULL && options->dirtyRatio > 0) ? options->dirtyRatio : DEFAULT_DIRTY_RATIO;
+    int firstFrame = 0;
+    for (int i = 0; i < numShards && status == RC_OK; i++)
+    {
+        int shardFrames = numPages / numShards + (i < numPages % numShards ? 1 : 0);
+        int shardMaxFrames = maxPages / numShards + (i < maxPages % numShards ? 1 : 0);
+        BM_BufferPool_Mgmt *shard = i == 0 ? bp_mgmt : (BM_BufferPool_Mgmt *)calloc(1, sizeof(BM_BufferPool_Mgmt));
+        if (shard == NULL)
+        {
+            status = RC_MEMORY_ALLOCATION_FAIL;
+            break;
+        }
+        bp_mgmt->shards[i] = shard;
+        int numaNode = bp_mgmt->numaPlacement ? bp_mgmt->nodeIds[i % bp_mgmt->numNodes] : -1;
+        status = initShard(shard, bp_mgmt, shardFrames, shardMaxFrames, firstFrame, numaNode, replacementData,
+                           dirtyRatio);
+        firstFrame += shardFrames;
+    }
+    if (status != RC_OK)
+    {
+        closePageFile(&bp_mgmt->files[0].handle);
+        freeShards(bp_mgmt);
+        free(fileName);
+        return status;
+    }
+
+    // Read ahead may use at most half the frames of a shard, so a scan does not push out all other pages
+    bp_mgmt->readAheadPages = options != NULL ? options->readAheadPages : 0;
+    bp_mgmt->readAheadMax = bp_mgmt->readAheadPages;
+    if (bp_mgmt->readAheadMax > numPages / numShards / 2)
+    {
+        bp_mgmt->readAheadMax = numPages / numShards / 2;
+    }
+
+    // A hot set file that is there has to be one, so that saving the hot set cannot overwrite another file
+    if (bp_mgmt->trackUses)
+    {
+        bp_mgmt->hotSetFile = strdup(options->hotSetFile);
+        bp_mgmt->checkpointNanos = bp_mgmt->concurrent ? options->checkpointSeconds * 1000000000LL : 0;
+        status = bp_mgmt->hotSetFile != NULL ? readHotSet(bp_mgmt) : RC_MEMORY_ALLOCATION_FAIL;
+        if (status != RC_OK)
+        {
+            closePageFile(&bp_mgmt->files[0].handle);
+            freeShards(bp_mgmt);
+            free(fileName);
+            return status;
+        }
+    }
+
+    // The trace is written to its file by a thread of its own, see buffer_trace.c
+    if (options != NULL && options->traceFile != NULL)
+    {
+        bp_mgmt->trace = traceWriterCreate(options->traceFile, numPages);
+        if (bp_mgmt->trace == NULL)
+        {
+            closePageFile(&bp_mgmt->files[0].handle);
+            freeShards(bp_mgmt);
+            free(fileName);
+            return RC_WRITE_FAILED;
+        }
+    }
+
+    // Every shard has its own page cleaner
+    for (int i = 0; i < numShards && backgroundFlush; i++)
+    {
+        if (startPageCleaner(bp_mgmt->shards[i]) != RC_OK)
+        {
+            for (int j = 0; j < i; j++)
+            {
+                stopPageCleaner(bp_mgmt->shards[j]);
+            }
+            if (bp_mgmt->trace != NULL)
+            {
+                traceWriterDestroy(bp_mgmt->trace);
+            }
+            closePageFile(&bp_mgmt->files[0].handle);
+            freeShards(bp_mgmt);
+            free(fileName);
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+    }
+
+    // The hot set is loaded last, in the background it is read next to the first pins
+    if (bp_mgmt->trackUses &&
+        startWarm(bp_mgmt, bp_mgmt->concurrent && options->warmInBackground) != RC_OK)
+    {
+        for (int i = 0; i < numShards && backgroundFlush; i++)
+        {
+            stopPageCleaner(bp_mgmt->shards[i]);
+        }
+        if (bp_mgmt->trace != NULL)
+        {
+            traceWriterDestroy(bp_mgmt->trace);
+        }
+        closePageFile(&bp_mgmt->files[0].handle);
+        freeShards(bp_mgmt);
+        free(fileName);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // Initialize buffer pool structure
+    // Set the number of pages
+    bm->numPages = numPages;
+    // Store the page file name
+    bm->pageFile = fileName;
+    // Set the replacement strategy
+    bm->strategy = strategy;
+    // Set the management data
+    bm->mgmtData = bp_mgmt;
+    // The handle works on the file the pool was created with
+    bm->fileId = 0;
+
+    return RC_OK;
+}
+
+/*
+    # This function shuts down the buffer pool and frees associated resources.
+    # No other thread may use the pool while or after it is shut down.
+    # A handle of a file opened with openPoolFile only closes that file, see closePoolFile. The pool
+      itself is shut down with the handle it was created with, once the other files are closed,
+      otherwise RC_INVALID_INPUT is returned.
+*/
+RC shutdownBufferPool(BM_BufferPool *const bm)
+{
+    // Load the management data of the buffer pool
+    if (bm == NULL || bm->mgmtData == NULL)
+    {
+        // Return if buffer pool or management data is invalid
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *bp_mgmt = (BM_BufferPool_Mgmt *)bm->mgmtData;
+
+    if (bm->fileId != 0)
+    {
+        return closePoolFile(bm);
+    }
+    // Their handles would be left pointing to a pool that is gone
+    for (int i = 1; i < bp_mgmt->maxFiles; i++)
+    {
+        if (bp_mgmt->files[i].open)
+        {
+            return RC_INVALID_INPUT;
+        }
+    }
+
+    // Stop the page cleaners and the warm thread first, the flush below writes whatever the cleaners left dirty
+    for (int i = 0; i < bp_mgmt->numShards; i++)
+    {
+        stopPageCleaner(bp_mgmt->shards[i]);
+    }
+    stopWarm(bp_mgmt);
+
+    RC status = forceFlushPool(bm);
+    if (status != RC_OK)
+    {
+        // Return error if flush fails
+        return status;
+    }
+
+    // The pages still resident are the hot set of the next pool
+    if (bp_mgmt->hotSetFile != NULL && writeHotSet(bp_mgmt) != RC_OK)
+    {
+        status = RC_WRITE_FAILED;
+    }
+
+    // Close the page file that was opened by initBufferPool
+    closePageFile(&bp_mgmt->files[0].handle);
+
+    // Write the rest of the trace, the pool is gone even if that fails
+    if (bp_mgmt->trace != NULL && traceWriterDestroy(bp_mgmt->trace) != 0)
+    {
+        status = RC_WRITE_FAILED;
+    }
+
+    // Free the frames, the page tables and the management structures of all shards
+    freeShards(bp_mgmt);
+    free(bm->pageFile);
+
+    // Set all buffer pool values to 0 or NULL
+    bm->numPages = 0;
+    bm->mgmtData = NULL;
+    bm->pageFile = NULL;
+
+    return status;
+}
+
+// drops one pin of the frame, never letting the fix count go below zero
+static void releaseFix(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    int count = ATOMIC_LOAD(&mgmt->fixCounts[frame]);
+
+    while (count > 0 && !__atomic_compare_exchange_n(&mgmt->fixCounts[frame], &count, count - 1,
+                                                     false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        // count was reloaded by the failed exchange, try again
+    }
+}
+
+// sets the dirty flag of the frame, waking up the page cleaner when the pool reaches its threshold
+static void setDirty(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (ATOMIC_EXCHANGE(&mgmt->dirtyFlags[frame], true))
+    {
+        return;
+    }
+
+    // only the markDirty that reaches the threshold signals, the cleaner checks the count before it sleeps
+    if (ATOMIC_ADD(&mgmt->dirtyCount, 1) == ATOMIC_LOAD(&mgmt->cleanerThreshold) && mgmt->cleanerRunning)
+    {
+        long long latchedAt = 0;
+        if (mgmt->profileLatches)
+            latchedAt = mutexLatchProfiled(mgmt, &mgmt->cleanerLatch, BM_LATCH_CLEANER);
+        else
+            pthread_mutex_lock(&mgmt->cleanerLatch);
+        pthread_cond_signal(&mgmt->cleanerWake);
+        if (mgmt->profileLatches)
+            latchReleased(mgmt, BM_LATCH_CLEANER, latchedAt);
+        pthread_mutex_unlock(&mgmt->cleanerLatch);
+    }
+}
+
+// clears the dirty flag of the frame and returns whether it was set
+static bool clearDirty(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (!ATOMIC_EXCHANGE(&mgmt->dirtyFlags[frame], false))
+    {
+        return false;
+    }
+    ATOMIC_ADD(&mgmt->dirtyCount, -1);
+    return true;
+}
+
+/*
+    # Writes the page held by the frame back to the page file and marks the frame clean.
+    # The caller has the frame pinned or holds the page table latch exclusively, so the page
+      cannot be replaced while it is written.
+*/
+static RC writeBackFrame(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    RC status = RC_OK;
+
+    frameLatchAcquire(mgmt, frame);
+
+    // another thread may have written the page while we waited for the frame latch,
+    // the flag is cleared before the page is copied out so a concurrent markDirty is not lost
+    if (clearDirty(mgmt, frame))
+    {
+        int file = mgmt->fileIds[frame];
+        growFile(mgmt, file, mgmt->pageNums[frame] + 1);
+
+        blockIOLatchAcquire(mgmt);
+        long long start = clockNanos();
+        status = writeBlock(mgmt->pageNums[frame], fileOf(mgmt, file), frameDataOf(mgmt, frame));
+        recordLatency(mgmt, HISTOGRAM_WRITE, clockNanos() - start);
+        blockIOLatchRelease(mgmt);
+
+        if (status == RC_OK)
+        {
+            ATOMIC_ADD(&mgmt->getNumWriteIO, 1);
+        }
+        else
+        {
+            setDirty(mgmt, frame);
+        }
+    }
+
+    frameLatchRelease(mgmt, frame);
+    return status == RC_OK ? RC_OK : RC_WRITE_FAILED;
+}
+
+/*
+    # Writes back the frame if it holds the dirty page pageNum of the file.
+    # A clean page may still be on its way to disk from the page cleaner, which holds the frame
+      latch while it writes, so the flush waits for that write to finish before it returns.
+*/
+static RC flushFrame(BM_BufferPool_Mgmt *mgmt, int frame, int file, PageNumber pageNum)
+{
+    tableLatchShared(mgmt);
+    if (ATOMIC_LOAD(&mgmt->frameStates[frame]) != FRAME_VALID ||
+        mgmt->pageNums[frame] != pageNum || mgmt->fileIds[frame] != file)
+    {
+        tableLatchRelease(mgmt);
+        return RC_OK;
+    }
+    if (!ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+    {
+        tableLatchRelease(mgmt);
+        if (mgmt->cleanerRunning)
+        {
+            frameLatchAcquire(mgmt, frame);
+            frameLatchRelease(mgmt, frame);
+        }
+        return RC_OK;
+    }
+
+    // pin the frame so it cannot be replaced while it is written
+    ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+    tableLatchRelease(mgmt);
+
+    RC status = writeBackFrame(mgmt, frame);
+    releaseFix(mgmt, frame);
+    return status;
+}
+
+// orders flush entries by file and by page number within a file
+static int compareFlushEntries(const void *a, const void *b)
+{
+    const FlushEntry *x = (const FlushEntry *)a;
+    const FlushEntry *y = (const FlushEntry *)b;
+    if (x->file != y->file)
+    {
+        return (x->file > y->file) - (x->file < y->file);
+    }
+    return (x->pageNum > y->pageNum) - (x->pageNum < y->pageNum);
+}
+
+/*
+    # Pins the frame and records it in entry if it holds a dirty page nobody is using.
+    # The caller holds the page table latch shared.
+*/
+static bool collectDirtyFrame(BM_BufferPool_Mgmt *mgmt, int frame, FlushEntry *entry)
+{
+    if (ATOMIC_LOAD(&mgmt->frameStates[frame]) != FRAME_VALID || !ATOMIC_LOAD(&mgmt->dirtyFlags[frame]) ||
+        ATOMIC_LOAD(&mgmt->fixCounts[frame]) != 0)
+    {
+        return false;
+    }
+
+    // pin the frame so it cannot be replaced before it is written
+    ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+    entry->file = mgmt->fileIds[frame];
+    entry->pageNum = mgmt->pageNums[frame];
+    entry->frame = frame;
+    return true;
+}
+
+// bits of the frames in the block of count frames from first that hold a dirty page nobody is using
+static uint64_t dirtyUnpinnedMaskOf(BM_BufferPool_Mgmt *mgmt, int first, int count)
+{
+    return flagMaskOf(&mgmt->dirtyFlags[first], count) & unpinnedMaskOf(&mgmt->fixCounts[first], count);
+}
+
+/*
+    # Writes back the collected frames in page number order, so the file is written sequentially,
+      every run of adjacent pages with one request and up to MAX_WRITE_BATCH runs of the same file
+      with one call to submitBlocks.
+    # The frames of a batch are latched in file and page number order, which every batch uses, and their
+      dirty flags are cleared before the pages are copied out, as in writeBackFrame.
+    # The frames were pinned by collectDirtyFrame, the pins are released here.
+*/
+static RC writeBackFrames(BM_BufferPool_Mgmt *mgmt, FlushEntry *entries, int count)
+{
+    SM_IORequest requests[MAX_WRITE_BATCH];
+    int batchFrames[MAX_WRITE_BATCH * MAX_WRITE_RUN];
+    SM_PageHandle batchData[MAX_WRITE_BATCH * MAX_WRITE_RUN];
+    RC result = RC_OK;
+    int i = 0;
+
+    qsort(entries, count, sizeof(FlushEntry), compareFlushEntries);
+
+    while (i < count)
+    {
+        int numRequests = 0;
+        int numFrames = 0;
+        PageNumber lastPage = NO_PAGE;
+        int file = entries[i].file;
+
+        // latch the frames of the next runs, a page is the start of a new run unless it follows the
+        // last page of the current one, the pages of the next file start the next batch
+        for (; i < count && entries[i].file == file; i++)
+        {
+            PageNumber pageNum = entries[i].pageNum;
+            int frame = entries[i].frame;
+            bool startsRun = lastPage == NO_PAGE || pageNum != lastPage + 1 ||
+                             requests[numRequests - 1].numPages == MAX_WRITE_RUN;
+            if (startsRun && numRequests == MAX_WRITE_BATCH)
+            {
+                break;
+            }
+
+            frameLatchAcquire(mgmt, frame);
+            if (!clearDirty(mgmt, frame))
+            {
+                // another thread wrote the page while we waited, which ends the run here
+                frameLatchRelease(mgmt, frame);
+                releaseFix(mgmt, frame);
+                lastPage = NO_PAGE;
+                continue;
+            }
+
+            if (startsRun)
+            {
+                requests[numRequests].pageNum = pageNum;
+                requests[numRequests].numPages = 0;
+                requests[numRequests].memPages = &batchData[numFrames];
+                requests[numRequests].write = 1;
+                numRequests++;
+            }
+            requests[numRequests - 1].numPages++;
+            batchFrames[numFrames] = frame;
+            batchData[numFrames] = frameDataOf(mgmt, frame);
+            numFrames++;
+            lastPage = pageNum;
+        }
+        if (numRequests == 0)
+        {
+            continue;
+        }
+
+        // the runs are sorted, so the last one ends at the highest page
+        SM_IORequest *last = &requests[numRequests - 1];
+        RC status = growFile(mgmt, file, last->pageNum + last->numPages);
+
+        if (status == RC_OK)
+        {
+            blockIOLatchAcquire(mgmt);
+            long long start = clockNanos();
+            submitBlocks(fileOf(mgmt, file), requests, numRequests);
+            recordLatency(mgmt, HISTOGRAM_WRITE, clockNanos() - start);
+            blockIOLatchRelease(mgmt);
+        }
+
+        int frame = 0;
+        for (int r = 0; r < numRequests; r++)
+        {
+            bool written = status == RC_OK && requests[r].status == RC_OK;
+            if (written)
+            {
+                ATOMIC_ADD(&mgmt->getNumWriteIO, requests[r].numPages);
+            }
+            else
+            {
+                result = RC_WRITE_FAILED;
+            }
+            for (int j = 0; j < requests[r].numPages; j++, frame++)
+            {
+                if (!written)
+                {
+                    setDirty(mgmt, batchFrames[frame]);
+                }
+                frameLatchRelease(mgmt, batchFrames[frame]);
+                releaseFix(mgmt, batchFrames[frame]);
+            }
+        }
+    }
+    return result;
+}
+
+// writes back the dirty pages of the file that nobody is using in all shards
+static RC flushFile(BM_BufferPool_Mgmt *bp_mgmt, int file)
+{
+    FlushEntry *entries = malloc(sizeof(FlushEntry) * bp_mgmt->maxPages);
+    if (entries == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    RC status = RC_OK;
+    for (int s = 0; s < bp_mgmt->numShards; s++)
+    {
+        BM_BufferPool_Mgmt *shard = bp_mgmt->shards[s];
+
+        // Walk the dense frame arrays a block at a time and collect the dirty pages nobody is using
+        int count = 0;
+        tableLatchShared(shard);
+        for (int first = 0; first < shard->numFrames; first += SCAN_BLOCK_FRAMES)
+        {
+            int blockFrames = shard->numFrames - first < SCAN_BLOCK_FRAMES ? shard->numFrames - first : SCAN_BLOCK_FRAMES;
+            for (uint64_t dirty = dirtyUnpinnedMaskOf(shard, first, blockFrames); dirty != 0; dirty &= dirty - 1)
+            {
+                int i = first + __builtin_ctzll(dirty);
+                if (shard->fileIds[i] == file && collectDirtyFrame(shard, i, &entries[count]))
+                {
+                    count++;
+                }
+            }
+        }
+        tableLatchRelease(shard);
+
+        if (writeBackFrames(shard, entries, count) != RC_OK)
+        {
+            status = RC_WRITE_FAILED;
+        }
+
+        // A clean page may still be on its way to disk from the page cleaner, which holds the
+        // frame latch while it writes, so wait for those writes before returning
+        if (shard->cleanerRunning)
+        {
+            int numFrames = ATOMIC_LOAD(&shard->numFrames);
+            for (int i = 0; i < numFrames; i++)
+            {
+                frameLatchAcquire(shard, i);
+                frameLatchRelease(shard, i);
+            }
+        }
+    }
+    free(entries);
+
+    return status;
+}
+
+/*
+    This function flushes any dirty pages of the file of the handle to disk, which is every dirty
+    page unless other files were opened in the pool with openPoolFile.
+*/
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    // Check for valid buffer pool and management data
+    if (bm == NULL || bm->mgmtData == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    return flushFile(bm->mgmtData, bm->fileId);
+}
+
+// frames the page cleaner or the warm thread may pin at once, at least one
+static int backgroundPinLimit(BM_BufferPool_Mgmt *mgmt)
+{
+    int limit = mgmt->numFrames / BACKGROUND_PIN_SHARE;
+    return limit > 0 ? limit : 1;
+}
+
+// writes back up to wanted dirty unpinned frames from the cursor on, returns the number it collected
+static int cleanDirtyBatch(BM_BufferPool_Mgmt *mgmt, int wanted)
+{
+    int count = 0;
+
+    tableLatchShared(mgmt);
+    if (wanted > backgroundPinLimit(mgmt))
+    {
+        wanted = backgroundPinLimit(mgmt);
+    }
+    for (int remaining = mgmt->numFrames; remaining > 0 && count < wanted;)
+    {
+        // the block ends at the last frame or at the frame the sweep started from, the cursor starts
+        // over if the pool shrank past it
+        int first = mgmt->cleanerCursor < mgmt->numFrames ? mgmt->cleanerCursor : 0;
+        int blockFrames = mgmt->numFrames - first;
+        if (blockFrames > remaining)
+        {
+            blockFrames = remaining;
+        }
+        if (blockFrames > SCAN_BLOCK_FRAMES)
+        {
+            blockFrames = SCAN_BLOCK_FRAMES;
+        }
+
+        // the cursor stops after the frame that fills the batch
+        int passed = blockFrames;
+        for (uint64_t dirty = dirtyUnpinnedMaskOf(mgmt, first, blockFrames); dirty != 0 && count < wanted;
+             dirty &= dirty - 1)
+        {
+            int frame = first + __builtin_ctzll(dirty);
+            if (collectDirtyFrame(mgmt, frame, &mgmt->cleanerBatch[count]) && ++count == wanted)
+            {
+                passed = frame - first + 1;
+            }
+        }
+        remaining -= passed;
+        mgmt->cleanerCursor = (first + passed) % mgmt->numFrames;
+    }
+    tableLatchRelease(mgmt);
+
+    // write errors are left to the eviction or flush that finds the page still dirty
+    writeBackFrames(mgmt, mgmt->cleanerBatch, count);
+    return count;
+}
+
+// writes back dirty unpinned frames batch by batch until the pool is below the low water mark
+static int cleanDirtyFrames(BM_BufferPool_Mgmt *mgmt)
+{
+    int wanted = ATOMIC_LOAD(&mgmt->dirtyCount) - ATOMIC_LOAD(&mgmt->cleanerThreshold) / 2;
+    int cleaned = 0;
+    int count = 0;
+
+    // a batch that finds nothing to write ends the pass, the rest is pinned
+    do
+    {
+        count = cleanDirtyBatch(mgmt, wanted - cleaned);
+        cleaned += count;
+    } while (count > 0 && cleaned < wanted);
+    return cleaned;
+}
+
+// body of the page cleaner thread
+static void *pageCleaner(void *arg)
+{
+    BM_BufferPool_Mgmt *mgmt = (BM_BufferPool_Mgmt *)arg;
+    bool idle = false;
+
+    pthread_mutex_lock(&mgmt->cleanerLatch);
+    while (!mgmt->cleanerStop)
+    {
+        if (ATOMIC_LOAD(&mgmt->dirtyCount) < ATOMIC_LOAD(&mgmt->cleanerThreshold))
+        {
+            pthread_cond_wait(&mgmt->cleanerWake, &mgmt->cleanerLatch);
+            continue;
+        }
+        if (idle)
+        {
+            // the last pass found only pinned dirty pages, look again after a while
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += CLEANER_RETRY_MS * 1000000L;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&mgmt->cleanerWake, &mgmt->cleanerLatch, &until);
+            idle = false;
+            continue;
+        }
+
+        pthread_mutex_unlock(&mgmt->cleanerLatch);
+        idle = cleanDirtyFrames(mgmt) == 0;
+        pthread_mutex_lock(&mgmt->cleanerLatch);
+    }
+    pthread_mutex_unlock(&mgmt->cleanerLatch);
+    return NULL;
+}
+
+static RC startPageCleaner(BM_BufferPool_Mgmt *mgmt)
+{
+    mgmt->cleanerBatch = malloc(sizeof(FlushEntry) * mgmt->maxFrames);
+    if (mgmt->cleanerBatch == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    pthread_mutex_init(&mgmt->cleanerLatch, NULL);
+    pthread_cond_init(&mgmt->cleanerWake, NULL);
+    mgmt->cleanerStop = false;
+    mgmt->cleanerRunning = true;
+
+    if (pthread_create(&mgmt->cleanerThread, NULL, pageCleaner, mgmt) != 0)
+    {
+        mgmt->cleanerRunning = false;
+        pthread_mutex_destroy(&mgmt->cleanerLatch);
+        pthread_cond_destroy(&mgmt->cleanerWake);
+        free(mgmt->cleanerBatch);
+        mgmt->cleanerBatch = NULL;
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    return RC_OK;
+}
+
+// stops the page cleaner and waits for its last write to finish
+static void stopPageCleaner(BM_BufferPool_Mgmt *mgmt)
+{
+    if (!mgmt->cleanerRunning)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&mgmt->cleanerLatch);
+    mgmt->cleanerStop = true;
+    pthread_cond_signal(&mgmt->cleanerWake);
+    pthread_mutex_unlock(&mgmt->cleanerLatch);
+    pthread_join(mgmt->cleanerThread, NULL);
+
+    mgmt->cleanerRunning = false;
+    pthread_mutex_destroy(&mgmt->cleanerLatch);
+    pthread_cond_destroy(&mgmt->cleanerWake);
+    free(mgmt->cleanerBatch);
+    mgmt->cleanerBatch = NULL;
+}
+
+// Buffer Manager Interface Access Pages
+
+// whether the handle is a read only pin pointing into the mapped page file, which holds no frame
+// mgmt is the shard of the page
+static bool isMappedPin(BM_BufferPool_Mgmt *mgmt, const BM_PageHandle *page)
+{
+    return mgmt->mappedStorage && (page->data < mgmt->frameData ||
+                                   page->data >= mgmt->frameData + (size_t)mgmt->maxFrames * mgmt->pageSize);
+}
+
+/* This function is used to mark a page dirty when it is modified by the user and it is set to 1  */
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // check if the page is present in the buffer pool and get the management info of the buffer pool
+    BM_BufferPool_Mgmt *bp_mgmt;
+    bp_mgmt = shardOf(bm->mgmtData, bm->fileId, page->pageNum);
+    traceOp(bp_mgmt, bm->fileId, page->pageNum, BM_TRACE_DIRTY);
+
+    // a read only pin pointing into the mapped page file holds no frame
+    if (isMappedPin(bp_mgmt, page))
+    {
+        return RC_OK;
+    }
+
+    // look up the frame holding the page in the page table
+    tableLatchShared(bp_mgmt);
+    int frame = pageTableLookup(bp_mgmt, bm->fileId, page->pageNum);
+
+    if (frame != NO_FRAME)
+    {
+        // mark the page as dirty
+        setDirty(bp_mgmt, frame);
+    }
+    tableLatchRelease(bp_mgmt);
+
+    return RC_OK;
+}
+
+/* This function is used to unpin a page from the buffer pool when it is no longer in use by the user means it is set to free
+this method called as "unpinning" a page in the buffer pool */
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // check if the page is present in the buffer pool and get the management info of the buffer pool
+    BM_BufferPool_Mgmt *bp_mgmt;
+    bp_mgmt = shardOf(bm->mgmtData, bm->fileId, page->pageNum);
+    traceOp(bp_mgmt, bm->fileId, page->pageNum, BM_TRACE_UNPIN);
+
+    // a read only pin into the mapped page file must not drop the pin of a frame loaded since
+    if (isMappedPin(bp_mgmt, page))
+    {
+        return RC_OK;
+    }
+
+    // look up the frame holding the page in the page table
+    tableLatchShared(bp_mgmt);
+    int frame = pageTableLookup(bp_mgmt, bm->fileId, page->pageNum);
+
+    if (frame != NO_FRAME)
+    {
+        // decrement the fix count
+        releaseFix(bp_mgmt, frame);
+    }
+    tableLatchRelease(bp_mgmt);
+
+    return RC_OK;
+}
+
+/*
+    # Unpins numPages pages pinned with pinPages or pinPage, looking all of them up under one
+      shared page table latch, or one per run of handles in the same shard in a sharded pool.
+*/
+RC unpinPages(BM_BufferPool *const bm, BM_PageHandle *const handles, const int numPages)
+{
+    if (bm == NULL || bm->mgmtData == NULL || numPages < 0 || (numPages > 0 && handles == NULL))
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *latched = NULL;
+
+    for (int i = 0; i < numPages; i++)
+    {
+        BM_BufferPool_Mgmt *shard = shardOf(bm->mgmtData, bm->fileId, handles[i].pageNum);
+        traceOp(shard, bm->fileId, handles[i].pageNum, BM_TRACE_UNPIN);
+        if (shard != latched)
+        {
+            if (latched != NULL)
+            {
+                tableLatchRelease(latched);
+            }
+            tableLatchShared(shard);
+            latched = shard;
+        }
+
+        if (isMappedPin(shard, &handles[i]))
+        {
+            continue;
+        }
+        int frame = pageTableLookup(shard, bm->fileId, handles[i].pageNum);
+        if (frame != NO_FRAME)
+        {
+            releaseFix(shard, frame);
+        }
+    }
+    if (latched != NULL)
+    {
+        tableLatchRelease(latched);
+    }
+
+    return RC_OK;
+}
+
+/* This function is used to pin a page passed to it in BM_PageHandle and writes back to the disk file
+    when it is no longer in use by the user means it is set to free */
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    // check if the page is present in the buffer pool and get the management info of the buffer pool
+    BM_BufferPool_Mgmt *bp_mgmt;
+    bp_mgmt = shardOf(bm->mgmtData, bm->fileId, page->pageNum);
+
+    // look up the frame holding the page in the page table
+    tableLatchShared(bp_mgmt);
+    int frame = pageTableLookup(bp_mgmt, bm->fileId, page->pageNum);
+    tableLatchRelease(bp_mgmt);
+
+    // check if the page is resident and its dirty flag is set to 1 and write it back
+    if (frame != NO_FRAME && flushFrame(bp_mgmt, frame, bm->fileId, page->pageNum) != RC_OK)
+    {
+        return RC_WRITE_FAILED;
+    }
+
+    return RC_OK;
+}
+
+/*
+    # Pins a resident frame and tells the replacement policy about the hit.
+    # Only needs the page table latch shared, the fix count is updated atomically and the policy
+      either handles concurrent hits itself or is called under the replacement latch.
+*/
+static void pinResidentFrame(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    const BM_ReplacementPolicy *policy = mgmt->policy;
+
+    ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+
+    if (policy->onHit == NULL)
+    {
+        return;
+    }
+    if (mgmt->concurrent && !policy->concurrentHits)
+    {
+        replacementLatchAcquire(mgmt);
+        policy->onHit(mgmt->policyState, frame);
+        replacementLatchRelease(mgmt);
+    }
+    else
+    {
+        policy->onHit(mgmt->policyState, frame);
+    }
+}
+
+/*
+    # The hit path of pools with optimisticHits, it takes no latch. Walks the chain of pageNum of the
+      file with atomic loads, pins the frame holding it and validates the pin: the version of the frame
+      has to be even and unchanged, so the frame held the page all along.
+    # Returns the pinned frame, or NO_FRAME if the page was not found or the frame was changing, in
+      which case the caller takes the latched path.
+*/
+static int pinOptimistic(BM_BufferPool_Mgmt *mgmt, int file, PageNumber pageNum)
+{
+    // chains may change while they are walked, a walk longer than the pool has frames gives up
+    int frame = ATOMIC_LOAD(&mgmt->pageTable[pageTableBucket(mgmt, file, pageNum)]);
+    for (int steps = 0; frame != NO_FRAME && (ATOMIC_LOAD(&mgmt->pageNums[frame]) != pageNum ||
+                                              ATOMIC_LOAD(&mgmt->fileIds[frame]) != file); steps++)
+    {
+        if (steps == mgmt->maxFrames)
+        {
+            return NO_FRAME;
+        }
+        frame = ATOMIC_LOAD(&mgmt->hashNext[frame]);
+    }
+    if (frame == NO_FRAME)
+    {
+        return NO_FRAME;
+    }
+
+    unsigned version = ATOMIC_LOAD(&mgmt->frameVersions[frame]);
+    if ((version & 1) != 0 || ATOMIC_LOAD(&mgmt->pageNums[frame]) != pageNum ||
+        ATOMIC_LOAD(&mgmt->fileIds[frame]) != file)
+    {
+        return NO_FRAME;
+    }
+
+    // the pin and the check of the version pair with the claim in assignFrame
+    __atomic_add_fetch(&mgmt->fixCounts[frame], 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&mgmt->frameVersions[frame], __ATOMIC_SEQ_CST) != version)
+    {
+        releaseFix(mgmt, frame);
+        return NO_FRAME;
+    }
+
+    if (mgmt->policy->onHit != NULL)
+    {
+        mgmt->policy->onHit(mgmt->policyState, frame);
+    }
+    return frame;
+}
+
+/*
+    # Completes a pin of a frame found in the page table: waits until a concurrent load of the
+      page has finished and fills in the page handle.
+*/
+static RC finishPin(BM_BufferPool_Mgmt *mgmt, int frame, BM_PageHandle *const page)
+{
+    if (ATOMIC_LOAD(&mgmt->frameStates[frame]) == FRAME_LOADING)
+    {
+        long long start = clockNanos();
+        frameLatchAcquire(mgmt, frame);
+        while (mgmt->frameStates[frame] == FRAME_LOADING)
+        {
+            frameLatchWaitLoaded(mgmt, frame);
+        }
+        frameLatchRelease(mgmt, frame);
+        countStat(mgmt, STAT_IO_STALL_NANOS, clockNanos() - start);
+    }
+
+    // the thread loading the page failed to read it
+    if (ATOMIC_LOAD(&mgmt->frameStates[frame]) != FRAME_VALID)
+    {
+        releaseFix(mgmt, frame);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    page->pageNum = mgmt->pageNums[frame];
+    page->data = frameDataOf(mgmt, frame);
+    return RC_OK;
+}
+
+/*
+    # Drops the page of a frame whose read failed and the pin of the thread that loaded it,
+      leaving the frame empty so it is not mistaken for the page.
+*/
+static void emptyFrame(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    tableLatchExclusive(mgmt);
+    frameChangeBegin(mgmt, frame);
+    pageTableRemove(mgmt, frame);
+    ATOMIC_STORE(&mgmt->pageNums[frame], NO_PAGE);
+    frameChangeEnd(mgmt, frame);
+    if (mgmt->policy->onEmpty != NULL)
+    {
+        mgmt->policy->onEmpty(mgmt->policyState, frame);
+    }
+    tableLatchRelease(mgmt);
+    releaseFix(mgmt, frame);
+}
+
+/*
+    # Compresses the page a frame gave up into the compressed tier, if assignFrame reserved an entry
+      for it. Called under the frame latch before the frame is overwritten, it still holds the page.
+*/
+static void spillFrame(BM_BufferPool_Mgmt *mgmt, int frame)
+{
+    if (mgmt->spillEntries != NULL && mgmt->spillEntries[frame] != BM_NO_TIER_ENTRY)
+    {
+        compressedTierFill(mgmt->root->compressedTier, mgmt->spillEntries[frame], frameDataOf(mgmt, frame));
+        mgmt->spillEntries[frame] = BM_NO_TIER_ENTRY;
+    }
+}
+
+// decompresses pageNum of the file into the frame if the compressed tier holds it
+static bool takeCompressed(BM_BufferPool_Mgmt *mgmt, int file, PageNumber pageNum, int frame)
+{
+    BM_CompressedTier *tier = mgmt->root->compressedTier;
+    return tier != NULL && compressedTierTake(tier, file, pageNum, frameDataOf(mgmt, frame));
+}
+
+/*
+    # Reads pageNum of the file into a frame that was just assigned to it and marked FRAME_LOADING.
+    # Only the frame latch is held during the read, threads pinning the same page wait for it.
+*/
+static RC loadFrame(BM_BufferPool_Mgmt *mgmt, int frame, BM_PageHandle *const page, int file,
+                    const PageNumber pageNum)
+{
+    frameLatchAcquire(mgmt, frame);
+    spillFrame(mgmt, frame);
+
+    // a page of the compressed tier is decompressed instead of read
+    RC status = RC_OK;
+    bool compressed = takeCompressed(mgmt, file, pageNum, frame);
+    if (!compressed)
+    {
+        // check if the pageFile has the required number of pages if not create those pages
+        growFile(mgmt, file, pageNum + 1);
+
+        // read the block into pageFrame data
+        blockIOLatchAcquire(mgmt);
+        long long start = clockNanos();
+        status = readBlock(pageNum, fileOf(mgmt, file), frameDataOf(mgmt, frame));
+        recordLatency(mgmt, HISTOGRAM_READ, clockNanos() - start);
+        blockIOLatchRelease(mgmt);
+    }
+
+    ATOMIC_STORE(&mgmt->frameStates[frame], status == RC_OK ? FRAME_VALID : FRAME_EMPTY);
+    if (mgmt->concurrent)
+    {
+        pthread_cond_broadcast(&mgmt->frameLoaded[frame]);
+    }
+    frameLatchRelease(mgmt, frame);
+
+    if (status != RC_OK)
+    {
+        emptyFrame(mgmt, frame);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    // increment the num of read operations
+    if (!compressed)
+    {
+        ATOMIC_ADD(&mgmt->getNumReadIO, 1);
+    }
+
+    page->pageNum = pageNum;
+    page->data = frameDataOf(mgmt, frame);
+    return RC_OK;
+}
+
+// returns the next free frame while the buffer pool is not yet full, NO_FRAME otherwise
+static int takeFreeFrame(BM_BufferPool_Mgmt *mgmt)
+{
+    if (mgmt->occupiedFrameCount >= mgmt->numFrames)
+    {
+        return NO_FRAME;
+    }
+
+    // frames are filled in order, head moves to the next empty space
+    int frame = mgmt->head;
+    mgmt->head = (frame + 1) % mgmt->numFrames;
+    mgmt->occupiedFrameCount++;
+    return frame;
+}
+
+/*
+    # Moves a free frame or a clean victim over to pageNum of the file in the page table, pinned and loading.
+    # The caller holds the page table latch exclusively.
+    # Returns false and leaves the frame alone if an optimistic pinner pinned it after it was picked.
+*/
+static bool assignFrame(BM_BufferPool_Mgmt *mgmt, int frame, int file, const PageNumber pageNum)
+{
+    int unpinned = 0;
+
+    frameChangeBegin(mgmt, frame);
+    if (!__atomic_compare_exchange_n(&mgmt->fixCounts[frame], &unpinned, 1, false, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_SEQ_CST))
+    {
+        frameChangeEnd(mgmt, frame);
+        return false;
+    }
+
+    if (mgmt->pageNums[frame] != NO_PAGE)
+    {
+        countStat(mgmt, STAT_EVICTIONS, 1);
+        if (mgmt->policy->onEvict != NULL)
+        {
+            mgmt->policy->onEvict(mgmt->policyState, frame, pageKeyOf(mgmt->fileIds[frame], mgmt->pageNums[frame]));
+        }
+        // the loader of the frame compresses the clean page into the tier before it overwrites it
+        if (mgmt->spillEntries != NULL && ATOMIC_LOAD(&mgmt->frameStates[frame]) == FRAME_VALID &&
+            !ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+        {
+            mgmt->spillEntries[frame] =
+                compressedTierReserve(mgmt->root->compressedTier, mgmt->fileIds[frame], mgmt->pageNums[frame]);
+        }
+    }
+    pageTableRemove(mgmt, frame);
+    ATOMIC_STORE(&mgmt->fileIds[frame], file);
+    ATOMIC_STORE(&mgmt->pageNums[frame], pageNum);
+    ATOMIC_STORE(&mgmt->dirtyFlags[frame], false);
+    ATOMIC_STORE(&mgmt->prefetched[frame], false);
+    ATOMIC_STORE(&mgmt->frameStates[frame], FRAME_LOADING);
+    if (mgmt->trackUses)
+    {
+        __atomic_store_n(&mgmt->useCounts[frame], 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&mgmt->lastUses[frame], clockNanos(), __ATOMIC_RELAXED);
+    }
+    pageTableInsert(mgmt, frame);
+    frameChangeEnd(mgmt, frame);
+
+    if (mgmt->policy->onInsert != NULL)
+    {
+        mgmt->policy->onInsert(mgmt->policyState, frame, pageKeyOf(file, pageNum));
+    }
+    return true;
+}
+
+/*
+    # Reads the pages of the file into the given frames, which were assigned to them by assignFrame,
+      and drops the pins of assignFrame. The pages are sorted, every run of adjacent pages is one request and
+      all runs are read with one call to submitBlocks. Pages the compressed tier holds are taken from it
+      instead and split the runs.
+    # If loaded is given, the pins of the pages that were read are kept for the caller and loaded[i]
+      tells whether page i was read. A frame whose read failed is emptied either way.
+*/
+static RC readFrames(BM_BufferPool_Mgmt *mgmt, int file, const int *frames, const PageNumber *pages, int count,
+                     bool *loaded)
+{
+    SM_IORequest requests[MAX_READ_RUN];
+    SM_PageHandle data[MAX_READ_RUN];
+    int requestOf[MAX_READ_RUN]; // request reading each page, -1 for a page of the compressed tier
+    int numRequests = 0;
+    int numData = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        frameLatchAcquire(mgmt, frames[i]);
+        spillFrame(mgmt, frames[i]);
+        if (takeCompressed(mgmt, file, pages[i], frames[i]))
+        {
+            requestOf[i] = -1;
+            continue;
+        }
+        data[numData] = frameDataOf(mgmt, frames[i]);
+
+        if (i == 0 || requestOf[i - 1] < 0 || pages[i] != pages[i - 1] + 1)
+        {
+            requests[numRequests].pageNum = pages[i];
+            requests[numRequests].numPages = 0;
+            requests[numRequests].memPages = &data[numData];
+            requests[numRequests].write = 0;
+            numRequests++;
+        }
+        requests[numRequests - 1].numPages++;
+        requestOf[i] = numRequests - 1;
+        numData++;
+    }
+
+    RC result = RC_OK;
+    if (numRequests > 0)
+    {
+        blockIOLatchAcquire(mgmt);
+        long long start = clockNanos();
+        result = submitBlocks(fileOf(mgmt, file), requests, numRequests);
+        recordLatency(mgmt, HISTOGRAM_READ, clockNanos() - start);
+        blockIOLatchRelease(mgmt);
+    }
+
+    for (int r = 0; r < numRequests; r++)
+    {
+        if (requests[r].status == RC_OK)
+        {
+            ATOMIC_ADD(&mgmt->getNumReadIO, requests[r].numPages);
+        }
+    }
+    for (int i = 0; i < count; i++)
+    {
+        int f = frames[i];
+        bool read = requestOf[i] < 0 || requests[requestOf[i]].status == RC_OK;
+        ATOMIC_STORE(&mgmt->frameStates[f], read ? FRAME_VALID : FRAME_EMPTY);
+        if (mgmt->concurrent)
+        {
+            pthread_cond_broadcast(&mgmt->frameLoaded[f]);
+        }
+        frameLatchRelease(mgmt, f);
+        if (loaded != NULL)
+        {
+            loaded[i] = read;
+        }
+        if (!read)
+        {
+            emptyFrame(mgmt, f);
+        }
+        else if (loaded == NULL)
+        {
+            releaseFix(mgmt, f);
+        }
+    }
+    return result == RC_OK ? RC_OK : RC_READ_NON_EXISTING_PAGE;
+}
+
+/*
+    # Writes back the dirty victim picked for pageNum of the file and assigns it to the page.
+    # The caller holds the page table latch exclusively and pinned the victim, so that nobody
+      replaces it while the latch is released for the write. The pin is dropped here.
+    # Returns false if the write failed, setting status to RC_WRITE_FAILED, or if the victim was
+      pinned or dirtied again or the page got loaded meanwhile, the caller then looks again.
+*/
+static bool replaceDirtyVictim(BM_BufferPool_Mgmt *mgmt, int frame, int file, PageNumber pageNum, RC *status)
+{
+    tableLatchRelease(mgmt);
+    long long start = clockNanos();
+    *status = writeBackFrame(mgmt, frame);
+    countStat(mgmt, STAT_IO_STALL_NANOS, clockNanos() - start);
+    tableLatchExclusive(mgmt);
+    releaseFix(mgmt, frame);
+
+    if (*status == RC_OK && !ATOMIC_LOAD(&mgmt->dirtyFlags[frame]) &&
+        pageTableLookup(mgmt, file, pageNum) == NO_FRAME && assignFrame(mgmt, frame, file, pageNum))
+    {
+        countStat(mgmt, STAT_DIRTY_EVICTIONS, 1);
+        return true;
+    }
+    return false;
+}
+
+/*
+    # Reads the pages of startPage to startPage + numPages - 1 of the file that are not resident,
+      every run of adjacent pages with one request, see readFrames.
+    # Pages past the end of the file are left out, and so is the rest of the range once no free
+      frame or victim is left. A dirty victim ends the part of the range read together, it is
+      written back before it takes the next page, as the policy has already moved past it.
+    # Returns the number of pages from startPage on that are resident or being loaded afterwards.
+*/
+static int loadPages(BM_BufferPool_Mgmt *mgmt, int file, PageNumber startPage, int numPages, RC *status)
+{
+    int filePages = filePagesOf(mgmt, file);
+    if (numPages > filePages - startPage)
+    {
+        numPages = filePages - startPage;
+    }
+
+    int covered = 0;
+    bool full = false;
+    int dirtyVictim = NO_FRAME;
+    *status = RC_OK;
+
+    while (covered < numPages && !full)
+    {
+        int frames[MAX_READ_RUN];
+        PageNumber pages[MAX_READ_RUN];
+        int assigned = 0;
+
+        // assign frames to the missing pages of the next part of the range
+        tableLatchExclusive(mgmt);
+        for (; covered < numPages && assigned < MAX_READ_RUN; covered++)
+        {
+            PageNumber pageNum = startPage + covered;
+            if (pageTableLookup(mgmt, file, pageNum) != NO_FRAME)
+            {
+                if (dirtyVictim != NO_FRAME)
+                {
+                    releaseFix(mgmt, dirtyVictim);
+                    dirtyVictim = NO_FRAME;
+                }
+                continue;
+            }
+
+            int frame = dirtyVictim;
+            dirtyVictim = NO_FRAME;
+            if (frame != NO_FRAME)
+            {
+                // the dirty victim left over from the last part, a failed write ends the range
+                RC writeStatus;
+                if (!replaceDirtyVictim(mgmt, frame, file, pageNum, &writeStatus))
+                {
+                    if (writeStatus != RC_OK)
+                    {
+                        full = true;
+                        break;
+                    }
+                    // pinned or dirtied again meanwhile, the page looks for another frame
+                    covered--;
+                    continue;
+                }
+            }
+            else
+            {
+                frame = takeFreeFrame(mgmt);
+                if (frame == NO_FRAME)
+                {
+                    frame = mgmt->policy->pickVictim(mgmt->policyState, mgmt->fixCounts, pageKeyOf(file, pageNum));
+                }
+                if (frame != NO_FRAME && ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+                {
+                    // written back once the pages assigned so far are read, pinned until then
+                    ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+                    dirtyVictim = frame;
+                    break;
+                }
+                if (frame == NO_FRAME || !assignFrame(mgmt, frame, file, pageNum))
+                {
+                    full = true;
+                    break;
+                }
+            }
+            // the page was not asked for by a pin yet, its first hit is a prefetch hit
+            ATOMIC_STORE(&mgmt->prefetched[frame], true);
+            frames[assigned] = frame;
+            pages[assigned] = pageNum;
+            assigned++;
+        }
+        tableLatchRelease(mgmt);
+
+        // resident pages split the range into several runs, which are read together
+        if (assigned > 0 && readFrames(mgmt, file, frames, pages, assigned, NULL) != RC_OK)
+        {
+            *status = RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+    return covered;
+}
+
+/*
+    # Same as loadPages for a range that may cover the extents of several shards, every extent is
+      loaded into its own shard.
+    # Returns the number of pages from startPage on that are resident or being loaded afterwards.
+*/
+static int loadRange(BM_BufferPool_Mgmt *root, int file, PageNumber startPage, int numPages, RC *status)
+{
+    if (root->numShards == 1)
+    {
+        return loadPages(root, file, startPage, numPages, status);
+    }
+
+    int covered = 0;
+    *status = RC_OK;
+
+    while (covered < numPages)
+    {
+        PageNumber pageNum = startPage + covered;
+        int length = SHARD_EXTENT_PAGES - pageNum % SHARD_EXTENT_PAGES;
+        if (length > numPages - covered)
+        {
+            length = numPages - covered;
+        }
+
+        RC extentStatus;
+        int loaded = loadPages(shardOf(root, file, pageNum), file, pageNum, length, &extentStatus);
+        if (extentStatus != RC_OK)
+        {
+            *status = extentStatus;
+        }
+        covered += loaded;
+
+        // the end of the file or a shard without a free or clean frame ends the range
+        if (loaded < length)
+        {
+            break;
+        }
+    }
+    return covered;
+}
+
+/*
+    # Called on a miss of pageNum of the file, detects sequential scans and reads the missing page
+      together with the read ahead window of pages after it. The state is kept in the registry entry
+      of the file in the root, as a scan moves through the extents of all shards.
+    # The detection state is only a hint, concurrent scans of a file can reset each other's window.
+*/
+static void readAhead(BM_BufferPool_Mgmt *mgmt, int file, const PageNumber pageNum)
+{
+    PoolFile *poolFile = &mgmt->files[file];
+    PageNumber expected = ATOMIC_EXCHANGE(&poolFile->nextSequentialPage, pageNum + 1);
+    if (pageNum != expected)
+    {
+        ATOMIC_STORE(&poolFile->readAheadWindow, 0);
+        return;
+    }
+
+    // the window grows while the scan continues
+    int window = ATOMIC_LOAD(&poolFile->readAheadWindow);
+    window = window == 0 ? READ_AHEAD_MIN_PAGES : 2 * window;
+    // resizeBufferPool changes the largest window with the size of the pool
+    int readAheadMax = ATOMIC_LOAD(&mgmt->readAheadMax);
+    if (window > readAheadMax)
+    {
+        window = readAheadMax;
+    }
+    ATOMIC_STORE(&poolFile->readAheadWindow, window);
+
+    // a failed read leaves the page to the normal miss path, which reports the error
+    RC status;
+    int covered = loadRange(mgmt, file, pageNum, window + 1, &status);
+    if (covered > 1)
+    {
+        ATOMIC_STORE(&poolFile->nextSequentialPage, pageNum + covered);
+    }
+}
+
+/*
+    # Pins pageNum of the file, which was not found in the page table.
+    # Under the exclusive page table latch it picks a free frame or a victim, writing back a dirty
+      victim first, and assigns the frame to the page in the FRAME_LOADING state.
+    # victim is a dirty victim the caller already picked for the page and pinned, or NO_FRAME. It is
+      used before the policy is asked, which already moved past it.
+    # The disk read then happens outside the page table latch.
+*/
+static RC pinMissingPage(BM_BufferPool_Mgmt *mgmt, BM_PageHandle *const page, int file, const PageNumber pageNum,
+                         int victim)
+{
+    int frame;
+
+    tableLatchExclusive(mgmt);
+    for (;;)
+    {
+        // another thread or the read ahead of this miss may have loaded the page while the page
+        // table latch was not held, the pin still counts as a miss
+        frame = pageTableLookup(mgmt, file, pageNum);
+        if (frame != NO_FRAME)
+        {
+            if (victim != NO_FRAME)
+            {
+                releaseFix(mgmt, victim);
+            }
+            ATOMIC_STORE(&mgmt->prefetched[frame], false);
+            pinResidentFrame(mgmt, frame);
+            tableLatchRelease(mgmt);
+            return finishPin(mgmt, frame, page);
+        }
+
+        if (victim != NO_FRAME)
+        {
+            frame = victim;
+            victim = NO_FRAME;
+        }
+        else
+        {
+            // check if the buffer pool is not full and pin the page in empty space else use page replacement strategy
+            frame = takeFreeFrame(mgmt);
+            if (frame == NO_FRAME)
+            {
+                frame = mgmt->policy->pickVictim(mgmt->policyState, mgmt->fixCounts, pageKeyOf(file, pageNum));
+            }
+            if (frame == NO_FRAME)
+            {
+                tableLatchRelease(mgmt);
+                return RC_BM_NO_FREE_FRAME;
+            }
+            if (!ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+            {
+                if (assignFrame(mgmt, frame, file, pageNum))
+                {
+                    break;
+                }
+                // pinned by an optimistic pinner in the meantime, pick another frame
+                continue;
+            }
+
+            // before replacing a dirty page write it back to disk, keeping it pinned so that it is
+            // not replaced by anyone else while the page table latch is released for the write
+            ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+        }
+
+        RC status;
+        if (replaceDirtyVictim(mgmt, frame, file, pageNum, &status))
+        {
+            break;
+        }
+        if (status != RC_OK)
+        {
+            tableLatchRelease(mgmt);
+            return RC_WRITE_FAILED;
+        }
+    }
+    tableLatchRelease(mgmt);
+
+    long long start = clockNanos();
+    RC status = loadFrame(mgmt, frame, page, file, pageNum);
+    countStat(mgmt, STAT_IO_STALL_NANOS, clockNanos() - start);
+    return status;
+}
+
+// pins a page of a file of the pool like pinPage, without timing the pin
+static RC pinPageOf(BM_BufferPool_Mgmt *root, BM_PageHandle *const page, int file, const PageNumber pageNum)
+{
+    // the page is looked up in its shard only
+    BM_BufferPool_Mgmt *bp_mgmt = shardOf(root, file, pageNum);
+    countNodeAccess(bp_mgmt);
+
+    // an optimistic hit needs no latch at all
+    if (bp_mgmt->optimisticHits)
+    {
+        int frame = pinOptimistic(bp_mgmt, file, pageNum);
+        if (frame != NO_FRAME)
+        {
+            countHit(bp_mgmt, frame);
+            return finishPin(bp_mgmt, frame, page);
+        }
+    }
+
+    // a buffer hit only needs the page table latch in shared mode
+    tableLatchShared(bp_mgmt);
+    int frame = pageTableLookup(bp_mgmt, file, pageNum);
+    if (frame != NO_FRAME)
+    {
+        pinResidentFrame(bp_mgmt, frame);
+        tableLatchRelease(bp_mgmt);
+        countHit(bp_mgmt, frame);
+        return finishPin(bp_mgmt, frame, page);
+    }
+    tableLatchRelease(bp_mgmt);
+    countStat(bp_mgmt, STAT_MISSES, 1);
+
+    // a miss that continues a sequential scan reads the page together with the pages after it
+    if (ATOMIC_LOAD(&root->readAheadMax) > 0)
+    {
+        long long start = clockNanos();
+        readAhead(root, file, pageNum);
+        countStat(bp_mgmt, STAT_IO_STALL_NANOS, clockNanos() - start);
+    }
+
+    return pinMissingPage(bp_mgmt, page, file, pageNum, NO_FRAME);
+}
+
+/* This function is used to put the page in the buffer pool and each page is put in page frame which is put into bufferPool and this method called as "pinning" a page in the buffer pool*/
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL || pageNum < 0)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *root = bm->mgmtData;
+    traceOp(root, bm->fileId, pageNum, BM_TRACE_PIN);
+    if (!root->timePins)
+    {
+        return pinPageOf(root, page, bm->fileId, pageNum);
+    }
+
+    long long start = clockNanos();
+    RC status = pinPageOf(root, page, bm->fileId, pageNum);
+    recordLatency(root, HISTOGRAM_PIN, clockNanos() - start);
+    return status;
+}
+
+// a page asked for by pinPages, the index of its handle and the index of its shard
+typedef struct PinEntry
+{
+    PageNumber pageNum;
+    int handle;
+    int shard;
+} PinEntry;
+
+// orders pin entries by shard and by page number within a shard
+static int comparePinEntries(const void *a, const void *b)
+{
+    const PinEntry *x = (const PinEntry *)a;
+    const PinEntry *y = (const PinEntry *)b;
+    if (x->shard != y->shard)
+    {
+        return (x->shard > y->shard) - (x->shard < y->shard);
+    }
+    return (x->pageNum > y->pageNum) - (x->pageNum < y->pageNum);
+}
+
+/*
+    # Assigns frames to the missing pages of entries, in page number order, and reads them with one
+      call to readFrames, storing the frame pinned for each handle in frames.
+    # Stops at MAX_READ_RUN pages or at a page that finds no clean frame, which is pinned like
+      pinPage, writing back the dirty victim the policy picked for it.
+    # Returns the number of entries handled and sets status if a page could not be pinned.
+*/
+static int pinMissingPages(BM_BufferPool_Mgmt *mgmt, int file, BM_PageHandle *const handles, const PinEntry *entries,
+                           int count, int *frames, RC *status)
+{
+    int loadFrames[MAX_READ_RUN];
+    PageNumber pages[MAX_READ_RUN];
+    int handleOf[MAX_READ_RUN];
+    bool loaded[MAX_READ_RUN];
+    int assigned = 0;
+    int next = 0;
+    bool needsVictim = false;
+    int dirtyVictim = NO_FRAME;
+
+    tableLatchExclusive(mgmt);
+    for (; next < count && assigned < MAX_READ_RUN; next++)
+    {
+        PageNumber pageNum = entries[next].pageNum;
+        int h = entries[next].handle;
+
+        // loaded since the hits were resolved, or asked for twice
+        int frame = pageTableLookup(mgmt, file, pageNum);
+        if (frame != NO_FRAME)
+        {
+            ATOMIC_STORE(&mgmt->prefetched[frame], false);
+            pinResidentFrame(mgmt, frame);
+            frames[h] = frame;
+            continue;
+        }
+
+        frame = takeFreeFrame(mgmt);
+        if (frame == NO_FRAME)
+        {
+            frame = mgmt->policy->pickVictim(mgmt->policyState, mgmt->fixCounts, pageKeyOf(file, pageNum));
+        }
+        if (frame == NO_FRAME || ATOMIC_LOAD(&mgmt->dirtyFlags[frame]) || !assignFrame(mgmt, frame, file, pageNum))
+        {
+            // the policy has moved past a dirty victim, it is kept pinned for pinMissingPage
+            if (frame != NO_FRAME && ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+            {
+                ATOMIC_ADD(&mgmt->fixCounts[frame], 1);
+                dirtyVictim = frame;
+            }
+            needsVictim = true;
+            break;
+        }
+        loadFrames[assigned] = frame;
+        pages[assigned] = pageNum;
+        handleOf[assigned] = h;
+        assigned++;
+    }
+    tableLatchRelease(mgmt);
+
+    if (assigned > 0)
+    {
+        long long start = clockNanos();
+        readFrames(mgmt, file, loadFrames, pages, assigned, loaded);
+        countStat(mgmt, STAT_IO_STALL_NANOS, clockNanos() - start);
+        for (int i = 0; i < assigned; i++)
+        {
+            if (loaded[i])
+            {
+                frames[handleOf[i]] = loadFrames[i];
+            }
+            else
+            {
+                *status = RC_READ_NON_EXISTING_PAGE;
+            }
+        }
+    }
+
+    if (needsVictim)
+    {
+        int h = entries[next].handle;
+        RC pinStatus = pinMissingPage(mgmt, &handles[h], file, entries[next].pageNum, dirtyVictim);
+        if (pinStatus == RC_OK)
+        {
+            frames[h] = (int)((handles[h].data - mgmt->frameData) / mgmt->pageSize);
+        }
+        else
+        {
+            *status = pinStatus;
+        }
+        next++;
+    }
+    return next;
+}
+
+/*
+    # Pins numPages pages at once, handles[i] gets the page pageNums[i]. A page asked for more than
+      once is pinned as many times.
+    # The hits are pinned under one shared page table latch. The misses are sorted by page number,
+      get their frames under one exclusive latch per MAX_READ_RUN pages and are read together, every
+      run of adjacent pages with one request (see readFrames). In a sharded pool this happens for
+      each shard the pages belong to.
+    # Either all pages are pinned or, if one of them cannot be, none of them.
+*/
+RC pinPages(BM_BufferPool *const bm, BM_PageHandle *const handles, const PageNumber *pageNums, const int numPages)
+{
+    if (bm == NULL || bm->mgmtData == NULL || numPages < 0 || (numPages > 0 && (handles == NULL || pageNums == NULL)))
+    {
+        return RC_INVALID_INPUT;
+    }
+    for (int i = 0; i < numPages; i++)
+    {
+        if (pageNums[i] < 0)
+        {
+            return RC_INVALID_INPUT;
+        }
+    }
+    if (numPages == 0)
+    {
+        return RC_OK;
+    }
+
+    BM_BufferPool_Mgmt *root = bm->mgmtData;
+    int *frames = (int *)malloc(sizeof(int) * numPages);
+    PinEntry *misses = (PinEntry *)malloc(sizeof(PinEntry) * numPages);
+    if (frames == NULL || misses == NULL)
+    {
+        free(frames);
+        free(misses);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // pin the hits, the frames of the misses are found below, the latch of a shard is kept while
+    // consecutive pages belong to it
+    int numMisses = 0;
+    PageNumber lastMiss = NO_PAGE;
+    BM_BufferPool_Mgmt *latched = NULL;
+    for (int i = 0; i < numPages; i++)
+    {
+        int shardIndex = shardIndexOf(root, bm->fileId, pageNums[i]);
+        BM_BufferPool_Mgmt *shard = root->shards[shardIndex];
+        traceOp(root, bm->fileId, pageNums[i], BM_TRACE_PIN);
+        countNodeAccess(shard);
+        if (shard != latched)
+        {
+            if (latched != NULL)
+            {
+                tableLatchRelease(latched);
+            }
+            tableLatchShared(shard);
+            latched = shard;
+        }
+
+        frames[i] = pageTableLookup(shard, bm->fileId, pageNums[i]);
+        if (frames[i] != NO_FRAME)
+        {
+            pinResidentFrame(shard, frames[i]);
+            countHit(shard, frames[i]);
+        }
+        else
+        {
+            misses[numMisses].pageNum = pageNums[i];
+            misses[numMisses].handle = i;
+            misses[numMisses].shard = shardIndex;
+            numMisses++;
+            if (pageNums[i] > lastMiss)
+            {
+                lastMiss = pageNums[i];
+            }
+        }
+    }
+    tableLatchRelease(latched);
+
+    RC status = RC_OK;
+    if (numMisses > 0)
+    {
+        countStat(root, STAT_MISSES, numMisses);
+        qsort(misses, numMisses, sizeof(PinEntry), comparePinEntries);
+
+        // add the pages past the end of the file at once, as pinPage would one by one
+        growFile(root, bm->fileId, lastMiss + 1);
+
+        // the misses of a shard are next to each other after sorting
+        for (int first = 0; first < numMisses;)
+        {
+            int end = first;
+            while (end < numMisses && misses[end].shard == misses[first].shard)
+            {
+                end++;
+            }
+            BM_BufferPool_Mgmt *shard = root->shards[misses[first].shard];
+            for (int done = first; done < end;)
+            {
+                done += pinMissingPages(shard, bm->fileId, handles, &misses[done], end - done, frames, &status);
+            }
+            first = end;
+        }
+    }
+
+    // wait for pages other threads are loading and fill in the handles
+    for (int i = 0; i < numPages; i++)
+    {
+        if (frames[i] != NO_FRAME && finishPin(shardOf(root, bm->fileId, pageNums[i]), frames[i], &handles[i]) != RC_OK)
+        {
+            frames[i] = NO_FRAME;
+            status = RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+
+    // drop the pins already taken if any page could not be pinned
+    if (status != RC_OK)
+    {
+        for (int i = 0; i < numPages; i++)
+        {
+            if (frames[i] != NO_FRAME)
+            {
+                releaseFix(shardOf(root, bm->fileId, pageNums[i]), frames[i]);
+            }
+        }
+    }
+
+    free(frames);
+    free(misses);
+    return status;
+}
+
+/*
+    # Pins a page the caller only reads, it must neither modify the page nor mark it dirty.
+    # With the SM_BACKEND_MMAP storage backend a page that is not resident is not read into a frame,
+      the handle points straight into the mapping of the page file and no read I/O is counted.
+      A resident page is pinned in its frame, as it may be newer than the file.
+    # Otherwise the same as pinPage, the pin is released with unpinPage either way.
+*/
+static RC pinPageReadOnlyOf(BM_BufferPool_Mgmt *root, BM_PageHandle *const page, int file, const PageNumber pageNum)
+{
+    BM_BufferPool_Mgmt *bp_mgmt = shardOf(root, file, pageNum);
+    if (!bp_mgmt->mappedStorage)
+    {
+        return pinPageOf(root, page, file, pageNum);
+    }
+
+    tableLatchShared(bp_mgmt);
+    int frame = pageTableLookup(bp_mgmt, file, pageNum);
+    if (frame != NO_FRAME)
+    {
+        // a pin into the mapping is not counted, the page cache is not bound to the node of the shard
+        countNodeAccess(bp_mgmt);
+        pinResidentFrame(bp_mgmt, frame);
+        tableLatchRelease(bp_mgmt);
+        countHit(bp_mgmt, frame);
+        return finishPin(bp_mgmt, frame, page);
+    }
+
+    // a frame is written back before it is given to another page, so while the page table latch
+    // is held the file has the latest content of every page that is not resident
+    char *data;
+    fileLatchAcquire(bp_mgmt);
+    RC status = mapBlock(pageNum, fileOf(bp_mgmt, file), &data);
+    fileLatchRelease(bp_mgmt);
+    tableLatchRelease(bp_mgmt);
+
+    // pages past the end of the file are added by a normal pin
+    if (status != RC_OK)
+    {
+        return pinPageOf(root, page, file, pageNum);
+    }
+
+    countStat(bp_mgmt, STAT_MISSES, 1);
+    page->pageNum = pageNum;
+    page->data = data;
+    return RC_OK;
+}
+
+// pins a page the caller only reads, see pinPageReadOnlyOf, timing the pin with the timePins option
+RC pinPageReadOnly(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL || pageNum < 0)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *root = bm->mgmtData;
+    traceOp(root, bm->fileId, pageNum, BM_TRACE_PIN);
+    if (!root->timePins)
+    {
+        return pinPageReadOnlyOf(root, page, bm->fileId, pageNum);
+    }
+
+    long long start = clockNanos();
+    RC status = pinPageReadOnlyOf(root, page, bm->fileId, pageNum);
+    recordLatency(root, HISTOGRAM_PIN, clockNanos() - start);
+    return status;
+}
+
+/*
+    # Reads the pages startPage to startPage + numPages - 1 into the pool ahead of their pins,
+      every run of adjacent missing pages with one disk read.
+    # It is a hint: pages past the end of the file are skipped, and so is the rest of the range
+      once no free or clean frame is left, no dirty page is written back to make room.
+*/
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber startPage, const int numPages)
+{
+    if (bm == NULL || bm->mgmtData == NULL || startPage < 0 || numPages < 0)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    RC status;
+    loadRange(bm->mgmtData, bm->fileId, startPage, numPages, &status);
+    return status;
+}
+
+// ------------- Warm Restart -------------
+
+// the hottest entry first: the most uses, then the shortest idle time
+static int compareHotSetEntries(const void *a, const void *b)
+{
+    const HotSetEntry *x = (const HotSetEntry *)a;
+    const HotSetEntry *y = (const HotSetEntry *)b;
+    if (x->uses != y->uses)
+    {
+        return x->uses > y->uses ? -1 : 1;
+    }
+    return (x->idleNanos > y->idleNanos) - (x->idleNanos < y->idleNanos);
+}
+
+static int compareHotSetPages(const void *a, const void *b)
+{
+    const HotSetEntry *x = (const HotSetEntry *)a;
+    const HotSetEntry *y = (const HotSetEntry *)b;
+    return (x->pageNum > y->pageNum) - (x->pageNum < y->pageNum);
+}
+
+static int compareHotSetIdle(const void *a, const void *b)
+{
+    const HotSetEntry *x = (const HotSetEntry *)a;
+    const HotSetEntry *y = (const HotSetEntry *)b;
+    return (x->idleNanos > y->idleNanos) - (x->idleNanos < y->idleNanos);
+}
+
+/*
+    # Reads the hot set file of the pool into warmEntries, keeping the pages that fit into the frames
+      of their shards and exist in the page file, sorted by page number. The hot set only holds pages
+      of the file the pool was created with, file 0.
+    # A missing file is an empty hot set, a file that is not a hot set is rejected with RC_INVALID_INPUT.
+*/
+static RC readHotSet(BM_BufferPool_Mgmt *root)
+{
+    FILE *file = fopen(root->hotSetFile, "rb");
+    HotSetHeader header;
+
+    if (file == NULL)
+    {
+        return RC_OK;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, HOT_SET_MAGIC, sizeof(header.magic)) != 0 ||
+        header.entrySize != sizeof(HotSetEntry))
+    {
+        fclose(file);
+        return RC_INVALID_INPUT;
+    }
+
+    HotSetEntry *entries = (HotSetEntry *)malloc(sizeof(HotSetEntry) * (header.numEntries > 0 ? header.numEntries : 1));
+    int *taken = (int *)calloc(root->numShards, sizeof(int));
+    if (entries == NULL || taken == NULL)
+    {
+        free(entries);
+        free(taken);
+        fclose(file);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    if (fread(entries, sizeof(HotSetEntry), header.numEntries, file) != header.numEntries)
+    {
+        free(entries);
+        free(taken);
+        fclose(file);
+        return RC_INVALID_INPUT;
+    }
+    fclose(file);
+
+    // every shard keeps the best ranked pages of its own its frames can hold
+    qsort(entries, header.numEntries, sizeof(HotSetEntry), compareHotSetEntries);
+    int filePages = filePagesOf(root, 0);
+    int kept = 0;
+    for (uint32_t i = 0; i < header.numEntries; i++)
+    {
+        if (entries[i].pageNum < 0 || entries[i].pageNum >= filePages)
+        {
+            continue;
+        }
+        int shard = shardIndexOf(root, 0, entries[i].pageNum);
+        if (taken[shard] < root->shards[shard]->numFrames)
+        {
+            taken[shard]++;
+            entries[kept++] = entries[i];
+        }
+    }
+    free(taken);
+
+    qsort(entries, kept, sizeof(HotSetEntry), compareHotSetPages);
+    root->warmEntries = entries;
+    root->numWarmEntries = kept;
+    return RC_OK;
+}
+
+/*
+    # Loads the given pages of the hot set, sorted by page number, into free frames of the shard,
+      MAX_READ_RUN of them with each call to readFrames, and carries their uses over. In the warm
+      thread a call pins no more frames than backgroundPinLimit allows, so racing pins still find victims.
+    # Stops at the first page without a free frame or when the pool is shut down.
+*/
+static void warmShard(BM_BufferPool_Mgmt *mgmt, const HotSetEntry *entries, int count, bool background)
+{
+    long long now = clockNanos();
+    int next = 0;
+
+    while (next < count && !ATOMIC_LOAD(&mgmt->root->warmStop))
+    {
+        int frames[MAX_READ_RUN];
+        PageNumber pages[MAX_READ_RUN];
+        int assigned = 0;
+
+        tableLatchExclusive(mgmt);
+        int limit = background && backgroundPinLimit(mgmt) < MAX_READ_RUN ? backgroundPinLimit(mgmt) : MAX_READ_RUN;
+        for (; next < count && assigned < limit; next++)
+        {
+            // already loaded by a pin since the pool was created
+            if (pageTableLookup(mgmt, 0, entries[next].pageNum) != NO_FRAME)
+            {
+                continue;
+            }
+
+            int frame = takeFreeFrame(mgmt);
+            if (frame == NO_FRAME || !assignFrame(mgmt, frame, 0, entries[next].pageNum))
+            {
+                next = count;
+                break;
+            }
+            ATOMIC_STORE(&mgmt->prefetched[frame], true);
+            __atomic_store_n(&mgmt->useCounts[frame], entries[next].uses, __ATOMIC_RELAXED);
+            __atomic_store_n(&mgmt->lastUses[frame], now - entries[next].idleNanos, __ATOMIC_RELAXED);
+            frames[assigned] = frame;
+            pages[assigned] = entries[next].pageNum;
+            assigned++;
+        }
+        tableLatchRelease(mgmt);
+
+        // a page that cannot be read is left out, the hot set is only a hint
+        if (assigned > 0)
+        {
+            readFrames(mgmt, 0, frames, pages, assigned, NULL);
+        }
+    }
+}
+
+// loads the pages of warmEntries, each shard the ones of its own, and frees them
+static void warmPool(BM_BufferPool_Mgmt *root, bool background)
+{
+    HotSetEntry *shardEntries = (HotSetEntry *)malloc(sizeof(HotSetEntry) * (root->numWarmEntries > 0 ? root->numWarmEntries : 1));
+
+    for (int s = 0; s < root->numShards && shardEntries != NULL; s++)
+    {
+        int count = 0;
+        for (int i = 0; i < root->numWarmEntries; i++)
+        {
+            if (shardIndexOf(root, 0, root->warmEntries[i].pageNum) == s)
+            {
+                shardEntries[count++] = root->warmEntries[i];
+            }
+        }
+        warmShard(root->shards[s], shardEntries, count, background);
+    }
+
+    free(shardEntries);
+    free(root->warmEntries);
+    root->warmEntries = NULL;
+    root->numWarmEntries = 0;
+}
+
+/*
+    # Writes the resident pages of file 0 in all shards with their uses and idle times to the hot set
+      file, the most recently used first.
+    # Returns RC_WRITE_FAILED if the file cannot be written, the previous hot set is kept then.
+*/
+static RC writeHotSet(BM_BufferPool_Mgmt *root)
+{
+    // room for the largest size of the pool, a resize may change the shards while they are walked
+    HotSetEntry *entries = (HotSetEntry *)malloc(sizeof(HotSetEntry) * root->maxPages);
+    char *tmpName = (char *)malloc(strlen(root->hotSetFile) + sizeof(HOT_SET_TMP_SUFFIX));
+    if (entries == NULL || tmpName == NULL)
+    {
+        free(entries);
+        free(tmpName);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    long long now = clockNanos();
+    HotSetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HOT_SET_MAGIC, sizeof(header.magic));
+    header.entrySize = sizeof(HotSetEntry);
+
+    for (int s = 0; s < root->numShards; s++)
+    {
+        BM_BufferPool_Mgmt *shard = root->shards[s];
+        tableLatchShared(shard);
+        for (int frame = 0; frame < shard->numFrames; frame++)
+        {
+            PageNumber pageNum = ATOMIC_LOAD(&shard->pageNums[frame]);
+            if (pageNum == NO_PAGE || ATOMIC_LOAD(&shard->fileIds[frame]) != 0 ||
+                ATOMIC_LOAD(&shard->frameStates[frame]) != FRAME_VALID)
+            {
+                continue;
+            }
+            HotSetEntry *entry = &entries[header.numEntries++];
+            entry->pageNum = pageNum;
+            entry->uses = __atomic_load_n(&shard->useCounts[frame], __ATOMIC_RELAXED);
+            entry->idleNanos = now - __atomic_load_n(&shard->lastUses[frame], __ATOMIC_RELAXED);
+        }
+        tableLatchRelease(shard);
+    }
+    qsort(entries, header.numEntries, sizeof(HotSetEntry), compareHotSetIdle);
+
+    strcpy(tmpName, root->hotSetFile);
+    strcat(tmpName, HOT_SET_TMP_SUFFIX);
+    FILE *file = fopen(tmpName, "wb");
+    bool written = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(entries, sizeof(HotSetEntry), header.numEntries, file) == header.numEntries;
+    if (file != NULL && fclose(file) != 0)
+    {
+        written = false;
+    }
+    if (written && rename(tmpName, root->hotSetFile) != 0)
+    {
+        written = false;
+    }
+    if (!written)
+    {
+        remove(tmpName);
+    }
+
+    free(entries);
+    free(tmpName);
+    return written ? RC_OK : RC_WRITE_FAILED;
+}
+
+// body of the warm thread: loads the hot set, then saves it every checkpointNanos until the pool is shut down
+static void *warmThread(void *arg)
+{
+    BM_BufferPool_Mgmt *root = (BM_BufferPool_Mgmt *)arg;
+
+    warmPool(root, true);
+
+    pthread_mutex_lock(&root->warmLatch);
+    while (!root->warmStop && root->checkpointNanos > 0)
+    {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += root->checkpointNanos / 1000000000LL;
+        until.tv_nsec += root->checkpointNanos % 1000000000LL;
+        until.tv_sec += until.tv_nsec / 1000000000L;
+        until.tv_nsec %= 1000000000L;
+
+        if (pthread_cond_timedwait(&root->warmWake, &root->warmLatch, &until) == ETIMEDOUT && !root->warmStop)
+        {
+            // a checkpoint that fails is retried by the next one and by shutdownBufferPool
+            pthread_mutex_unlock(&root->warmLatch);
+            writeHotSet(root);
+            pthread_mutex_lock(&root->warmLatch);
+        }
+    }
+    pthread_mutex_unlock(&root->warmLatch);
+    return NULL;
+}
+
+// loads the hot set read by readHotSet, in the warm thread if asked to or if it has checkpoints to write
+static RC startWarm(BM_BufferPool_Mgmt *root, bool background)
+{
+    if (!background)
+    {
+        warmPool(root, false);
+    }
+    if (!background && root->checkpointNanos == 0)
+    {
+        return RC_OK;
+    }
+
+    root->warmStop = false;
+    pthread_mutex_init(&root->warmLatch, NULL);
+    pthread_cond_init(&root->warmWake, NULL);
+    if (pthread_create(&root->warmThread, NULL, warmThread, root) != 0)
+    {
+        pthread_mutex_destroy(&root->warmLatch);
+        pthread_cond_destroy(&root->warmWake);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    root->warmRunning = true;
+    return RC_OK;
+}
+
+// stops the warm thread, a load that is still going on is left unfinished
+static void stopWarm(BM_BufferPool_Mgmt *root)
+{
+    if (!root->warmRunning)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&root->warmLatch);
+    ATOMIC_STORE(&root->warmStop, true);
+    pthread_cond_signal(&root->warmWake);
+    pthread_mutex_unlock(&root->warmLatch);
+    pthread_join(root->warmThread, NULL);
+
+    pthread_mutex_destroy(&root->warmLatch);
+    pthread_cond_destroy(&root->warmWake);
+    root->warmRunning = false;
+}
+
+/*
+    # Writes the resident pages to the hotSetFile of the pool, which loads them back into the
+      next pool created with the option.
+    # Returns RC_INVALID_INPUT if the pool has no hot set file and RC_WRITE_FAILED if it cannot be written.
+*/
+RC saveHotSet(BM_BufferPool *const bm)
+{
+    if (bm == NULL || bm->mgmtData == NULL || ((BM_BufferPool_Mgmt *)bm->mgmtData)->hotSetFile == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+    return writeHotSet(bm->mgmtData);
+}
+
+// Online Resize
+
+// tells the replacement policy which frames the shard uses now, if it wants to know
+static void resizePolicy(BM_BufferPool_Mgmt *mgmt, int numFrames)
+{
+    if (mgmt->policy->onResize != NULL)
+    {
+        mgmt->policy->onResize(mgmt->policyState, numFrames);
+    }
+}
+
+// hands the memory pages that only hold data of the frames first to last - 1 back to the kernel, locked frames keep them
+static void releaseFrameMemory(BM_BufferPool_Mgmt *mgmt, int first, int last)
+{
+    uintptr_t memPageSize = (uintptr_t)mgmt->frameMemPageSize;
+
+    if (mgmt->framesLocked)
+    {
+        return;
+    }
+    uintptr_t start = ((uintptr_t)frameDataOf(mgmt, first) + memPageSize - 1) & ~(memPageSize - 1);
+    uintptr_t end = (uintptr_t)frameDataOf(mgmt, last) & ~(memPageSize - 1);
+
+    if (start < end)
+    {
+        madvise((void *)start, end - start, MADV_DONTNEED);
+    }
+}
+
+/*
+    # Makes numFrames the size of the shard, the frames past it hold no page and are pinned.
+    # The caller holds the page table latch exclusively.
+*/
+static void setShardSize(BM_BufferPool_Mgmt *mgmt, int numFrames)
+{
+    // the free frames follow the occupied ones, the next one to fill is the first of them
+    if (mgmt->occupiedFrameCount > numFrames)
+    {
+        mgmt->occupiedFrameCount = numFrames;
+    }
+    mgmt->head = mgmt->occupiedFrameCount % numFrames;
+    resizePolicy(mgmt, numFrames);
+    ATOMIC_STORE(&mgmt->numFrames, numFrames);
+}
+
+// hands the frames from the end of the shard up to numFrames - 1 over to it, empty and unpinned
+static void growShard(BM_BufferPool_Mgmt *mgmt, int numFrames)
+{
+    // the frames are not in use yet, so they are faulted in before the latch is taken
+    if (mgmt->root->prefaultFrames)
+    {
+        prefaultFrameMemory(mgmt, ATOMIC_LOAD(&mgmt->numFrames), numFrames);
+    }
+    tableLatchExclusive(mgmt);
+    for (int frame = mgmt->numFrames; frame < numFrames; frame++)
+    {
+        // an optimistic pinner that found the frame before it was given up still drops its own pin
+        ATOMIC_ADD(&mgmt->fixCounts[frame], -1);
+    }
+    setShardSize(mgmt, numFrames);
+    tableLatchRelease(mgmt);
+}
+
+/*
+    # Gives up the frames numFrames to the end of the shard. Their dirty pages are written back
+      first, then all of them are claimed under the exclusive page table latch, as assignFrame
+      claims a victim, and their pages are evicted into the compressed tier, if the pool has one.
+    # Returns RC_BM_NO_FREE_FRAME and leaves the shard as it was if one of them is pinned or was
+      dirtied again after its page was written.
+*/
+static RC shrinkShard(BM_BufferPool_Mgmt *mgmt, int numFrames)
+{
+    int oldFrames = mgmt->numFrames;
+    FlushEntry *entries = (FlushEntry *)malloc(sizeof(FlushEntry) * (oldFrames - numFrames));
+    if (entries == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    int count = 0;
+    tableLatchShared(mgmt);
+    for (int frame = numFrames; frame < oldFrames; frame++)
+    {
+        if (collectDirtyFrame(mgmt, frame, &entries[count]))
+        {
+            count++;
+        }
+    }
+    tableLatchRelease(mgmt);
+
+    RC status = writeBackFrames(mgmt, entries, count);
+    free(entries);
+    if (status != RC_OK)
+    {
+        return status;
+    }
+
+    // claim the frames one after the other, the pin that keeps them out of use afterwards is the claim
+    tableLatchExclusive(mgmt);
+    bool claimed = true;
+    int frame = numFrames;
+    for (; frame < oldFrames && claimed; frame++)
+    {
+        int unpinned = 0;
+        frameChangeBegin(mgmt, frame);
+        claimed = __atomic_compare_exchange_n(&mgmt->fixCounts[frame], &unpinned, 1, false, __ATOMIC_SEQ_CST,
+                                              __ATOMIC_SEQ_CST);
+        if (claimed && ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+        {
+            releaseFix(mgmt, frame);
+            claimed = false;
+        }
+        if (!claimed)
+        {
+            frameChangeEnd(mgmt, frame);
+        }
+    }
+    if (!claimed)
     {
-        // if not found return error
-        return RC_FILE_NOT_FOUND;
+        // frame is one past the frame that could not be claimed
+        for (int i = numFrames; i < frame - 1; i++)
+        {
+            releaseFix(mgmt, i);
+            frameChangeEnd(mgmt, i);
+        }
+        tableLatchRelease(mgmt);
+        return RC_BM_NO_FREE_FRAME;
     }
 
-    // find the page that needs to be written back to the disk file and
-    // check if its dirty flag is set to 1 and write it back
-    do
+    for (frame = numFrames; frame < oldFrames; frame++)
     {
-        if (Frame->pageNum == page->pageNum && Frame->dirtyFlagSignal == 1)
+        if (mgmt->pageNums[frame] != NO_PAGE && mgmt->policy->onEvict != NULL)
         {
-            // check if the write is successful or not and return error if not
-            if (writeBlock(Frame->pageNum, &fHandle, Frame->data) != RC_OK)
-            {
-                closePageFile(&fHandle);
-                return RC_WRITE_FAILED;
-            }
-            // update the number of writes done
-            bp_mgmt->getNumWriteIO++;
-            // set the dirty flag to 0
-            Frame->dirtyFlagSignal = 0;
-            break;
+            mgmt->policy->onEvict(mgmt->policyState, frame, pageKeyOf(mgmt->fileIds[frame], mgmt->pageNums[frame]));
+        }
+        // the pages are clean by now, they go to the compressed tier as those of replaced frames do
+        if (mgmt->spillEntries != NULL && mgmt->pageNums[frame] != NO_PAGE &&
+            ATOMIC_LOAD(&mgmt->frameStates[frame]) == FRAME_VALID)
+        {
+            mgmt->spillEntries[frame] =
+                compressedTierReserve(mgmt->root->compressedTier, mgmt->fileIds[frame], mgmt->pageNums[frame]);
         }
-        // go to next frame if not found
-        Frame = Frame->next;
-    } while (Frame != bp_mgmt->head);
+        pageTableRemove(mgmt, frame);
+        ATOMIC_STORE(&mgmt->pageNums[frame], NO_PAGE);
+        ATOMIC_STORE(&mgmt->frameStates[frame], FRAME_EMPTY);
+        ATOMIC_STORE(&mgmt->prefetched[frame], false);
+        frameChangeEnd(mgmt, frame);
+    }
+    setShardSize(mgmt, numFrames);
+    tableLatchRelease(mgmt);
 
-    //  close the file and return success
-    closePageFile(&fHandle);
+    // nobody can pin the frames any more, so their memory is not needed once their pages are compressed
+    for (frame = numFrames; frame < oldFrames; frame++)
+    {
+        spillFrame(mgmt, frame);
+    }
+    releaseFrameMemory(mgmt, numFrames, oldFrames);
     return RC_OK;
 }
 
-/* This function is used to put the page in the buffer pool and each page is put in page frame which is put into bufferPool and this method called as "pinning" a page in the buffer pool*/
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+// the page cleaner of the shard starts at the same fraction of the frames in use as before
+static void resizeCleanerThreshold(BM_BufferPool_Mgmt *mgmt)
 {
-    // chooes the pinning strategy based on the buffer pool strategy
-    // there are three strategies FIFO, LRU and CLOCK which are implemented in different functions
-    switch (bm->strategy)
-    {
-    case RS_FIFO:
-        pinPageFIFO(bm, page, pageNum);
-        break;
-
-    case RS_LRU:
-        pinPageLRU(bm, page, pageNum);
-        break;
+    int threshold = (int)(mgmt->dirtyRatio * mgmt->numFrames);
 
-    case RS_CLOCK:
-        pinPageCLOCK(bm, page, pageNum);
-        break;
+    if (!mgmt->cleanerRunning)
+    {
+        mgmt->cleanerThreshold = threshold > 0 ? threshold : 1;
+        return;
     }
-    return RC_OK;
+    // the cleaner checks the threshold under its latch, so a pool that is over the new one wakes it up
+    pthread_mutex_lock(&mgmt->cleanerLatch);
+    ATOMIC_STORE(&mgmt->cleanerThreshold, threshold > 0 ? threshold : 1);
+    pthread_cond_signal(&mgmt->cleanerWake);
+    pthread_mutex_unlock(&mgmt->cleanerLatch);
 }
 
-// This function pinPageFIFO is First in First out (FIFO) pinning strategy, In this we have implemented FIFO using queue data structure
-RC pinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+/*
+    # Changes the number of frames of the pool to numPages while other threads keep using it, to
+      at least one frame per shard and at most the maxPages option of the pool. The frames are
+      split over the shards as by initBufferPool.
+    # Growing hands frames reserved when the pool was created over to it. Shrinking writes back and
+      evicts the pages of the frames it gives up, into the compressed tier as any other victim, and
+      returns their memory. If one of those pages is pinned RC_BM_NO_FREE_FRAME is returned, the
+      shards that could not give up their frames keep them.
+    # numPages of bm and of the handles of all files open in the pool is the size of the pool
+      afterwards, also on failure. Only one thread may resize the pool at a time.
+*/
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages)
 {
-    // SM_FileHandle is used to open the page file
-    SM_FileHandle fHandle;
-    // get the management info of the buffer pool
-    BM_BufferPool_Mgmt *bp_mgmt = bm->mgmtData;
-    // this is used to get the head node of the linked list of frames
-    PageFrame *frame = bp_mgmt->head;
-
-    // open the page file
-    openPageFile((char *)bm->pageFile, &fHandle);
-
-    // check if the page is present in the buffer pool and get the management info of the buffer pool
-    do
+    if (bm == NULL || bm->mgmtData == NULL)
     {
-        // check if the pageNum is the same as the page to be pinned
-        if (frame->pageNum == pageNum)
-        {
-            // update the page number
-            page->pageNum = pageNum;
-            // update the page data
-            page->data = frame->data;
-
-            // update the frame and pageNum and increment the fix count
-            frame->pageNum = pageNum;
-            frame->fixCount++;
-            return RC_OK;
-        }
-        // go to next frame if not found
-        frame = frame->next;
-    } while (frame != bp_mgmt->head);
+        return RC_INVALID_INPUT;
+    }
+    BM_BufferPool_Mgmt *root = (BM_BufferPool_Mgmt *)bm->mgmtData;
+    if (numPages < root->numShards || numPages > root->maxPages)
+    {
+        return RC_INVALID_INPUT;
+    }
 
-    // check if the buffer pool is not full and pin the page in empty space else use page replacement strategy
-    if (bp_mgmt->occupiedFrameCount < bm->numPages)
+    RC status = RC_OK;
+    int firstFrame = 0;
+    for (int s = 0; s < root->numShards; s++)
     {
-        frame = bp_mgmt->head;
-        frame->pageNum = pageNum;
+        BM_BufferPool_Mgmt *shard = root->shards[s];
+        int shardFrames = numPages / root->numShards + (s < numPages % root->numShards ? 1 : 0);
 
-        // move the header to next empty space and increment the fixCount
-        if (frame->next != bp_mgmt->head)
+        if (shardFrames > shard->numFrames)
         {
-            bp_mgmt->head = frame->next;
+            growShard(shard, shardFrames);
         }
-        frame->fixCount++;
-        bp_mgmt->occupiedFrameCount++;
-    }
-    else
-    {
-        // replace pages from frame whose fixcount = 0
-        frame = bp_mgmt->tail;
-        do
+        else if (shardFrames < shard->numFrames)
         {
-            // check if the frame is in use  if fixCount > 0
-            if (frame->fixCount != 0)
+            RC shardStatus = shrinkShard(shard, shardFrames);
+            if (shardStatus != RC_OK && status == RC_OK)
             {
-                // update the frame
-                frame = frame->next;
+                status = shardStatus;
             }
-            // go to next frame whoes count is fixCount = 0 and replce the page
-            else
-            {
-                // before replacing check for dirty flag if it is writes back to disk then repclace it
-                if (frame->dirtyFlagSignal == 1)
-                {
-                    // write the block to disk
-                    ensureCapacity(frame->pageNum, &fHandle);
-                    // check if the write is successful or not and return error if not
-                    if (writeBlock(frame->pageNum, &fHandle, frame->data) != RC_OK)
-                    {
-                        closePageFile(&fHandle);
-                        return RC_WRITE_FAILED;
-                    }
-                    bp_mgmt->getNumWriteIO++;
-                }
-
-                // update the frame and pageNum and increment the fix count
-                frame->pageNum = pageNum;
-                frame->fixCount++;
-                // update the tail and move the tail to next frame
-                bp_mgmt->tail = frame->next;
-                bp_mgmt->head = frame;
+        }
+        resizeCleanerThreshold(shard);
 
-                break;
-            }
-        } while (frame != bp_mgmt->head);
+        // the statistics give the frames of the shards one after the other
+        tableLatchExclusive(shard);
+        shard->firstFrame = firstFrame;
+        tableLatchRelease(shard);
+        firstFrame += shard->numFrames;
     }
-
-    // check if the pageFile has the required number of pages if not create those pages
-    ensureCapacity((pageNum + 1), &fHandle);
-
-    // read the block into pageFrame data
-    if (readBlock(pageNum, &fHandle, frame->data) != RC_OK)
+    fileLatchAcquire(root);
+    for (int i = 0; i < root->maxFiles; i++)
     {
-        // if not found return error
-        closePageFile(&fHandle);
-        return RC_READ_NON_EXISTING_PAGE;
+        if (root->files[i].open)
+        {
+            root->files[i].pool->numPages = firstFrame;
+        }
     }
+    fileLatchRelease(root);
 
-    // increment the num of read operations
-    bp_mgmt->getNumReadIO++;
-
-    // update the pageNum and data of the page
-    page->pageNum = pageNum;
-    page->data = frame->data;
-
-    // close the pageFile
-    closePageFile(&fHandle);
-
-    return RC_OK;
+    // Read ahead may use at most half the frames of a shard, as in initBufferPool
+    int readAheadMax = root->readAheadPages;
+    if (readAheadMax > firstFrame / root->numShards / 2)
+    {
+        readAheadMax = firstFrame / root->numShards / 2;
+    }
+    ATOMIC_STORE(&root->readAheadMax, readAheadMax);
+    return status;
 }
 
+// Shared Page Files
+
 /*
-    # Implementation for LRU page Replacement policy.
-    # Keeps track of fic count to see the usage of page.
-    # replaces the pages having fix count as 0.
+    # Evicts the pages of the file from the shard, claiming their frames as assignFrame claims a
+      victim, and leaves the frames empty for the pages of the other files.
+    # Returns RC_BM_NO_FREE_FRAME if a page of the file is pinned or dirty, the other pages of the
+      file are evicted nonetheless.
 */
-
-RC pinPageLRU(BM_BufferPool *const bm, BM_PageHandle *const currPage, const PageNumber pageNum)
+static RC evictFile(BM_BufferPool_Mgmt *mgmt, int file)
 {
-    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
-    PageFrame *frame = (*buffPoolMgmt).head;
-    SM_FileHandle fHandleandler;
-
-    openPageFile((char *)(*bm).pageFile, &fHandleandler);
+    RC status = RC_OK;
 
-    // check if the frame is already in the bufferpool
-    do
+    tableLatchExclusive(mgmt);
+    for (int frame = 0; frame < mgmt->numFrames; frame++)
     {
-        if ((*frame).pageNum == pageNum)
+        if (mgmt->pageNums[frame] == NO_PAGE || mgmt->fileIds[frame] != file)
         {
-            // update the page and frame attributes
-            (*currPage).pageNum = pageNum;
-            (*currPage).data = (*frame).data;
-
-            (*frame).pageNum = pageNum;
-            (*frame).fixCount++;
-
-            // point the head and tail for replacement
-            (*buffPoolMgmt).tail = (*buffPoolMgmt).head->next;
-            (*buffPoolMgmt).head = frame;
-            return RC_OK;
+            continue;
         }
 
-        frame = (*frame).next;
-
-    } while (frame != (*buffPoolMgmt).head);
-
-    // check if space is availabe if bufferpool
-    // if yes then fill it
-    if ((*buffPoolMgmt).occupiedFrameCount < (*bm).numPages)
-    {
-
-        frame = (*buffPoolMgmt).head;
-        (*frame).pageNum = pageNum;
+        int unpinned = 0;
+        frameChangeBegin(mgmt, frame);
+        if (!__atomic_compare_exchange_n(&mgmt->fixCounts[frame], &unpinned, 1, false, __ATOMIC_SEQ_CST,
+                                         __ATOMIC_SEQ_CST))
+        {
+            frameChangeEnd(mgmt, frame);
+            status = RC_BM_NO_FREE_FRAME;
+            continue;
+        }
+        if (ATOMIC_LOAD(&mgmt->dirtyFlags[frame]))
+        {
+            releaseFix(mgmt, frame);
+            frameChangeEnd(mgmt, frame);
+            status = RC_BM_NO_FREE_FRAME;
+            continue;
+        }
 
-        if ((*frame).next != (*buffPoolMgmt).head)
+        pageTableRemove(mgmt, frame);
+        ATOMIC_STORE(&mgmt->pageNums[frame], NO_PAGE);
+        ATOMIC_STORE(&mgmt->frameStates[frame], FRAME_EMPTY);
+        ATOMIC_STORE(&mgmt->prefetched[frame], false);
+        frameChangeEnd(mgmt, frame);
+        if (mgmt->policy->onEmpty != NULL)
         {
-            (*buffPoolMgmt).head = (*frame).next;
+            mgmt->policy->onEmpty(mgmt->policyState, frame);
         }
-        // increment the fix count
-        (*frame).fixCount++;
+        releaseFix(mgmt, frame);
+    }
+    tableLatchRelease(mgmt);
+    return status;
+}
 
-        // increment number of occupied frames
-        (*buffPoolMgmt).occupiedFrameCount++;
+// writes back and evicts the pages of the file in all shards, see evictFile
+static RC flushAndEvictFile(BM_BufferPool_Mgmt *root, int file)
+{
+    RC status = flushFile(root, file);
+    if (status != RC_OK)
+    {
+        return status;
     }
-    else
+    for (int s = 0; s < root->numShards; s++)
     {
-        // replace pages from frame using LRU
-        frame = (*buffPoolMgmt).tail;
-        do
+        RC shardStatus = evictFile(root->shards[s], file);
+        if (shardStatus != RC_OK && status == RC_OK)
         {
-            //  check for page usage, if in use move to next
-            if ((*frame).fixCount != 0)
-            {
-                frame = (*frame).next;
-            }
-            else
-            {
-                // check for dirtyFlagSigbnal if it is 1, write page to disk before replacing
-                if ((*frame).dirtyFlagSignal == 1)
-                {
-                    ensureCapacity((*frame).pageNum, &fHandleandler);
-                    if (writeBlock((*frame).pageNum, &fHandleandler, (*frame).data) != RC_OK)
-                    {
-                        closePageFile(&fHandleandler);
-                        return RC_WRITE_FAILED;
-                    }
-                    // increment writes performed
-                    (*buffPoolMgmt).getNumWriteIO++;
-                }
-
-                // find the least recently used page and replace that page
-                if ((*buffPoolMgmt).tail != (*buffPoolMgmt).head)
-                {
-                    (*frame).pageNum = pageNum;
-                    (*frame).fixCount++;
-                    (*buffPoolMgmt).tail = frame;
-                    (*buffPoolMgmt).tail = (*frame).next;
-                    break;
-                }
-                else
-                {
-                    frame = (*frame).next;
-                    (*frame).pageNum = pageNum;
-                    (*frame).fixCount++;
-                    (*buffPoolMgmt).tail = frame;
-                    (*buffPoolMgmt).head = frame;
-                    (*buffPoolMgmt).tail = (*frame).prev;
-                    break;
-                }
-            }
-        } while (frame != (*buffPoolMgmt).tail);
+            status = shardStatus;
+        }
     }
+    return status;
+}
+
+/*
+    # Closes a file opened with openPoolFile: writes back its dirty pages, evicts its pages from all
+      shards and closes it, the frames stay with the pool. Called by shutdownBufferPool.
+    # The page cleaners pin the pages they write for a moment, a page of the file that is still
+      pinned is waited for up to CLOSE_FILE_RETRIES times while they run. Then RC_BM_NO_FREE_FRAME
+      is returned and the file stays open.
+*/
+static RC closePoolFile(BM_BufferPool *const bm)
+{
+    BM_BufferPool_Mgmt *root = (BM_BufferPool_Mgmt *)bm->mgmtData;
+    int file = bm->fileId;
 
-    ensureCapacity((pageNum + 1), &fHandleandler);
-    if (readBlock(pageNum, &fHandleandler, (*frame).data) != RC_OK)
+    RC status = flushAndEvictFile(root, file);
+    for (int retry = 0; status == RC_BM_NO_FREE_FRAME && root->cleanerRunning && retry < CLOSE_FILE_RETRIES; retry++)
     {
-        return RC_READ_NON_EXISTING_PAGE;
+        usleep(CLEANER_RETRY_MS * 1000);
+        status = flushAndEvictFile(root, file);
+    }
+    if (status != RC_OK)
+    {
+        return status;
+    }
+    // the next file given the slot must not find the pages of this one
+    if (root->compressedTier != NULL)
+    {
+        compressedTierDropFile(root->compressedTier, file);
     }
-    (*buffPoolMgmt).getNumReadIO++;
-
-    // update the page frame and its data
-    (*currPage).pageNum = pageNum;
-    (*currPage).data = (*frame).data;
 
-    // close the pagefile
-    closePageFile(&fHandleandler);
+    // no frame refers to the file any more, so its slot can be given to the next file opened
+    fileLatchAcquire(root);
+    closePageFile(&root->files[file].handle);
+    root->files[file].name = NULL;
+    root->files[file].pool = NULL;
+    root->files[file].open = false;
+    fileLatchRelease(root);
 
+    free(bm->pageFile);
+    bm->numPages = 0;
+    bm->mgmtData = NULL;
+    bm->pageFile = NULL;
+    bm->fileId = 0;
     return RC_OK;
 }
 
 /*
-    # Implementation for CLOCK page Replacement policy.
-    # Uses FIFO in circular queue along with setting referenceBit for every pages in frame
- */
-RC pinPageCLOCK(BM_BufferPool *const bm, BM_PageHandle *const currPage, const PageNumber pageNum)
+    # Opens another page file in the pool of pool, whose frames and replacement policy it shares with
+      the files opened in it before. bm becomes the handle of the file for all functions working on
+      pages, forceFlushPool flushes the pages of that file only and shutdownBufferPool closes it.
+      The statistics of bm are those of the whole pool.
+    # The pool has to be created with the maxFiles option for more than one file. A file that is
+      open in the pool already, by the same name, is rejected with RC_INVALID_INPUT, as is a file
+      whose page size differs from that of the pool or one more file than maxFiles.
+    # The file is opened with the storage backend of the pool, other threads may keep using the pool.
+*/
+RC openPoolFile(BM_BufferPool *const bm, BM_BufferPool *const pool, const char *const pageFileName)
 {
-    SM_FileHandle fHandleandler;
-    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
-    PageFrame *frame = (*buffPoolMgmt).head;
-    PageFrame *temp;
-    openPageFile((char *)(*bm).pageFile, &fHandleandler);
-
-    // if frame already in buffer pool
-    do
+    if (bm == NULL || pool == NULL || pool->mgmtData == NULL || pageFileName == NULL)
     {
-        // check if the page is referred again
-        if ((*frame).pageNum == pageNum)
-        {
-            (*currPage).pageNum = pageNum;
-            (*currPage).data = (*frame).data;
-
-            // mark its reference bit as 1
-            (*frame).referenceBit = 1;
-            (*frame).pageNum = pageNum;
-            (*frame).fixCount++;
-
-            return RC_OK;
-        }
-        frame = (*frame).next;
-    } while (frame != (*buffPoolMgmt).head);
+        return RC_INVALID_INPUT;
+    }
+    BM_BufferPool_Mgmt *root = (BM_BufferPool_Mgmt *)pool->mgmtData;
 
-    // when space is available execution from the start only if all the frames are empty
-    if ((*buffPoolMgmt).occupiedFrameCount < (*bm).numPages)
+    // Keep our own copy of the file name, the open file handle refers to it
+    char *fileName = strdup(pageFileName);
+    if (fileName == NULL)
     {
-        frame = (*buffPoolMgmt).head;
-
-        (*frame).pageNum = pageNum;
-        // mark their reference bit as 1
-        (*frame).referenceBit = 1;
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
 
-        // all insertions are at head
-        // after insertion move to next node
-        if ((*frame).next != (*buffPoolMgmt).head)
+    // the registry is searched and the slot taken under the file latch, so a file cannot be opened twice
+    fileLatchAcquire(root);
+    int file = -1;
+    bool duplicate = false;
+    for (int i = 0; i < root->maxFiles; i++)
+    {
+        if (!root->files[i].open)
+        {
+            file = file < 0 ? i : file;
+        }
+        else if (strcmp(root->files[i].name, fileName) == 0)
         {
-            (*buffPoolMgmt).head = (*frame).next;
+            duplicate = true;
         }
+    }
 
-        (*frame).fixCount++;
-        (*buffPoolMgmt).occupiedFrameCount++;
+    RC status = RC_INVALID_INPUT;
+    if (file >= 0 && !duplicate)
+    {
+        status = openPageFileWithBackend(fileName, &root->files[file].handle, root->backend);
     }
-    else
+    // the frames have the page size of the pool
+    if (status == RC_OK && root->files[file].handle.pageSize != root->pageSize)
     {
-        // if page replacement is needed
-        frame = (*buffPoolMgmt).head;
-
-        do
-        {
-            // look for page with referenceBit set to 0 so it can be replaced
-            if ((*frame).fixCount != 0)
-            {
-                frame = (*frame).next;
-            }
-            else
-            {
-                while ((*frame).referenceBit != 0)
-                {
-                    (*frame).referenceBit = 0;
-                    frame = (*frame).next;
-                }
-
-                // check if reference bit is 0
-                if ((*frame).referenceBit == 0)
-                {
-                    // check if the dirtyFlagSiganl is set
-                    // if yes, write to disk and then replace
-                    if ((*frame).dirtyFlagSignal == 1)
-                    {
-                        ensureCapacity((*frame).pageNum, &fHandleandler);
-                        if (writeBlock((*frame).pageNum, &fHandleandler, (*frame).data) != RC_OK)
-                        {
-                            closePageFile(&fHandleandler);
-                            return RC_WRITE_FAILED;
-                        }
-                        (*buffPoolMgmt).getNumWriteIO++;
-                    }
-                    // update all the frame along with page attributes
-                    (*frame).referenceBit = 1;
-                    (*frame).pageNum = pageNum;
-                    (*frame).fixCount++;
-                    (*buffPoolMgmt).head = (*frame).next;
-                    break;
-                }
-            }
-
-        } while (frame != (*buffPoolMgmt).head);
+        closePageFile(&root->files[file].handle);
+        status = RC_INVALID_INPUT;
     }
-    ensureCapacity((pageNum + 1), &fHandleandler);
-
-    if (readBlock(pageNum, &fHandleandler, (*frame).data) != RC_OK)
+    if (status == RC_OK)
     {
-        closePageFile(&fHandleandler);
-        return RC_READ_NON_EXISTING_PAGE;
+        root->files[file].name = fileName;
+        root->files[file].pool = bm;
+        root->files[file].readAheadWindow = 0;
+        root->files[file].nextSequentialPage = NO_PAGE;
+        root->files[file].open = true;
+        // resizeBufferPool changes the size under the file latch as well
+        bm->numPages = pool->numPages;
     }
+    fileLatchRelease(root);
 
-    (*buffPoolMgmt).getNumReadIO++;
-    (*currPage).pageNum = pageNum;
-    (*currPage).data = (*frame).data;
-
-    closePageFile(&fHandleandler);
+    if (status != RC_OK)
+    {
+        free(fileName);
+        return status;
+    }
 
+    bm->pageFile = fileName;
+    bm->strategy = pool->strategy;
+    bm->mgmtData = root;
+    bm->fileId = file;
     return RC_OK;
 }
 
@@ -744,99 +4003,264 @@ RC pinPageCLOCK(BM_BufferPool *const bm, BM_PageHandle *const currPage, const Pa
     # The following funtion returns array of PageNumbers having of numPages.
     # Any element in the array represents the number of pages stored in the respective page frame.
     # A frame with no pages is represented using NO_PAGE constant.
+    # The array is owned by the buffer pool and overwritten by the next call.
  */
 PageNumber *getFrameContents(BM_BufferPool *const bm)
 {
     BM_BufferPool_Mgmt *buffPoolMgmt;
     buffPoolMgmt = (*bm).mgmtData;
-    (*buffPoolMgmt).frameContent = (PageNumber *)malloc(sizeof(PageNumber) * (*bm).numPages);
-
-    PageFrame *frame = (*buffPoolMgmt).start;
-    PageNumber *frameContents = (*buffPoolMgmt).frameContent;
-
-    int i;
-    int page_count = (*bm).numPages;
 
-    if (frameContents != NULL)
+    // the frames of the shards follow each other, each shard is copied under its own latch
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
     {
-        for (i = 0; i < page_count; i++)
-        {
-            frameContents[i] = (*frame).pageNum;
-            frame = (*frame).next;
-        }
+        BM_BufferPool_Mgmt *shard = (*buffPoolMgmt).shards[s];
+        tableLatchShared(shard);
+        memcpy(&(*buffPoolMgmt).frameContent[(*shard).firstFrame], (*shard).pageNums,
+               sizeof(PageNumber) * (*shard).numFrames);
+        tableLatchRelease(shard);
     }
-
-    return frameContents;
+    return (*buffPoolMgmt).frameContent;
 }
 
 /*
     # The getDirtyFlags returns boolen arrays of size numPages
     # If a page frame is dirty then its corresponding elemet is set TRUE
     # All empty page frames are clean hence is set to FALSE
+    # The array is owned by the buffer pool and overwritten by the next call.
  */
 bool *getDirtyFlags(BM_BufferPool *const bm)
 {
     BM_BufferPool_Mgmt *buffPoolMgmt;
     buffPoolMgmt = (*bm).mgmtData;
-    (*buffPoolMgmt).markDirty = (bool *)malloc(sizeof(bool) * (*bm).numPages);
-
-    PageFrame *frame = (*buffPoolMgmt).start;
-    bool *markDirty = (*buffPoolMgmt).markDirty;
 
-    int i, page_count = (*bm).numPages;
-
-    if (markDirty != NULL)
+    // the page cleaner and concurrent flushes change the flags under the shared latch, so they are read one by one
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
     {
-        for (i = 0; i < page_count; i++)
+        BM_BufferPool_Mgmt *shard = (*buffPoolMgmt).shards[s];
+        tableLatchShared(shard);
+        for (int i = 0; i < (*shard).numFrames; i++)
         {
-            markDirty[i] = (*frame).dirtyFlagSignal;
-            frame = (*frame).next;
+            (*buffPoolMgmt).markDirty[(*shard).firstFrame + i] = ATOMIC_LOAD(&(*shard).dirtyFlags[i]);
         }
+        tableLatchRelease(shard);
     }
-
-    return markDirty;
+    return (*buffPoolMgmt).markDirty;
 }
 
 /*
     # The function below returns int arrays of size numPages
     # The ith element is stored in ith frame as it is the fix count for thr page
+    # The array is owned by the buffer pool and overwritten by the next call.
  */
 int *getFixCounts(BM_BufferPool *const bm)
 {
     BM_BufferPool_Mgmt *buffPoolMgmt;
     buffPoolMgmt = (*bm).mgmtData;
-    (*buffPoolMgmt).fixCount = (int *)malloc(sizeof(int) * (*bm).numPages);
-
-    PageFrame *frame = (*buffPoolMgmt).start;
-    int *fixCount = (*buffPoolMgmt).fixCount;
-
-    int i, page_count = (*bm).numPages;
 
-    if (fixCount != NULL)
+    // buffer hits and unpins change the counts under the shared latch, so they are read one by one
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
     {
-        for (i = 0; i < page_count; i++)
+        BM_BufferPool_Mgmt *shard = (*buffPoolMgmt).shards[s];
+        tableLatchShared(shard);
+        for (int i = 0; i < (*shard).numFrames; i++)
         {
-            fixCount[i] = (*frame).fixCount;
-            frame = (*frame).next;
+            (*buffPoolMgmt).fixCount[(*shard).firstFrame + i] = ATOMIC_LOAD(&(*shard).fixCounts[i]);
         }
+        tableLatchRelease(shard);
     }
-    // free((*buffPoolMgmt).fixCount);
-
-    return fixCount;
+    return (*buffPoolMgmt).fixCount;
 }
 
 /*
-    # The function below gets the total number of Read Operations
+    # The function below gets the total number of Read Operations, summed over the shards
  */
 int getNumReadIO(BM_BufferPool *const bm)
 {
-    return ((BM_BufferPool_Mgmt *)(*bm).mgmtData)->getNumReadIO;
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    int total = 0;
+
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        total += ATOMIC_LOAD(&(*buffPoolMgmt).shards[s]->getNumReadIO);
+    }
+    return total;
 }
 
 /*
-    # This function below gets the total number of Read Operations
+    # This function below gets the total number of Write Operations, summed over the shards
  */
 int getNumWriteIO(BM_BufferPool *const bm)
 {
-    return ((BM_BufferPool_Mgmt *)(*bm).mgmtData)->getNumWriteIO;
-}
\ No newline at end of file
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    int total = 0;
+
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        total += ATOMIC_LOAD(&(*buffPoolMgmt).shards[s]->getNumWriteIO);
+    }
+    return total;
+}
+
+/*
+    # This function returns the size in bytes of the pages of the pool, taken from its page file.
+ */
+int getPageSize(BM_BufferPool *const bm)
+{
+    return ((BM_BufferPool_Mgmt *)(*bm).mgmtData)->pageSize;
+}
+
+/*
+    # This function returns the number of shards the frames of the pool are split into, 1 without the numShards option.
+ */
+int getNumShards(BM_BufferPool *const bm)
+{
+    return ((BM_BufferPool_Mgmt *)(*bm).mgmtData)->numShards;
+}
+
+/*
+    # This function returns the number of pins of pages whose frames are bound to another NUMA node
+      than the one the pinning thread ran on, summed over the shards. It is 0 without numaPlacement.
+ */
+int getNumCrossNodePins(BM_BufferPool *const bm)
+{
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    int total = 0;
+
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        total += ATOMIC_LOAD(&(*buffPoolMgmt).shards[s]->crossNodePins);
+    }
+    return total;
+}
+
+/*
+    # This function returns the NUMA node of the frames that hold pageNum when it is resident, or -1 without
+      numaPlacement. It does not place an extent, so it returns -1 for an extent nobody used yet as well.
+ */
+int getPageNode(BM_BufferPool *const bm, const PageNumber pageNum)
+{
+    BM_BufferPool_Mgmt *root = (*bm).mgmtData;
+    unsigned int extent = (unsigned int)(pageNum / SHARD_EXTENT_PAGES);
+
+    if (isPlacedExtent(root, (*bm).fileId, extent) && ATOMIC_LOAD(&root->extentShards[extent]) == NO_SHARD)
+    {
+        return -1;
+    }
+    return shardOf(root, (*bm).fileId, pageNum)->numaNode;
+}
+
+/*
+    # This function fills in the profile of each kind of latch, summed over the shards. All of it
+      is 0 unless the pool was created with profileLatches, which needs a concurrent pool.
+    # Latches that are held while the profile is taken are reported with the holds finished so far.
+ */
+RC getLatchStats(BM_BufferPool *const bm, BM_LatchStats stats[BM_NUM_LATCH_KINDS])
+{
+    if (bm == NULL || (*bm).mgmtData == NULL || stats == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    memset(stats, 0, sizeof(BM_LatchStats) * BM_NUM_LATCH_KINDS);
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        BM_LatchStats *shardStats = (*buffPoolMgmt).shards[s]->latchStats;
+        for (int kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+        {
+            stats[kind].acquisitions += ATOMIC_LOAD(&shardStats[kind].acquisitions);
+            stats[kind].contended += ATOMIC_LOAD(&shardStats[kind].contended);
+            stats[kind].waitNanos += ATOMIC_LOAD(&shardStats[kind].waitNanos);
+            stats[kind].holdNanos += ATOMIC_LOAD(&shardStats[kind].holdNanos);
+        }
+    }
+    return RC_OK;
+}
+
+/*
+    # This function sets the latch profile of the pool back to 0, e.g. after a warm up phase.
+ */
+RC resetLatchStats(BM_BufferPool *const bm)
+{
+    if (bm == NULL || (*bm).mgmtData == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        BM_LatchStats *shardStats = (*buffPoolMgmt).shards[s]->latchStats;
+        for (int kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+        {
+            ATOMIC_STORE(&shardStats[kind].acquisitions, 0);
+            ATOMIC_STORE(&shardStats[kind].contended, 0);
+            ATOMIC_STORE(&shardStats[kind].waitNanos, 0);
+            ATOMIC_STORE(&shardStats[kind].holdNanos, 0);
+        }
+    }
+    return RC_OK;
+}
+
+/*
+    # This function copies the statistics of the pool into stats, see BM_PoolStats. It allocates
+      nothing and takes no latch, so it can be polled while threads use the pool. The counters
+      are summed up one after the other and are not a consistent cut of a pool in use.
+ */
+RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *stats)
+{
+    if (bm == NULL || (*bm).mgmtData == NULL || stats == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    BM_BufferPool_Mgmt *buffPoolMgmt = (*bm).mgmtData;
+    long long counts[NUM_STATS] = {0};
+    BM_Histogram *histograms[NUM_HISTOGRAMS] = {&stats->pinLatency, &stats->readLatency, &stats->writeLatency};
+
+    memset(stats, 0, sizeof(BM_PoolStats));
+    for (int slot = 0; slot < STAT_SLOTS; slot++)
+    {
+        const StatSlot *s = &(*buffPoolMgmt).statSlots[slot];
+        for (int i = 0; i < NUM_STATS; i++)
+        {
+            counts[i] += __atomic_load_n(&s->counts[i], __ATOMIC_RELAXED);
+        }
+        for (int h = 0; h < NUM_HISTOGRAMS; h++)
+        {
+            for (int b = 0; b < BM_HISTOGRAM_BUCKETS; b++)
+            {
+                histograms[h]->counts[b] += __atomic_load_n(&s->histograms[h].counts[b], __ATOMIC_RELAXED);
+            }
+            histograms[h]->totalNanos += __atomic_load_n(&s->histograms[h].totalNanos, __ATOMIC_RELAXED);
+        }
+    }
+
+    stats->hits = counts[STAT_HITS];
+    stats->misses = counts[STAT_MISSES];
+    stats->prefetchHits = counts[STAT_PREFETCH_HITS];
+    stats->evictions = counts[STAT_EVICTIONS];
+    stats->dirtyEvictions = counts[STAT_DIRTY_EVICTIONS];
+    stats->ioStallNanos = counts[STAT_IO_STALL_NANOS];
+    stats->readIO = getNumReadIO(bm);
+    stats->writeIO = getNumWriteIO(bm);
+    if (buffPoolMgmt->compressedTier != NULL)
+    {
+        compressedTierStats(buffPoolMgmt->compressedTier, stats);
+    }
+
+    // the frames are as large and as locked as those of the shard that got the least
+    stats->framePages = BM_FRAME_PAGES_HUGE_1GB;
+    stats->framesLocked = true;
+    for (int s = 0; s < (*buffPoolMgmt).numShards; s++)
+    {
+        const BM_BufferPool_Mgmt *shard = (*buffPoolMgmt).shards[s];
+        if (shard->framePages < stats->framePages)
+        {
+            stats->framePages = shard->framePages;
+        }
+        stats->framesLocked = stats->framesLocked && shard->framesLocked;
+        stats->frameBytes += (long long)shard->frameBytes;
+    }
+    return RC_OK;
+}
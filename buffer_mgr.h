@@ -7,6 +7,9 @@
 // Include bool DT
 #include "dt.h"
 
+// Include the storage backends
+#include "storage_mgr.h"
+
 // Replacement Strategies
 typedef enum ReplacementStrategy
 {
@@ -14,7 +17,9 @@ typedef enum ReplacementStrategy
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5,
+	RS_2Q = 6
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -28,6 +33,7 @@ typedef struct BM_BufferPool
 	ReplacementStrategy strategy;
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 					// manager needs for a buffer pool
+	int fileId;		// file of the pool the handle works on, 0 unless it was opened with openPoolFile
 } BM_BufferPool;
 
 typedef struct BM_PageHandle
@@ -36,6 +42,106 @@ typedef struct BM_PageHandle
 	char *data;
 } BM_PageHandle;
 
+// Memory pages the frames of a pool are mapped from, asked for with the framePages option and reported by getPoolStats
+typedef enum BM_FramePages
+{
+	BM_FRAME_PAGES_DEFAULT = 0,		// the normal pages of the system
+	BM_FRAME_PAGES_TRANSPARENT = 1, // transparent huge pages, asked for with madvise
+	BM_FRAME_PAGES_HUGE_2MB = 2,	// 2 MB pages of the hugetlb pool of the system
+	BM_FRAME_PAGES_HUGE_1GB = 3		// 1 GB pages of the hugetlb pool of the system
+} BM_FramePages;
+
+// Optional settings of a buffer pool, a zero initialised struct gives the defaults
+typedef struct BM_PoolOptions
+{
+	bool concurrent;	  // protect the pool with latches so that several threads can use it at once
+	bool backgroundFlush; // write dirty pages back from a page cleaner thread ahead of eviction, implies concurrent
+	double dirtyRatio;	  // fraction of dirty frames at which the page cleaner starts, 0 gives 0.25
+	int readAheadPages;	  // largest number of pages read ahead of a sequential scan, 0 turns read ahead off
+	SM_Backend storageBackend; // how the page file is accessed, SM_BACKEND_MMAP allows zero copy pinPageReadOnly
+	int pageSize;		  // page size the caller expects, 0 takes the one of the page file, another one is rejected
+	bool optimisticHits;  // pin resident pages without latches if the policy allows it (FIFO, CLOCK), implies concurrent
+	int numShards;		  // split the frames into this many shards chosen by page number, 0 or 1 gives one
+	bool numaPlacement;	  // bind the frames of each shard to a NUMA node and place pages in shards local to their first user
+	bool profileLatches;  // time the waits for and the holds of the latches of a concurrent pool, see getLatchStats
+	bool timePins;		  // record the latency of every pinPage and pinPageReadOnly call, see getPoolStats
+	const char *traceFile; // append a record of every pin, unpin and dirty mark to this file, see buffer_trace.h
+	const char *hotSetFile; // save the resident pages to this file on shutdown and load them back into a new pool
+	bool warmInBackground; // load the hot set from a thread of the pool while it serves pins, needs concurrent
+	int checkpointSeconds; // save the hot set this often as well, 0 only saves on shutdown, needs concurrent
+	int maxPages;		  // largest size resizeBufferPool can grow the pool to, at least numPages, 0 gives numPages
+	int maxFiles;		  // page files that can be open in the pool at once, counting pageFileName, 0 gives 1, see openPoolFile
+	int compressedTierPages; // keep clean evicted pages compressed in an arena of this many pages, 0 turns it off
+	BM_FramePages framePages; // pages to map the frames from, falling back to smaller ones the system cannot give
+	bool lockFrames;	  // lock the frames in memory with mlock, so they are never swapped out
+	bool prefaultFrames;  // touch the memory of the frames in use at init and when the pool grows, so pins do not fault
+} BM_PoolOptions;
+
+// number of buckets of a BM_Histogram
+#define BM_HISTOGRAM_BUCKETS 32
+
+// Latencies in log2 buckets, counts[i] holds those of 2^i to 2^(i+1) - 1 ns, the last bucket all longer ones
+typedef struct BM_Histogram
+{
+	long long counts[BM_HISTOGRAM_BUCKETS];
+	long long totalNanos; // sum of all latencies
+} BM_Histogram;
+
+// Snapshot of the statistics of a pool taken by getPoolStats, all of them count from the creation of the pool
+typedef struct BM_PoolStats
+{
+	long long hits;			  // pins of pages that were found in the pool
+	long long misses;		  // pins of pages that were not, whoever read them in the end
+	long long prefetchHits;	  // first hits of pages read ahead or prefetched before they were pinned
+	long long evictions;	  // pages replaced by another page
+	long long dirtyEvictions; // replaced pages that the pin had to write back first
+	long long readIO;		  // pages read, as getNumReadIO
+	long long writeIO;		  // pages written, as getNumWriteIO
+	long long ioStallNanos;	  // time pins spent on disk I/O or waiting for the reads of other threads
+	BM_Histogram pinLatency;  // pinPage and pinPageReadOnly calls, only recorded with the timePins option
+	BM_Histogram readLatency; // calls of the storage manager reading pages
+	BM_Histogram writeLatency; // calls of the storage manager writing pages
+	long long compressedHits;	  // misses served from the compressed tier instead of the page file
+	long long compressedMisses;	  // misses that did not find their page in the compressed tier
+	long long compressedStores;	  // evicted pages stored in the compressed tier
+	long long compressedRejects;  // evicted pages that did not compress well enough to be stored
+	long long compressedPages;	  // pages held by the compressed tier now
+	long long compressedBytes;	  // bytes those pages take in the tier
+	long long compressedCapacity; // bytes of the arena of the compressed tier, 0 without one
+	double compressionRatio;	  // page bytes per compressed byte of the pages held, 0 while there are none
+	BM_FramePages framePages;	  // pages the frames were mapped from, the smallest any shard got
+	bool framesLocked;			  // the frames of every shard are locked in memory
+	long long frameBytes;		  // bytes mapped for the frames, including those resizeBufferPool may grow into
+} BM_PoolStats;
+
+// Latches of a concurrent pool, as reported by getLatchStats
+typedef enum BM_LatchKind
+{
+	BM_LATCH_TABLE_SHARED = 0,	  // page table latch taken by hits, unpins and dirty marks
+	BM_LATCH_TABLE_EXCLUSIVE = 1, // page table latch taken to load or evict pages
+	BM_LATCH_FRAME = 2,			  // frame latches held during the disk I/O of a frame
+	BM_LATCH_FILE = 3,			  // file latch taken to grow the page file or for I/O of backends that need it
+	BM_LATCH_REPLACEMENT = 4,	  // latch around the hit updates of replacement policies
+	BM_LATCH_CLEANER = 5,		  // latch taken to wake up the page cleaner
+	BM_NUM_LATCH_KINDS = 6
+} BM_LatchKind;
+
+// Profile of one kind of latch, summed over all latches of that kind in all shards
+typedef struct BM_LatchStats
+{
+	long long acquisitions; // times the latch was taken
+	long long contended;	// acquisitions that had to wait for another holder
+	long long waitNanos;	// total time spent waiting for the latch
+	long long holdNanos;	// total time the latch was held
+} BM_LatchStats;
+
+// Parameters of the RS_LRU_K strategy passed as stratData, NULL gives LRU-2 with no correlated reference period
+typedef struct BM_LRUKParams
+{
+	int k;							// number of references remembered per page
+	int correlatedReferencePeriod;	// a reference at most this many pins after the previous one of the page does not count
+} BM_LRUKParams;
+
 // convenience macros
 #define MAKE_POOL() \
 	((BM_BufferPool *)malloc(sizeof(BM_BufferPool)))
@@ -47,8 +153,14 @@ typedef struct BM_PageHandle
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 				  const int numPages, ReplacementStrategy strategy,
 				  void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+							 const int numPages, ReplacementStrategy strategy,
+							 void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC saveHotSet(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages);
+RC openPoolFile(BM_BufferPool *const bm, BM_BufferPool *const pool, const char *const pageFileName);
 
 // Buffer Manager Interface Access Pages
 RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -56,6 +168,12 @@ RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
 		   const PageNumber pageNum);
+RC pinPageReadOnly(BM_BufferPool *const bm, BM_PageHandle *const page,
+				   const PageNumber pageNum);
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber startPage, const int numPages);
+RC pinPages(BM_BufferPool *const bm, BM_PageHandle *const handles,
+			const PageNumber *pageNums, const int numPages);
+RC unpinPages(BM_BufferPool *const bm, BM_PageHandle *const handles, const int numPages);
 
 // Statistics Interface
 PageNumber *getFrameContents(BM_BufferPool *const bm);
@@ -63,5 +181,12 @@ bool *getDirtyFlags(BM_BufferPool *const bm);
 int *getFixCounts(BM_BufferPool *const bm);
 int getNumReadIO(BM_BufferPool *const bm);
 int getNumWriteIO(BM_BufferPool *const bm);
+int getPageSize(BM_BufferPool *const bm);
+int getNumShards(BM_BufferPool *const bm);
+int getNumCrossNodePins(BM_BufferPool *const bm);
+int getPageNode(BM_BufferPool *const bm, const PageNumber pageNum);
+RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *stats);
+RC getLatchStats(BM_BufferPool *const bm, BM_LatchStats stats[BM_NUM_LATCH_KINDS]);
+RC resetLatchStats(BM_BufferPool *const bm);
 
 #endif
@@ -1,4 +1,5 @@
 #include "buffer_mgr_stat.h"
+#include "buffer_policy.h"
 #include "buffer_mgr.h"
 
 #include <stdio.h>
@@ -51,33 +52,121 @@ sprintPoolContent (BM_BufferPool *const bm)
 }
 
 
-void
-printPageContent (BM_PageHandle *const page)
+static void
+printPageContentOfSize (BM_PageHandle *const page, int pageSize)
 {
 	int i;
 
 	printf("[Page %i]\n", page->pageNum);
 
-	for (i = 1; i <= PAGE_SIZE; i++)
+	for (i = 1; i <= pageSize; i++)
 		printf("%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n");
 }
 
-char *
-sprintPageContent (BM_PageHandle *const page)
+static char *
+sprintPageContentOfSize (BM_PageHandle *const page, int pageSize)
 {
 	int i;
 	char *message;
 	int pos = 0;
 
-	message = (char *) malloc(30 + (2 * PAGE_SIZE) + (PAGE_SIZE % 64) + (PAGE_SIZE % 8));
+	message = (char *) malloc(30 + (2 * pageSize) + (pageSize % 64) + (pageSize % 8));
 	pos += sprintf(message + pos, "[Page %i]\n", page->pageNum);
 
-	for (i = 1; i <= PAGE_SIZE; i++)
+	for (i = 1; i <= pageSize; i++)
 		pos += sprintf(message + pos, "%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n");
 
 	return message;
 }
 
+void
+printPageContent (BM_PageHandle *const page)
+{
+	printPageContentOfSize(page, PAGE_SIZE);
+}
+
+char *
+sprintPageContent (BM_PageHandle *const page)
+{
+	return sprintPageContentOfSize(page, PAGE_SIZE);
+}
+
+// the same for a page of a pool, which may have another page size than PAGE_SIZE
+void
+printPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+	printPageContentOfSize(page, getPageSize(bm));
+}
+
+char *
+sprintPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+	return sprintPageContentOfSize(page, getPageSize(bm));
+}
+
+// returns the upper bound in ns of the bucket holding the given quantile of the latencies, 0 if there are none
+long long
+histogramPercentile (const BM_Histogram *histogram, double quantile)
+{
+	long long total = 0, seen = 0;
+	int i;
+
+	for (i = 0; i < BM_HISTOGRAM_BUCKETS; i++)
+		total += histogram->counts[i];
+	if (total == 0)
+		return 0;
+
+	for (i = 0; i < BM_HISTOGRAM_BUCKETS - 1; i++)
+	{
+		seen += histogram->counts[i];
+		if ((double) seen >= quantile * (double) total)
+			break;
+	}
+	return (2LL << i) - 1;
+}
+
+static void
+printHistogram (const char *name, const BM_Histogram *histogram)
+{
+	long long count = 0;
+	int i;
+
+	for (i = 0; i < BM_HISTOGRAM_BUCKETS; i++)
+		count += histogram->counts[i];
+	printf(" %s %lld (avg %lld p50 %lld p99 %lld ns)", name, count, count > 0 ? histogram->totalNanos / count : 0,
+	       histogramPercentile(histogram, 0.5), histogramPercentile(histogram, 0.99));
+}
+
+// prints the statistics of getPoolStats on one line
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	BM_PoolStats stats;
+
+	if (getPoolStats(bm, &stats) != RC_OK)
+		return;
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: hits %lld misses %lld prefetch hits %lld evictions %lld dirty %lld reads %lld writes %lld stall %lld ns",
+	       bm->numPages, stats.hits, stats.misses, stats.prefetchHits, stats.evictions, stats.dirtyEvictions,
+	       stats.readIO, stats.writeIO, stats.ioStallNanos);
+	if (stats.compressedCapacity > 0)
+		printf(" compressed hits %lld pages %lld bytes %lld of %lld ratio %.2f",
+		       stats.compressedHits, stats.compressedPages, stats.compressedBytes, stats.compressedCapacity,
+		       stats.compressionRatio);
+	if (stats.framePages != BM_FRAME_PAGES_DEFAULT || stats.framesLocked)
+	{
+		static const char *const framePageNames[] = {"normal", "transparent huge", "2 MB", "1 GB"};
+		printf(" frames %lld bytes in %s pages%s", stats.frameBytes, framePageNames[stats.framePages],
+		       stats.framesLocked ? " locked" : "");
+	}
+	printHistogram("pins", &stats.pinLatency);
+	printHistogram("read calls", &stats.readLatency);
+	printHistogram("write calls", &stats.writeLatency);
+	printf("\n");
+}
+
 void
 printStrat (BM_BufferPool *const bm)
 {
@@ -98,8 +187,18 @@ printStrat (BM_BufferPool *const bm)
 	case RS_LRU_K:
 		printf("LRU-K");
 		break;
+	case RS_ARC:
+		printf("ARC");
+		break;
+	case RS_2Q:
+		printf("2Q");
+		break;
 	default:
-		printf("%i", bm->strategy);
+		// a policy registered by the user
+		if (getReplacementPolicy(bm->strategy) != NULL)
+			printf("%s", getReplacementPolicy(bm->strategy)->name);
+		else
+			printf("%i", bm->strategy);
 		break;
 	}
 }
@@ -8,5 +8,9 @@ void printPoolContent (BM_BufferPool *const bm);
 void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
+void printPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page);
+char *sprintPoolPageContent (BM_BufferPool *const bm, BM_PageHandle *const page);
+void printPoolStats (BM_BufferPool *const bm);
+long long histogramPercentile (const BM_Histogram *histogram, double quantile);
 
 #endif
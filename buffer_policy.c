@@ -0,0 +1,1303 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_policy.h"
+#include "buffer_scan.h"
+
+/*
+    # The page replacement policies built into the buffer manager.
+    # Every policy keeps its state in dense arrays indexed by frame, the lists it needs are
+      threaded through those arrays by index, so no hook allocates memory after init.
+*/
+
+/*
+    # First in First out (FIFO): the frames form a circular queue and tail points to the oldest page.
+    # The pool fills its frames in order, so the queue starts at frame 0.
+*/
+typedef struct FIFOState
+{
+    int numFrames;
+    int tail;
+} FIFOState;
+
+static RC fifoInit(void **state, int numFrames, void *stratData)
+{
+    FIFOState *fifo = (FIFOState *)calloc(1, sizeof(FIFOState));
+    if (fifo == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    fifo->numFrames = numFrames;
+    *state = fifo;
+    return RC_OK;
+}
+
+static void fifoShutdown(void *state)
+{
+    free(state);
+}
+
+// number of frames of the next block a sweep from frame tests, blocks stop at the end of the frames
+static int sweepBlockOf(int numFrames, int frame, int remaining)
+{
+    int count = numFrames - frame;
+    if (count > remaining)
+    {
+        count = remaining;
+    }
+    return count < SCAN_BLOCK_FRAMES ? count : SCAN_BLOCK_FRAMES;
+}
+
+// replace the oldest page whose fixcount = 0, skipping the frames in use a block at a time
+static int fifoPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    FIFOState *fifo = (FIFOState *)state;
+    int frame = fifo->tail;
+
+    for (int remaining = fifo->numFrames; remaining > 0;)
+    {
+        int count = sweepBlockOf(fifo->numFrames, frame, remaining);
+        uint64_t unpinned = unpinnedMaskOf(&fixCounts[frame], count);
+        if (unpinned != 0)
+        {
+            frame += __builtin_ctzll(unpinned);
+            // the frame after the replaced one holds the oldest page now
+            fifo->tail = (frame + 1) % fifo->numFrames;
+            return frame;
+        }
+        remaining -= count;
+        frame = (frame + count) % fifo->numFrames;
+    }
+    return NO_FRAME;
+}
+
+// the oldest page may have been in a frame the pool gave up, the queue then starts over at frame 0
+static void fifoOnResize(void *state, int numFrames)
+{
+    FIFOState *fifo = (FIFOState *)state;
+
+    fifo->numFrames = numFrames;
+    if (fifo->tail >= numFrames)
+    {
+        fifo->tail = 0;
+    }
+}
+
+/*
+    # Least Recently Used (LRU): a doubly linked recency list threaded through the frames by index,
+      from the least recently used frame at head to the most recently used one at tail.
+    # Every pin moves the frame to the most recently used end in O(1), the first page with fix
+      count 0 from the least recently used end is replaced.
+*/
+typedef struct LRUState
+{
+    int numFrames;
+    int *prev, *next;
+    int head, tail;
+} LRUState;
+
+static void lruUnlink(LRUState *lru, int frame)
+{
+    int prev = lru->prev[frame], next = lru->next[frame];
+
+    // frames that were never linked have no neighbours and are not the head
+    if (prev == NO_FRAME && lru->head != frame)
+    {
+        return;
+    }
+
+    if (prev != NO_FRAME)
+        lru->next[prev] = next;
+    else
+        lru->head = next;
+
+    if (next != NO_FRAME)
+        lru->prev[next] = prev;
+    else
+        lru->tail = prev;
+
+    lru->prev[frame] = NO_FRAME;
+    lru->next[frame] = NO_FRAME;
+}
+
+// moves the frame to the most recently used end of the list
+static void lruMoveToMRU(LRUState *lru, int frame)
+{
+    if (lru->tail == frame)
+    {
+        return;
+    }
+    lruUnlink(lru, frame);
+
+    lru->prev[frame] = lru->tail;
+    if (lru->tail != NO_FRAME)
+        lru->next[lru->tail] = frame;
+    else
+        lru->head = frame;
+    lru->tail = frame;
+}
+
+// moves the frame to the least recently used end of the list, so it is replaced first
+static void lruMoveToLRU(LRUState *lru, int frame)
+{
+    if (lru->head == frame)
+    {
+        return;
+    }
+    lruUnlink(lru, frame);
+
+    lru->next[frame] = lru->head;
+    if (lru->head != NO_FRAME)
+        lru->prev[lru->head] = frame;
+    else
+        lru->tail = frame;
+    lru->head = frame;
+}
+
+static void lruShutdown(void *state)
+{
+    LRUState *lru = (LRUState *)state;
+
+    free(lru->prev);
+    free(lru->next);
+    free(lru);
+}
+
+static RC lruInit(void **state, int numFrames, void *stratData)
+{
+    LRUState *lru = (LRUState *)calloc(1, sizeof(LRUState));
+    if (lru == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    lru->prev = (int *)malloc(sizeof(int) * numFrames);
+    lru->next = (int *)malloc(sizeof(int) * numFrames);
+    if (lru->prev == NULL || lru->next == NULL)
+    {
+        lruShutdown(lru);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    for (int i = 0; i < numFrames; i++)
+    {
+        lru->prev[i] = NO_FRAME;
+        lru->next[i] = NO_FRAME;
+    }
+    lru->numFrames = numFrames;
+    lru->head = NO_FRAME;
+    lru->tail = NO_FRAME;
+
+    *state = lru;
+    return RC_OK;
+}
+
+static void lruOnHit(void *state, int frame)
+{
+    lruMoveToMRU((LRUState *)state, frame);
+}
+
+static void lruOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    lruMoveToMRU((LRUState *)state, frame);
+}
+
+static void lruOnEmpty(void *state, int frame)
+{
+    lruMoveToLRU((LRUState *)state, frame);
+}
+
+static int lruPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    LRUState *lru = (LRUState *)state;
+    int frame = lru->head;
+
+    // only pinned pages are skipped, so the walk is short unless most of the pool is in use
+    while (frame != NO_FRAME && fixCountOf(fixCounts, frame) != 0)
+    {
+        frame = lru->next[frame];
+    }
+    return frame;
+}
+
+// the frames the pool gave up leave the list, those it gets back are linked by their first insert
+static void lruOnResize(void *state, int numFrames)
+{
+    LRUState *lru = (LRUState *)state;
+
+    for (int frame = numFrames; frame < lru->numFrames; frame++)
+    {
+        lruUnlink(lru, frame);
+    }
+    lru->numFrames = numFrames;
+}
+
+/*
+    # CLOCK: FIFO in a circular queue along with a reference bit per frame, set when the page
+      is read in and on every hit.
+    # The hand sweeps over the frames, clearing reference bits, until an unpinned page with its
+      reference bit set to 0 is found; two rounds are enough unless all are in use.
+    # The sweep tests a block of frames at a time with the kernels of buffer_scan.c and clears the
+      bits of the unpinned frames it passes one by one, as the hand would.
+    # Hits only set a bit atomically, so they need no latch, not even next to a sweep of the hand.
+*/
+typedef struct ClockState
+{
+    int numFrames;
+    int hand;
+    bool *referenceBits;
+} ClockState;
+
+static void clockShutdown(void *state)
+{
+    ClockState *clock = (ClockState *)state;
+
+    free(clock->referenceBits);
+    free(clock);
+}
+
+static RC clockInit(void **state, int numFrames, void *stratData)
+{
+    ClockState *clock = (ClockState *)calloc(1, sizeof(ClockState));
+    if (clock == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    clock->numFrames = numFrames;
+    clock->referenceBits = (bool *)calloc(numFrames, sizeof(bool));
+    if (clock->referenceBits == NULL)
+    {
+        clockShutdown(clock);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    *state = clock;
+    return RC_OK;
+}
+
+static void clockOnHit(void *state, int frame)
+{
+    ClockState *clock = (ClockState *)state;
+
+    // skipping the store when the bit is already set keeps the cache line shared
+    if (!__atomic_load_n(&clock->referenceBits[frame], __ATOMIC_ACQUIRE))
+    {
+        __atomic_store_n(&clock->referenceBits[frame], true, __ATOMIC_RELEASE);
+    }
+}
+
+// all loaded pages start with their reference bit as 1
+static void clockOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    __atomic_store_n(&((ClockState *)state)->referenceBits[frame], true, __ATOMIC_RELAXED);
+}
+
+static void clockOnEmpty(void *state, int frame)
+{
+    __atomic_store_n(&((ClockState *)state)->referenceBits[frame], false, __ATOMIC_RELAXED);
+}
+
+static int clockPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    ClockState *clock = (ClockState *)state;
+    int frame = clock->hand;
+
+    for (int remaining = 2 * clock->numFrames; remaining > 0;)
+    {
+        int count = sweepBlockOf(clock->numFrames, frame, remaining);
+        uint64_t unpinned = unpinnedMaskOf(&fixCounts[frame], count);
+        uint64_t referenced = unpinned & flagMaskOf(&clock->referenceBits[frame], count);
+        uint64_t victims = unpinned & ~referenced;
+
+        // the hand passes the unpinned frames before the victim, or all of the block if there is none
+        int passed = victims != 0 ? __builtin_ctzll(victims) : count;
+        if (passed < SCAN_BLOCK_FRAMES)
+        {
+            referenced &= (1ull << passed) - 1;
+        }
+        for (; referenced != 0; referenced &= referenced - 1)
+        {
+            __atomic_store_n(&clock->referenceBits[frame + __builtin_ctzll(referenced)], false, __ATOMIC_RELAXED);
+        }
+
+        if (victims != 0)
+        {
+            frame += passed;
+            clock->hand = (frame + 1) % clock->numFrames;
+            return frame;
+        }
+        remaining -= count;
+        frame = (frame + count) % clock->numFrames;
+    }
+    return NO_FRAME;
+}
+
+// the frames the pool gives up lose their reference bits, the hand starts over if it was on one of them
+static void clockOnResize(void *state, int numFrames)
+{
+    ClockState *clock = (ClockState *)state;
+
+    for (int frame = numFrames; frame < clock->numFrames; frame++)
+    {
+        __atomic_store_n(&clock->referenceBits[frame], false, __ATOMIC_RELAXED);
+    }
+    clock->numFrames = numFrames;
+    if (clock->hand >= numFrames)
+    {
+        clock->hand = 0;
+    }
+}
+
+/*
+    # The LFU frequency buckets: frames whose pages have the same use count are linked in one
+      bucket, oldest reference first, and the buckets form a list ordered by increasing count.
+    # A hit moves its frame into the bucket with the next count, which is the following bucket or
+      a new one linked right after the current bucket, so updating the counts is O(1).
+    # The victim is the oldest unpinned frame of the lowest bucket, ties on the count are broken LRU.
+*/
+
+// bucket index used to mark the end of the bucket list
+#define NO_BUCKET -1
+
+typedef struct LFUState
+{
+    int numFrames;                 // number of frames in the pool
+    int *counts;                   // use count of the page in each frame
+    int *bucketOf;                 // bucket holding each frame, NO_BUCKET while the frame is in none
+    int *prev, *next;              // links of the frames inside their bucket
+    int *bucketCount;              // use count shared by the frames of each bucket
+    int *bucketFirst, *bucketLast; // oldest and newest frame of each bucket
+    int *bucketPrev, *bucketNext;  // links of the buckets in increasing count order
+    int lowest;                    // bucket with the lowest count
+    int freeBuckets;               // unused buckets chained through bucketNext
+} LFUState;
+
+// takes an unused bucket for count and links it after the given bucket (NO_BUCKET for the front)
+static int lfuNewBucket(LFUState *lfu, int count, int after)
+{
+    int bucket = lfu->freeBuckets;
+    int next = after == NO_BUCKET ? lfu->lowest : lfu->bucketNext[after];
+
+    lfu->freeBuckets = lfu->bucketNext[bucket];
+    lfu->bucketCount[bucket] = count;
+    lfu->bucketFirst[bucket] = NO_FRAME;
+    lfu->bucketLast[bucket] = NO_FRAME;
+
+    lfu->bucketPrev[bucket] = after;
+    lfu->bucketNext[bucket] = next;
+    if (next != NO_BUCKET)
+        lfu->bucketPrev[next] = bucket;
+    if (after != NO_BUCKET)
+        lfu->bucketNext[after] = bucket;
+    else
+        lfu->lowest = bucket;
+    return bucket;
+}
+
+// removes the frame from its bucket, an emptied bucket goes back to the unused ones
+static void lfuDetach(LFUState *lfu, int frame)
+{
+    int bucket = lfu->bucketOf[frame];
+    if (bucket == NO_BUCKET)
+    {
+        return;
+    }
+
+    int prev = lfu->prev[frame], next = lfu->next[frame];
+    if (prev != NO_FRAME)
+        lfu->next[prev] = next;
+    else
+        lfu->bucketFirst[bucket] = next;
+    if (next != NO_FRAME)
+        lfu->prev[next] = prev;
+    else
+        lfu->bucketLast[bucket] = prev;
+    lfu->bucketOf[frame] = NO_BUCKET;
+
+    if (lfu->bucketFirst[bucket] == NO_FRAME)
+    {
+        int before = lfu->bucketPrev[bucket], after = lfu->bucketNext[bucket];
+        if (before != NO_BUCKET)
+            lfu->bucketNext[before] = after;
+        else
+            lfu->lowest = after;
+        if (after != NO_BUCKET)
+            lfu->bucketPrev[after] = before;
+
+        lfu->bucketNext[bucket] = lfu->freeBuckets;
+        lfu->freeBuckets = bucket;
+    }
+}
+
+// appends the frame to the bucket as its newest frame
+static void lfuAttach(LFUState *lfu, int frame, int bucket)
+{
+    lfu->bucketOf[frame] = bucket;
+    lfu->counts[frame] = lfu->bucketCount[bucket];
+    lfu->next[frame] = NO_FRAME;
+    lfu->prev[frame] = lfu->bucketLast[bucket];
+    if (lfu->bucketLast[bucket] != NO_FRAME)
+        lfu->next[lfu->bucketLast[bucket]] = frame;
+    else
+        lfu->bucketFirst[bucket] = frame;
+    lfu->bucketLast[bucket] = frame;
+}
+
+// counts one more use of a frame that is in a bucket
+static void lfuPromote(LFUState *lfu, int frame)
+{
+    int bucket = lfu->bucketOf[frame];
+    int count = lfu->bucketCount[bucket] + 1;
+    int next = lfu->bucketNext[bucket];
+
+    // a frame alone in its bucket keeps the bucket if no bucket holds the next count yet
+    if (lfu->bucketFirst[bucket] == frame && lfu->bucketLast[bucket] == frame &&
+        (next == NO_BUCKET || lfu->bucketCount[next] > count))
+    {
+        lfu->bucketCount[bucket] = count;
+        lfu->counts[frame] = count;
+        return;
+    }
+
+    // the target is linked after the current bucket before that one can be emptied
+    int target = (next != NO_BUCKET && lfu->bucketCount[next] == count) ? next : lfuNewBucket(lfu, count, bucket);
+    lfuDetach(lfu, frame);
+    lfuAttach(lfu, frame, target);
+}
+
+// puts the frame into the bucket for a low count, 1 for a loaded page and 0 for an empty frame
+static void lfuPlace(LFUState *lfu, int frame, int count)
+{
+    int after = NO_BUCKET, bucket;
+
+    lfuDetach(lfu, frame);
+
+    // only the buckets for counts 0 and 1 can come before it, so the walk is at most two steps
+    bucket = lfu->lowest;
+    while (bucket != NO_BUCKET && lfu->bucketCount[bucket] < count)
+    {
+        after = bucket;
+        bucket = lfu->bucketNext[bucket];
+    }
+    if (bucket == NO_BUCKET || lfu->bucketCount[bucket] != count)
+    {
+        bucket = lfuNewBucket(lfu, count, after);
+    }
+    lfuAttach(lfu, frame, bucket);
+}
+
+static void lfuShutdown(void *state)
+{
+    LFUState *lfu = (LFUState *)state;
+
+    free(lfu->counts);
+    free(lfu->bucketOf);
+    free(lfu->prev);
+    free(lfu->next);
+    free(lfu->bucketCount);
+    free(lfu->bucketFirst);
+    free(lfu->bucketLast);
+    free(lfu->bucketPrev);
+    free(lfu->bucketNext);
+    free(lfu);
+}
+
+// needs one bucket more than there are frames, as a hit links the next bucket before it empties the current one
+static RC lfuInit(void **state, int numFrames, void *stratData)
+{
+    LFUState *lfu = (LFUState *)calloc(1, sizeof(LFUState));
+    if (lfu == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    lfu->counts = (int *)calloc(numFrames, sizeof(int));
+    lfu->bucketOf = (int *)malloc(sizeof(int) * numFrames);
+    lfu->prev = (int *)malloc(sizeof(int) * numFrames);
+    lfu->next = (int *)malloc(sizeof(int) * numFrames);
+    lfu->bucketCount = (int *)malloc(sizeof(int) * (numFrames + 1));
+    lfu->bucketFirst = (int *)malloc(sizeof(int) * (numFrames + 1));
+    lfu->bucketLast = (int *)malloc(sizeof(int) * (numFrames + 1));
+    lfu->bucketPrev = (int *)malloc(sizeof(int) * (numFrames + 1));
+    lfu->bucketNext = (int *)malloc(sizeof(int) * (numFrames + 1));
+    if (lfu->counts == NULL || lfu->bucketOf == NULL || lfu->prev == NULL || lfu->next == NULL ||
+        lfu->bucketCount == NULL || lfu->bucketFirst == NULL || lfu->bucketLast == NULL ||
+        lfu->bucketPrev == NULL || lfu->bucketNext == NULL)
+    {
+        lfuShutdown(lfu);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        lfu->bucketOf[i] = NO_BUCKET;
+        lfu->prev[i] = NO_FRAME;
+        lfu->next[i] = NO_FRAME;
+    }
+    // all buckets start unused
+    for (int i = 0; i <= numFrames; i++)
+    {
+        lfu->bucketNext[i] = i < numFrames ? i + 1 : NO_BUCKET;
+    }
+    lfu->numFrames = numFrames;
+    lfu->freeBuckets = 0;
+    lfu->lowest = NO_BUCKET;
+
+    *state = lfu;
+    return RC_OK;
+}
+
+static void lfuOnHit(void *state, int frame)
+{
+    lfuPromote((LFUState *)state, frame);
+}
+
+static void lfuOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    lfuPlace((LFUState *)state, frame, 1);
+}
+
+static void lfuOnEmpty(void *state, int frame)
+{
+    lfuPlace((LFUState *)state, frame, 0);
+}
+
+// walks the buckets from the lowest use count, each from its oldest frame
+static int lfuPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    LFUState *lfu = (LFUState *)state;
+
+    for (int bucket = lfu->lowest; bucket != NO_BUCKET; bucket = lfu->bucketNext[bucket])
+    {
+        for (int frame = lfu->bucketFirst[bucket]; frame != NO_FRAME; frame = lfu->next[frame])
+        {
+            if (fixCountOf(fixCounts, frame) == 0)
+            {
+                return frame;
+            }
+        }
+    }
+    return NO_FRAME;
+}
+
+// the frames the pool gave up leave their buckets, the buckets allocated for all frames suffice for fewer
+static void lfuOnResize(void *state, int numFrames)
+{
+    LFUState *lfu = (LFUState *)state;
+
+    for (int frame = numFrames; frame < lfu->numFrames; frame++)
+    {
+        lfuDetach(lfu, frame);
+        lfu->counts[frame] = 0;
+    }
+    lfu->numFrames = numFrames;
+}
+
+/*
+    # The LRU-K reference history, following O'Neil et al.: for every frame the times of the last
+      K uncorrelated references of its page, on a logical clock advanced by every pin.
+    # References that follow the previous one of the page within the correlated reference period
+      are treated as one, as they usually come from the same transaction or query.
+    # The victim is the unpinned page with the largest backward K-distance, pages with fewer than
+      K references have an infinite one and are replaced first, least recently referenced first.
+    # The history of evicted pages is retained in a table direct mapped on the page number, so
+      a hot page that was replaced once does not start over when it is read back.
+*/
+typedef struct LRUKState
+{
+    int numFrames;                 // number of frames in the pool
+    int k;                         // number of references kept per page
+    long correlatedPeriod;         // references at most this many pins apart count as one
+    long clock;                    // logical time, advanced by every pin
+    long *history;                 // k reference times per frame, most recent first, 0 where unknown
+    long *lastRef;                 // time of the latest reference of each frame, correlated or not
+    PageNumber *retainedPages;     // page whose history is kept in each slot of the retained table
+    long *retainedHistory;         // k reference times per slot of the retained table
+    int retainedMask;              // number of slots in the retained table minus one
+} LRUKState;
+
+// slot of the retained history table for the page
+static int lruKSlot(LRUKState *lruK, PageNumber pageNum)
+{
+    return (int)(((unsigned int)pageNum * 2654435761u) & (unsigned int)lruK->retainedMask);
+}
+
+// records a reference to the page held by the frame
+static void lruKReference(LRUKState *lruK, int frame)
+{
+    long now = ++lruK->clock;
+    long *history = lruK->history + (size_t)frame * lruK->k;
+
+    if (now - lruK->lastRef[frame] > lruK->correlatedPeriod)
+    {
+        // a new uncorrelated reference, the earlier ones move forward by the length of the correlated
+        // period that just closed so that it counts as a single reference
+        long correlated = lruK->lastRef[frame] - history[0];
+        for (int i = lruK->k - 1; i > 0; i--)
+        {
+            history[i] = history[i - 1] == 0 ? 0 : history[i - 1] + correlated;
+        }
+        history[0] = now;
+    }
+    lruK->lastRef[frame] = now;
+}
+
+// starts the history of a page read into the frame, picking up what was retained when it was evicted
+static void lruKLoad(LRUKState *lruK, int frame, PageNumber pageNum)
+{
+    long now = ++lruK->clock;
+    long *history = lruK->history + (size_t)frame * lruK->k;
+    int slot = lruKSlot(lruK, pageNum);
+
+    if (lruK->retainedPages[slot] == pageNum)
+    {
+        memcpy(history + 1, lruK->retainedHistory + (size_t)slot * lruK->k, sizeof(long) * (lruK->k - 1));
+        lruK->retainedPages[slot] = NO_PAGE;
+    }
+    else
+    {
+        memset(history + 1, 0, sizeof(long) * (lruK->k - 1));
+    }
+    history[0] = now;
+    lruK->lastRef[frame] = now;
+}
+
+// keeps the history of the page the frame is about to give up
+static void lruKEvict(LRUKState *lruK, int frame, PageNumber pageNum)
+{
+    int slot = lruKSlot(lruK, pageNum);
+
+    lruK->retainedPages[slot] = pageNum;
+    memcpy(lruK->retainedHistory + (size_t)slot * lruK->k, lruK->history + (size_t)frame * lruK->k,
+           sizeof(long) * lruK->k);
+}
+
+// forgets the history of a frame left empty, so it is replaced first
+static void lruKClear(LRUKState *lruK, int frame)
+{
+    memset(lruK->history + (size_t)frame * lruK->k, 0, sizeof(long) * lruK->k);
+    lruK->lastRef[frame] = 0;
+}
+
+static void lruKShutdown(void *state)
+{
+    LRUKState *lruK = (LRUKState *)state;
+
+    free(lruK->history);
+    free(lruK->lastRef);
+    free(lruK->retainedPages);
+    free(lruK->retainedHistory);
+    free(lruK);
+}
+
+// K and the correlated reference period come from a BM_LRUKParams passed as stratData
+static RC lruKInit(void **state, int numFrames, void *stratData)
+{
+    const BM_LRUKParams *params = (const BM_LRUKParams *)stratData;
+
+    // LRU-K needs at least one reference per page and a period that is not negative
+    if (params != NULL && (params->k < 1 || params->correlatedReferencePeriod < 0))
+    {
+        return RC_INVALID_INPUT;
+    }
+
+    LRUKState *lruK = (LRUKState *)calloc(1, sizeof(LRUKState));
+    if (lruK == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // without parameters the strategy is LRU-2 with every reference uncorrelated
+    lruK->numFrames = numFrames;
+    lruK->k = params != NULL ? params->k : 2;
+    lruK->correlatedPeriod = params != NULL ? params->correlatedReferencePeriod : 0;
+
+    // the retained table has at least one slot per frame
+    int slots = 1;
+    while (slots < numFrames)
+    {
+        slots <<= 1;
+    }
+    lruK->retainedMask = slots - 1;
+
+    lruK->history = (long *)calloc((size_t)numFrames * lruK->k, sizeof(long));
+    lruK->lastRef = (long *)calloc(numFrames, sizeof(long));
+    lruK->retainedPages = (PageNumber *)malloc(sizeof(PageNumber) * slots);
+    lruK->retainedHistory = (long *)malloc(sizeof(long) * (size_t)slots * lruK->k);
+    if (lruK->history == NULL || lruK->lastRef == NULL || lruK->retainedPages == NULL ||
+        lruK->retainedHistory == NULL)
+    {
+        lruKShutdown(lruK);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    for (int i = 0; i < slots; i++)
+    {
+        lruK->retainedPages[i] = NO_PAGE;
+    }
+
+    *state = lruK;
+    return RC_OK;
+}
+
+static void lruKOnHit(void *state, int frame)
+{
+    lruKReference((LRUKState *)state, frame);
+}
+
+static void lruKOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    lruKLoad((LRUKState *)state, frame, pageNum);
+}
+
+static void lruKOnEvict(void *state, int frame, PageNumber pageNum)
+{
+    lruKEvict((LRUKState *)state, frame, pageNum);
+}
+
+static void lruKOnEmpty(void *state, int frame)
+{
+    lruKClear((LRUKState *)state, frame);
+}
+
+/*
+    # Scans the dense history array for the unpinned page with the oldest K-th reference, where
+      0 stands for a page with fewer than K references and wins, ties go to the oldest last reference.
+    # Pages still inside their correlated reference period are only replaced if no other page can be.
+*/
+static int lruKPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    LRUKState *lruK = (LRUKState *)state;
+    long now = lruK->clock + 1;
+    int victim = NO_FRAME;
+    bool victimEligible = false;
+    long victimKth = 0, victimFirst = 0;
+
+    for (int frame = 0; frame < lruK->numFrames; frame++)
+    {
+        if (fixCountOf(fixCounts, frame) != 0)
+        {
+            continue;
+        }
+
+        long *history = lruK->history + (size_t)frame * lruK->k;
+        bool eligible = now - lruK->lastRef[frame] > lruK->correlatedPeriod;
+        long kth = history[lruK->k - 1], first = history[0];
+
+        if (victim == NO_FRAME || (eligible && !victimEligible) ||
+            (eligible == victimEligible && (kth < victimKth || (kth == victimKth && first < victimFirst))))
+        {
+            victim = frame;
+            victimEligible = eligible;
+            victimKth = kth;
+            victimFirst = first;
+        }
+    }
+    return victim;
+}
+
+// the history of the pages in the frames the pool gave up was retained when they were evicted
+static void lruKOnResize(void *state, int numFrames)
+{
+    LRUKState *lruK = (LRUKState *)state;
+
+    for (int frame = numFrames; frame < lruK->numFrames; frame++)
+    {
+        lruKClear(lruK, frame);
+    }
+    lruK->numFrames = numFrames;
+}
+
+/*
+    # The state shared by the ARC and 2Q Algorithms: two lists of resident frames and two ghost
+      lists of page numbers that were recently evicted, all ordered oldest first.
+    # LIST_RECENT holds pages referenced once since they were read in (ARC T1 and B1, 2Q A1in
+      and A1out), LIST_FREQUENT pages referenced again (ARC T2 and B2, 2Q Am).
+    # A ghost hit shows that a list gave up a page too early: ARC moves its target size of T1
+      towards that list, 2Q reads the page straight into Am. Ghost entries sit in a small hash
+      table on the page number so a miss finds them in O(1).
+*/
+
+// list index used for a frame or ghost entry that is in no list
+#define NO_LIST -1
+#define LIST_RECENT 0
+#define LIST_FREQUENT 1
+
+// a doubly linked list of indexes into shared prev and next arrays, from the oldest entry at head
+typedef struct IndexList
+{
+    int head, tail;
+    int size;
+} IndexList;
+
+typedef struct AdaptiveState
+{
+    bool arc;                      // ARC if set, 2Q otherwise
+    int numFrames;                 // number of frames in the pool
+    int *listOf;                   // resident list of each frame
+    int *prev, *next;              // links of the frames in their resident list
+    IndexList resident[2];         // resident frames, ARC T1 and T2, 2Q A1in and Am
+    PageNumber *ghostPages;        // page number remembered by each ghost entry
+    int *ghostListOf;              // ghost list of each entry
+    int *ghostPrev, *ghostNext;    // links of the entries in their ghost list, unused ones chain through ghostNext
+    int *ghostHashNext;            // next entry in the same ghost table bucket
+    int *ghostTable;               // bucket heads of the ghost table
+    int ghostMask;                 // number of buckets in the ghost table minus one
+    int freeGhosts;                // first unused ghost entry
+    IndexList ghosts[2];           // ARC B1 and B2, 2Q A1out and an unused list
+    int target;                    // ARC: the size of T1 the pool adapts towards
+    int recentLimit, ghostLimit;   // 2Q: sizes of A1in and A1out
+} AdaptiveState;
+
+static void indexListUnlink(int *prev, int *next, IndexList *list, int i)
+{
+    if (prev[i] != NO_FRAME)
+        next[prev[i]] = next[i];
+    else
+        list->head = next[i];
+    if (next[i] != NO_FRAME)
+        prev[next[i]] = prev[i];
+    else
+        list->tail = prev[i];
+    prev[i] = NO_FRAME;
+    next[i] = NO_FRAME;
+    list->size--;
+}
+
+// links the entry as the newest of the list
+static void indexListAppend(int *prev, int *next, IndexList *list, int i)
+{
+    prev[i] = list->tail;
+    next[i] = NO_FRAME;
+    if (list->tail != NO_FRAME)
+        next[list->tail] = i;
+    else
+        list->head = i;
+    list->tail = i;
+    list->size++;
+}
+
+// links the entry as the oldest of the list
+static void indexListPrepend(int *prev, int *next, IndexList *list, int i)
+{
+    next[i] = list->head;
+    prev[i] = NO_FRAME;
+    if (list->head != NO_FRAME)
+        prev[list->head] = i;
+    else
+        list->tail = i;
+    list->head = i;
+    list->size++;
+}
+
+// takes the frame out of its resident list, if it is in one
+static void adaptiveUnlinkFrame(AdaptiveState *adaptive, int frame)
+{
+    if (adaptive->listOf[frame] != NO_LIST)
+    {
+        indexListUnlink(adaptive->prev, adaptive->next, &adaptive->resident[adaptive->listOf[frame]], frame);
+        adaptive->listOf[frame] = NO_LIST;
+    }
+}
+
+// makes the frame the newest of the resident list
+static void adaptiveAppendFrame(AdaptiveState *adaptive, int frame, int list)
+{
+    adaptiveUnlinkFrame(adaptive, frame);
+    indexListAppend(adaptive->prev, adaptive->next, &adaptive->resident[list], frame);
+    adaptive->listOf[frame] = list;
+}
+
+static int ghostBucket(AdaptiveState *adaptive, PageNumber pageNum)
+{
+    return (int)(((unsigned int)pageNum * 2654435761u) & (unsigned int)adaptive->ghostMask);
+}
+
+// returns the ghost entry of the page or NO_FRAME if the page was not evicted recently
+static int ghostFind(AdaptiveState *adaptive, PageNumber pageNum)
+{
+    int entry = adaptive->ghostTable[ghostBucket(adaptive, pageNum)];
+
+    while (entry != NO_FRAME && adaptive->ghostPages[entry] != pageNum)
+    {
+        entry = adaptive->ghostHashNext[entry];
+    }
+    return entry;
+}
+
+// forgets the ghost entry
+static void ghostRemove(AdaptiveState *adaptive, int entry)
+{
+    int *link = &adaptive->ghostTable[ghostBucket(adaptive, adaptive->ghostPages[entry])];
+
+    while (*link != entry)
+    {
+        link = &adaptive->ghostHashNext[*link];
+    }
+    *link = adaptive->ghostHashNext[entry];
+
+    indexListUnlink(adaptive->ghostPrev, adaptive->ghostNext, &adaptive->ghosts[adaptive->ghostListOf[entry]], entry);
+    adaptive->ghostListOf[entry] = NO_LIST;
+    adaptive->ghostPages[entry] = NO_PAGE;
+    adaptive->ghostNext[entry] = adaptive->freeGhosts;
+    adaptive->freeGhosts = entry;
+}
+
+// remembers the evicted page as the newest entry of the ghost list
+static void ghostAdd(AdaptiveState *adaptive, int list, PageNumber pageNum)
+{
+    // the ghost lists are trimmed on every load, so running out of entries is only a safety net
+    if (adaptive->freeGhosts == NO_FRAME)
+    {
+        IndexList *oldest = adaptive->ghosts[list].size > 0 ? &adaptive->ghosts[list] : &adaptive->ghosts[1 - list];
+        ghostRemove(adaptive, oldest->head);
+    }
+
+    int entry = adaptive->freeGhosts;
+    int bucket = ghostBucket(adaptive, pageNum);
+
+    adaptive->freeGhosts = adaptive->ghostNext[entry];
+    adaptive->ghostPages[entry] = pageNum;
+    adaptive->ghostListOf[entry] = list;
+    indexListAppend(adaptive->ghostPrev, adaptive->ghostNext, &adaptive->ghosts[list], entry);
+    adaptive->ghostHashNext[entry] = adaptive->ghostTable[bucket];
+    adaptive->ghostTable[bucket] = entry;
+}
+
+// drops the oldest entries of the ghost list until it holds at most limit pages
+static void ghostTrim(AdaptiveState *adaptive, int list, int limit)
+{
+    while (adaptive->ghosts[list].size > limit && adaptive->ghosts[list].size > 0)
+    {
+        ghostRemove(adaptive, adaptive->ghosts[list].head);
+    }
+}
+
+/*
+    # ARC target size of T1 after a miss on the page with the given ghost entry (NO_FRAME for none).
+    # A hit in B1 grows the target, a hit in B2 shrinks it, by the ratio of the ghost list sizes.
+*/
+static int arcTarget(AdaptiveState *adaptive, int numPages, int ghost)
+{
+    IndexList *b1 = &adaptive->ghosts[LIST_RECENT], *b2 = &adaptive->ghosts[LIST_FREQUENT];
+
+    if (ghost == NO_FRAME)
+    {
+        return adaptive->target;
+    }
+    if (adaptive->ghostListOf[ghost] == LIST_RECENT)
+    {
+        int delta = b2->size > b1->size ? b2->size / b1->size : 1;
+        return adaptive->target + delta < numPages ? adaptive->target + delta : numPages;
+    }
+    int delta = b1->size > b2->size ? b1->size / b2->size : 1;
+    return adaptive->target - delta > 0 ? adaptive->target - delta : 0;
+}
+
+// a buffer hit: ARC moves the frame to the newest end of T2, 2Q only reorders Am
+static void adaptiveReference(AdaptiveState *adaptive, int frame)
+{
+    if (adaptive->arc || adaptive->listOf[frame] == LIST_FREQUENT)
+    {
+        adaptiveAppendFrame(adaptive, frame, LIST_FREQUENT);
+    }
+}
+
+// the page held by the frame is evicted, it leaves a ghost unless 2Q evicts it from Am
+static void adaptiveEvict(AdaptiveState *adaptive, int frame, PageNumber pageNum)
+{
+    int list = adaptive->listOf[frame];
+
+    adaptiveUnlinkFrame(adaptive, frame);
+    if (list != NO_LIST && (adaptive->arc || list == LIST_RECENT))
+    {
+        ghostAdd(adaptive, list, pageNum);
+    }
+}
+
+// a page was read into the frame: a ghost hit goes to the frequent list, any other page to the recent one
+static void adaptiveLoad(AdaptiveState *adaptive, int frame, PageNumber pageNum)
+{
+    int numPages = adaptive->numFrames;
+    int ghost = ghostFind(adaptive, pageNum);
+
+    if (adaptive->arc)
+    {
+        adaptive->target = arcTarget(adaptive, numPages, ghost);
+    }
+    if (ghost != NO_FRAME)
+    {
+        ghostRemove(adaptive, ghost);
+    }
+    adaptiveAppendFrame(adaptive, frame, ghost != NO_FRAME ? LIST_FREQUENT : LIST_RECENT);
+
+    if (adaptive->arc)
+    {
+        // T1 and B1 together hold at most one pool of pages, all four lists at most two
+        int recent = adaptive->resident[LIST_RECENT].size;
+        int resident = recent + adaptive->resident[LIST_FREQUENT].size;
+        ghostTrim(adaptive, LIST_RECENT, numPages - recent);
+        ghostTrim(adaptive, LIST_FREQUENT, 2 * numPages - resident - adaptive->ghosts[LIST_RECENT].size);
+    }
+    else
+    {
+        ghostTrim(adaptive, LIST_RECENT, adaptive->ghostLimit);
+    }
+}
+
+// a frame left empty becomes the oldest of the recent list, so it is replaced first
+static void adaptiveClear(AdaptiveState *adaptive, int frame)
+{
+    adaptiveUnlinkFrame(adaptive, frame);
+    indexListPrepend(adaptive->prev, adaptive->next, &adaptive->resident[LIST_RECENT], frame);
+    adaptive->listOf[frame] = LIST_RECENT;
+}
+
+static void adaptiveShutdown(void *state)
+{
+    AdaptiveState *adaptive = (AdaptiveState *)state;
+
+    free(adaptive->listOf);
+    free(adaptive->prev);
+    free(adaptive->next);
+    free(adaptive->ghostPages);
+    free(adaptive->ghostListOf);
+    free(adaptive->ghostPrev);
+    free(adaptive->ghostNext);
+    free(adaptive->ghostHashNext);
+    free(adaptive->ghostTable);
+    free(adaptive);
+}
+
+/*
+    # ARC and 2Q remember up to two pools worth of evicted pages, 2Q sizes A1in to a quarter
+      and A1out to half of the pool as recommended by Johnson and Shasha.
+*/
+static RC adaptiveInit(void **state, int numFrames, bool arc)
+{
+    AdaptiveState *adaptive = (AdaptiveState *)calloc(1, sizeof(AdaptiveState));
+    if (adaptive == NULL)
+    {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    adaptive->arc = arc;
+    adaptive->numFrames = numFrames;
+
+    int entries = 2 * numFrames;
+    int buckets = 1;
+    while (buckets < 2 * entries)
+    {
+        buckets <<= 1;
+    }
+    adaptive->ghostMask = buckets - 1;
+
+    adaptive->listOf = (int *)malloc(sizeof(int) * numFrames);
+    adaptive->prev = (int *)malloc(sizeof(int) * numFrames);
+    adaptive->next = (int *)malloc(sizeof(int) * numFrames);
+    adaptive->ghostPages = (PageNumber *)malloc(sizeof(PageNumber) * entries);
+    adaptive->ghostListOf = (int *)malloc(sizeof(int) * entries);
+    adaptive->ghostPrev = (int *)malloc(sizeof(int) * entries);
+    adaptive->ghostNext = (int *)malloc(sizeof(int) * entries);
+    adaptive->ghostHashNext = (int *)malloc(sizeof(int) * entries);
+    adaptive->ghostTable = (int *)malloc(sizeof(int) * buckets);
+    if (adaptive->listOf == NULL || adaptive->prev == NULL || adaptive->next == NULL ||
+        adaptive->ghostPages == NULL || adaptive->ghostListOf == NULL || adaptive->ghostPrev == NULL ||
+        adaptive->ghostNext == NULL || adaptive->ghostHashNext == NULL || adaptive->ghostTable == NULL)
+    {
+        adaptiveShutdown(adaptive);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        adaptive->listOf[i] = NO_LIST;
+        adaptive->prev[i] = NO_FRAME;
+        adaptive->next[i] = NO_FRAME;
+    }
+    // all ghost entries start unused
+    for (int i = 0; i < entries; i++)
+    {
+        adaptive->ghostPages[i] = NO_PAGE;
+        adaptive->ghostListOf[i] = NO_LIST;
+        adaptive->ghostPrev[i] = NO_FRAME;
+        adaptive->ghostNext[i] = i + 1 < entries ? i + 1 : NO_FRAME;
+        adaptive->ghostHashNext[i] = NO_FRAME;
+    }
+    for (int i = 0; i < buckets; i++)
+    {
+        adaptive->ghostTable[i] = NO_FRAME;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        adaptive->resident[i].head = adaptive->resident[i].tail = NO_FRAME;
+        adaptive->ghosts[i].head = adaptive->ghosts[i].tail = NO_FRAME;
+    }
+    adaptive->freeGhosts = 0;
+    adaptive->target = 0;
+    adaptive->recentLimit = numFrames / 4 > 0 ? numFrames / 4 : 1;
+    adaptive->ghostLimit = numFrames / 2 > 0 ? numFrames / 2 : 1;
+
+    *state = adaptive;
+    return RC_OK;
+}
+
+static RC arcInit(void **state, int numFrames, void *stratData)
+{
+    return adaptiveInit(state, numFrames, true);
+}
+
+static RC twoQInit(void **state, int numFrames, void *stratData)
+{
+    return adaptiveInit(state, numFrames, false);
+}
+
+static void adaptiveOnHit(void *state, int frame)
+{
+    adaptiveReference((AdaptiveState *)state, frame);
+}
+
+static void adaptiveOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    adaptiveLoad((AdaptiveState *)state, frame, pageNum);
+}
+
+static void adaptiveOnEvict(void *state, int frame, PageNumber pageNum)
+{
+    adaptiveEvict((AdaptiveState *)state, frame, pageNum);
+}
+
+static void adaptiveOnEmpty(void *state, int frame)
+{
+    adaptiveClear((AdaptiveState *)state, frame);
+}
+
+// returns the oldest unpinned frame of the resident list, NO_FRAME if all of them are in use
+static int oldestUnpinned(AdaptiveState *adaptive, const int *fixCounts, IndexList *list)
+{
+    int frame = list->head;
+
+    while (frame != NO_FRAME && fixCountOf(fixCounts, frame) != 0)
+    {
+        frame = adaptive->next[frame];
+    }
+    return frame;
+}
+
+/*
+    # ARC replaces from T1 while it is larger than its target size, and also when it is exactly
+      at its target and the page to be read in comes from B2. 2Q replaces from A1in while it is over its size.
+    # Otherwise the page is replaced from the frequent list, and if all pages of the chosen
+      list are pinned the other list is used.
+*/
+static int adaptivePickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    AdaptiveState *adaptive = (AdaptiveState *)state;
+    int recent = adaptive->resident[LIST_RECENT].size;
+    bool fromRecent;
+
+    if (adaptive->arc)
+    {
+        int ghost = ghostFind(adaptive, pageNum);
+        int target = arcTarget(adaptive, adaptive->numFrames, ghost);
+        bool fromB2 = ghost != NO_FRAME && adaptive->ghostListOf[ghost] == LIST_FREQUENT;
+        fromRecent = recent > 0 && (recent > target || (recent == target && fromB2));
+    }
+    else
+    {
+        fromRecent = recent > adaptive->recentLimit;
+    }
+
+    int first = fromRecent ? LIST_RECENT : LIST_FREQUENT;
+    int frame = oldestUnpinned(adaptive, fixCounts, &adaptive->resident[first]);
+    if (frame == NO_FRAME)
+    {
+        frame = oldestUnpinned(adaptive, fixCounts, &adaptive->resident[1 - first]);
+    }
+    return frame;
+}
+
+/*
+    # The evicted frames already left the resident lists. The target size of ARC and the sizes of
+      2Q follow the new size, and the ghost lists shrink to what that size allows.
+    # The ghost entries allocated for the frames given to init are enough for any smaller pool.
+*/
+static void adaptiveOnResize(void *state, int numFrames)
+{
+    AdaptiveState *adaptive = (AdaptiveState *)state;
+
+    adaptive->numFrames = numFrames;
+    if (adaptive->target > numFrames)
+    {
+        adaptive->target = numFrames;
+    }
+    adaptive->recentLimit = numFrames / 4 > 0 ? numFrames / 4 : 1;
+    adaptive->ghostLimit = numFrames / 2 > 0 ? numFrames / 2 : 1;
+
+    if (adaptive->arc)
+    {
+        int recent = adaptive->resident[LIST_RECENT].size;
+        int resident = recent + adaptive->resident[LIST_FREQUENT].size;
+        ghostTrim(adaptive, LIST_RECENT, numFrames - recent);
+        ghostTrim(adaptive, LIST_FREQUENT, 2 * numFrames - resident - adaptive->ghosts[LIST_RECENT].size);
+    }
+    else
+    {
+        ghostTrim(adaptive, LIST_RECENT, adaptive->ghostLimit);
+    }
+}
+
+/*
+    # The registry of replacement policies, indexed by strategy id.
+    # Custom policies are registered before the pools using them are created, the registry itself
+      is not protected against concurrent registration.
+*/
+static const BM_ReplacementPolicy fifoPolicy = {"FIFO", fifoInit, fifoShutdown, NULL, NULL, NULL, NULL,
+                                                fifoPickVictim, true, true, fifoOnResize};
+static const BM_ReplacementPolicy lruPolicy = {"LRU", lruInit, lruShutdown, lruOnHit, lruOnInsert, NULL,
+                                               lruOnEmpty, lruPickVictim, false, false, lruOnResize};
+static const BM_ReplacementPolicy clockPolicy = {"CLOCK", clockInit, clockShutdown, clockOnHit, clockOnInsert,
+                                                 NULL, clockOnEmpty, clockPickVictim, true, true,
+                                                 clockOnResize};
+static const BM_ReplacementPolicy lfuPolicy = {"LFU", lfuInit, lfuShutdown, lfuOnHit, lfuOnInsert, NULL,
+                                               lfuOnEmpty, lfuPickVictim, false, false, lfuOnResize};
+static const BM_ReplacementPolicy lruKPolicy = {"LRU-K", lruKInit, lruKShutdown, lruKOnHit, lruKOnInsert,
+                                                lruKOnEvict, lruKOnEmpty, lruKPickVictim, false, false,
+                                                lruKOnResize};
+static const BM_ReplacementPolicy arcPolicy = {"ARC", arcInit, adaptiveShutdown, adaptiveOnHit, adaptiveOnInsert,
+                                               adaptiveOnEvict, adaptiveOnEmpty, adaptivePickVictim, false, false,
+                                               adaptiveOnResize};
+static const BM_ReplacementPolicy twoQPolicy = {"2Q", twoQInit, adaptiveShutdown, adaptiveOnHit, adaptiveOnInsert,
+                                                adaptiveOnEvict, adaptiveOnEmpty, adaptivePickVictim, false, false,
+                                                adaptiveOnResize};
+
+static const BM_ReplacementPolicy *policies[BM_MAX_STRATEGIES] = {
+    [RS_FIFO] = &fifoPolicy,
+    [RS_LRU] = &lruPolicy,
+    [RS_CLOCK] = &clockPolicy,
+    [RS_LFU] = &lfuPolicy,
+    [RS_LRU_K] = &lruKPolicy,
+    [RS_ARC] = &arcPolicy,
+    [RS_2Q] = &twoQPolicy};
+
+// returns the policy implementing the strategy, NULL if there is none
+const BM_ReplacementPolicy *getReplacementPolicy(ReplacementStrategy strategy)
+{
+    if ((int)strategy < 0 || (int)strategy >= BM_MAX_STRATEGIES)
+    {
+        return NULL;
+    }
+    return policies[strategy];
+}
+
+/*
+    # Makes the policy available under a strategy id that is not taken yet, usually one above RS_2Q.
+    # The policy is referenced, not copied, so it has to stay valid while pools use it.
+*/
+RC registerReplacementPolicy(ReplacementStrategy strategy, const BM_ReplacementPolicy *policy)
+{
+    if (policy == NULL || policy->init == NULL || policy->pickVictim == NULL ||
+        (int)strategy < 0 || (int)strategy >= BM_MAX_STRATEGIES || policies[strategy] != NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+    policies[strategy] = policy;
+    return RC_OK;
+}
@@ -0,0 +1,59 @@
+#ifndef BUFFER_POLICY_H
+#define BUFFER_POLICY_H
+
+// Include the buffer pool types
+#include "buffer_mgr.h"
+
+// frame index meaning no frame, frames are numbered from 0 to numPages - 1
+#define NO_FRAME -1
+
+// number of strategy ids, the built in ones and those registered with registerReplacementPolicy
+#define BM_MAX_STRATEGIES 32
+
+// A page replacement policy, each buffer pool keeps its own state created by init.
+// The buffer manager calls the hooks with the page table latched exclusively, except onHit,
+// which runs in parallel with other pins and is serialised by the buffer manager unless the
+// policy sets concurrentHits. A policy that also sets optimisticHits lets pools created with that
+// option call onHit without any latch, in parallel with all other hooks. Hooks a policy does not
+// need may be NULL.
+typedef struct BM_ReplacementPolicy
+{
+	const char *name;
+	// creates the state for a pool of numFrames frames, stratData is passed on from initBufferPool
+	RC (*init)(void **state, int numFrames, void *stratData);
+	void (*shutdown)(void *state);
+	// a resident page was pinned
+	void (*onHit)(void *state, int frame);
+	// pageNum was assigned to the frame, which is either still free or the last victim
+	void (*onInsert)(void *state, int frame, PageNumber pageNum);
+	// the page held by the frame is about to be replaced
+	void (*onEvict)(void *state, int frame, PageNumber pageNum);
+	// reading the page into the frame failed, it holds no page now and should be replaced first
+	void (*onEmpty)(void *state, int frame);
+	// returns the frame to replace for pageNum, one with fix count 0, or NO_FRAME if all are in use
+	int (*pickVictim)(void *state, const int *fixCounts, PageNumber pageNum);
+	bool concurrentHits; // onHit takes care of its own synchronisation
+	bool optimisticHits; // onHit may run next to the other hooks, which read fix counts with fixCountOf
+	// resizeBufferPool changed the pool to frames 0 to numFrames - 1 of those given to init, the frames
+	// it gave up were evicted before and stay pinned until the pool grows again
+	void (*onResize)(void *state, int numFrames);
+} BM_ReplacementPolicy;
+
+// reads the fix count of a frame in pickVictim, optimistic pins may change it at any time
+static inline int fixCountOf(const int *fixCounts, int frame)
+{
+	return __atomic_load_n(&fixCounts[frame], __ATOMIC_RELAXED);
+}
+
+// The page number the hooks are given for pageNum of the given file of a pool, see openPoolFile. It is
+// pageNum itself for the file the pool was created with, pages of other files may share one.
+static inline PageNumber pageKeyOf(int file, PageNumber pageNum)
+{
+	return (PageNumber)(((unsigned int)pageNum ^ ((unsigned int)file << 20)) & 0x7fffffffu);
+}
+
+// Replacement policy registry
+const BM_ReplacementPolicy *getReplacementPolicy(ReplacementStrategy strategy);
+RC registerReplacementPolicy(ReplacementStrategy strategy, const BM_ReplacementPolicy *policy);
+
+#endif
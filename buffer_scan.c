@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_scan.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+    # Every kernel builds the mask from groups of frames that fill one vector register, the frames
+      after the last full group are tested one by one. bool is a short, see dt.h, so a register
+      holds twice as many flags as fix counts.
+    # The plain loops read with relaxed atomic loads, which makes them the kernel to use under a
+      race detector.
+*/
+
+static uint64_t unpinnedMaskScalar(const int *fixCounts, int from, int count)
+{
+    uint64_t mask = 0;
+
+    for (int i = from; i < count; i++)
+    {
+        if (__atomic_load_n(&fixCounts[i], __ATOMIC_RELAXED) == 0)
+        {
+            mask |= 1ull << i;
+        }
+    }
+    return mask;
+}
+
+static uint64_t flagMaskScalar(const bool *flags, int from, int count)
+{
+    uint64_t mask = 0;
+
+    for (int i = from; i < count; i++)
+    {
+        if (__atomic_load_n(&flags[i], __ATOMIC_RELAXED))
+        {
+            mask |= 1ull << i;
+        }
+    }
+    return mask;
+}
+
+static uint64_t unpinnedMaskPlain(const int *fixCounts, int count)
+{
+    return unpinnedMaskScalar(fixCounts, 0, count);
+}
+
+static uint64_t flagMaskPlain(const bool *flags, int count)
+{
+    return flagMaskScalar(flags, 0, count);
+}
+
+#if defined(__x86_64__)
+
+// 4 fix counts and 16 flags per group, SSE2 is part of every x86-64 CPU
+static uint64_t unpinnedMaskSSE2(const int *fixCounts, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i counts = _mm_loadu_si128((const __m128i *)&fixCounts[i]);
+        __m128i unpinned = _mm_cmpeq_epi32(counts, zero);
+        mask |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(unpinned)) << i;
+    }
+    return mask | unpinnedMaskScalar(fixCounts, i, count);
+}
+
+static uint64_t flagMaskSSE2(const bool *flags, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i low = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)&flags[i]), zero);
+        __m128i high = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)&flags[i + 8]), zero);
+        // one byte per flag, set where the flag is clear
+        unsigned int clear = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(low, high));
+        mask |= (uint64_t)(~clear & 0xffffu) << i;
+    }
+    return mask | flagMaskScalar(flags, i, count);
+}
+
+// 8 fix counts and 32 flags per group
+__attribute__((target("avx2"))) static uint64_t unpinnedMaskAVX2(const int *fixCounts, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i counts = _mm256_loadu_si256((const __m256i *)&fixCounts[i]);
+        __m256i unpinned = _mm256_cmpeq_epi32(counts, zero);
+        mask |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(unpinned)) << i;
+    }
+    return mask | unpinnedMaskScalar(fixCounts, i, count);
+}
+
+__attribute__((target("avx2"))) static uint64_t flagMaskAVX2(const bool *flags, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i low = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)&flags[i]), zero);
+        __m256i high = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)&flags[i + 16]), zero);
+        // packing works within each 128 bit lane, the permute puts the bytes back in frame order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xd8);
+        unsigned int clear = (unsigned int)_mm256_movemask_epi8(packed);
+        mask |= (uint64_t)~clear << i;
+    }
+    return mask | flagMaskScalar(flags, i, count);
+}
+
+#elif defined(__aarch64__)
+
+// 4 fix counts and 8 flags per group, every lane that matches adds its own bit to the sum
+static uint64_t unpinnedMaskNEON(const int *fixCounts, int count)
+{
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vld1q_u32(laneBits);
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32x4_t unpinned = vceqzq_s32(vld1q_s32(&fixCounts[i]));
+        mask |= (uint64_t)vaddvq_u32(vandq_u32(unpinned, bits)) << i;
+    }
+    return mask | unpinnedMaskScalar(fixCounts, i, count);
+}
+
+static uint64_t flagMaskNEON(const bool *flags, int count)
+{
+    static const uint16_t laneBits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint16x8_t bits = vld1q_u16(laneBits);
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t set = vtstq_s16(vld1q_s16(&flags[i]), vdupq_n_s16(-1));
+        mask |= (uint64_t)vaddvq_u16(vandq_u16(set, bits)) << i;
+    }
+    return mask | flagMaskScalar(flags, i, count);
+}
+
+#endif
+
+static uint64_t (*unpinnedMaskKernel)(const int *fixCounts, int count) = unpinnedMaskPlain;
+static uint64_t (*flagMaskKernel)(const bool *flags, int count) = flagMaskPlain;
+static const char *kernelName = "scalar";
+
+// picks the kernel before main runs, so the pointers never change while pools use them
+__attribute__((constructor)) static void pickScanKernel(void)
+{
+    const char *forced = getenv("BM_SCAN_KERNEL");
+    if (forced != NULL && strcmp(forced, "scalar") == 0)
+    {
+        return;
+    }
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        unpinnedMaskKernel = unpinnedMaskAVX2;
+        flagMaskKernel = flagMaskAVX2;
+        kernelName = "avx2";
+    }
+    else
+    {
+        unpinnedMaskKernel = unpinnedMaskSSE2;
+        flagMaskKernel = flagMaskSSE2;
+        kernelName = "sse2";
+    }
+#elif defined(__aarch64__)
+    unpinnedMaskKernel = unpinnedMaskNEON;
+    flagMaskKernel = flagMaskNEON;
+    kernelName = "neon";
+#endif
+}
+
+uint64_t unpinnedMaskOf(const int *fixCounts, int count)
+{
+    return unpinnedMaskKernel(fixCounts, count);
+}
+
+uint64_t flagMaskOf(const bool *flags, int count)
+{
+    return flagMaskKernel(flags, count);
+}
+
+const char *scanKernelName(void)
+{
+    return kernelName;
+}
@@ -0,0 +1,31 @@
+#ifndef BUFFER_SCAN_H
+#define BUFFER_SCAN_H
+
+#include <stdint.h>
+
+#include "dt.h"
+
+/*
+    # Kernels that test a block of up to SCAN_BLOCK_FRAMES frames of the dense frame arrays at once and
+      return one bit per frame, bit i for frame i of the block, so the loops over all frames of a
+      pool skip the frames they are not after a block at a time.
+    # The kernel is picked once, when the program starts, from what the CPU supports: AVX2 or SSE2 on
+      x86-64, NEON on AArch64 and plain loops elsewhere. Setting the BM_SCAN_KERNEL environment variable
+      to scalar picks the plain loops everywhere.
+    # The vector kernels read the arrays with plain loads while other threads change them, so the bits
+      are a snapshot, and every caller checks a frame again with the usual atomics before it uses it.
+*/
+
+// number of frames a kernel tests at most
+#define SCAN_BLOCK_FRAMES 64
+
+// bit i is set if fixCounts[i] is 0, for count frames of at most SCAN_BLOCK_FRAMES
+uint64_t unpinnedMaskOf(const int *fixCounts, int count);
+
+// bit i is set if flags[i] is set, for count frames of at most SCAN_BLOCK_FRAMES
+uint64_t flagMaskOf(const bool *flags, int count);
+
+// name of the kernel in use, avx2, sse2, neon or scalar
+const char *scanKernelName(void);
+
+#endif
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "buffer_trace.h"
+
+/*
+    # The trace writer of a pool. Threads claim the next position of a ring buffer of records with
+      an atomic add, fill in the record and publish it by storing its position in sequences, so
+      appending never takes a latch.
+    # The writer thread copies the published records from tail on into the file, stopping at the
+      first record that is still being filled in, and frees their positions by advancing tail.
+      It is woken up when the ring is half full and otherwise writes every TRACE_FLUSH_MS.
+    # A thread that finds the ring full waits for the writer to free positions, so no record is lost.
+*/
+
+// number of records in the ring buffer, a power of two
+#define TRACE_RING_RECORDS 65536
+// longest time a record stays in the ring buffer while the pool is traced
+#define TRACE_FLUSH_MS 100
+
+struct BM_TraceWriter
+{
+    FILE *file;
+    BM_TraceRecord *ring;
+    uint64_t *sequences;    // position + 1 of the record in each slot once it is published
+    uint64_t head;          // next position to claim
+    uint64_t tail;          // first position not written to the file yet
+    uint64_t startNanos;    // time the trace was started
+    bool failed;            // a write to the file failed
+    bool stop;              // asks the writer thread to write the rest and exit, protected by latch
+    pthread_t thread;
+    pthread_mutex_t latch;  // protects stop and the wake ups of the writer thread
+    pthread_cond_t wake;
+};
+
+// small number of the calling thread in traces, -1 until it first appends a record
+static __thread int traceThreadId = -1;
+// number given to the next thread
+static int nextTraceThread;
+
+static uint64_t traceNanos(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void wakeWriter(BM_TraceWriter *writer)
+{
+    pthread_mutex_lock(&writer->latch);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->latch);
+}
+
+// writes the published records from tail on to the file, returns how many were written
+static uint64_t drainRing(BM_TraceWriter *writer)
+{
+    uint64_t tail = writer->tail;
+    uint64_t end = tail;
+
+    while (end - tail < TRACE_RING_RECORDS &&
+           __atomic_load_n(&writer->sequences[end % TRACE_RING_RECORDS], __ATOMIC_ACQUIRE) == end + 1)
+    {
+        end++;
+    }
+
+    // the records between tail and end are contiguous in the ring except where it wraps around
+    for (uint64_t pos = tail; pos < end;)
+    {
+        size_t first = pos % TRACE_RING_RECORDS;
+        size_t count = end - pos;
+        if (count > TRACE_RING_RECORDS - first)
+        {
+            count = TRACE_RING_RECORDS - first;
+        }
+        if (fwrite(&writer->ring[first], sizeof(BM_TraceRecord), count, writer->file) != count)
+        {
+            writer->failed = true;
+        }
+        pos += count;
+    }
+
+    __atomic_store_n(&writer->tail, end, __ATOMIC_RELEASE);
+    return end - tail;
+}
+
+// body of the writer thread
+static void *traceWriter(void *arg)
+{
+    BM_TraceWriter *writer = (BM_TraceWriter *)arg;
+
+    pthread_mutex_lock(&writer->latch);
+    while (!writer->stop)
+    {
+        uint64_t pending = __atomic_load_n(&writer->head, __ATOMIC_RELAXED) - writer->tail;
+        if (pending < TRACE_RING_RECORDS / 2)
+        {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += TRACE_FLUSH_MS * 1000000L;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&writer->wake, &writer->latch, &until);
+        }
+
+        pthread_mutex_unlock(&writer->latch);
+        drainRing(writer);
+        pthread_mutex_lock(&writer->latch);
+    }
+    pthread_mutex_unlock(&writer->latch);
+
+    // the pool stopped appending before the writer was stopped
+    while (drainRing(writer) > 0)
+    {
+    }
+    return NULL;
+}
+
+BM_TraceWriter *traceWriterCreate(const char *fileName, int numFrames)
+{
+    BM_TraceWriter *writer = (BM_TraceWriter *)calloc(1, sizeof(BM_TraceWriter));
+    BM_TraceHeader header;
+
+    if (writer == NULL)
+    {
+        return NULL;
+    }
+    writer->ring = (BM_TraceRecord *)malloc(sizeof(BM_TraceRecord) * TRACE_RING_RECORDS);
+    writer->sequences = (uint64_t *)calloc(TRACE_RING_RECORDS, sizeof(uint64_t));
+    writer->file = fopen(fileName, "wb");
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BM_TRACE_MAGIC, sizeof(header.magic));
+    header.recordSize = sizeof(BM_TraceRecord);
+    header.numFrames = (uint32_t)numFrames;
+
+    if (writer->ring == NULL || writer->sequences == NULL || writer->file == NULL ||
+        fwrite(&header, sizeof(header), 1, writer->file) != 1)
+    {
+        if (writer->file != NULL)
+        {
+            fclose(writer->file);
+        }
+        free(writer->ring);
+        free(writer->sequences);
+        free(writer);
+        return NULL;
+    }
+
+    writer->startNanos = traceNanos();
+    pthread_mutex_init(&writer->latch, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    if (pthread_create(&writer->thread, NULL, traceWriter, writer) != 0)
+    {
+        pthread_mutex_destroy(&writer->latch);
+        pthread_cond_destroy(&writer->wake);
+        fclose(writer->file);
+        free(writer->ring);
+        free(writer->sequences);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void traceWriterAppend(BM_TraceWriter *writer, int file, PageNumber pageNum, int op)
+{
+    if (traceThreadId < 0)
+    {
+        traceThreadId = __atomic_fetch_add(&nextTraceThread, 1, __ATOMIC_RELAXED);
+    }
+
+    uint64_t pos = __atomic_fetch_add(&writer->head, 1, __ATOMIC_RELAXED);
+    uint64_t used = pos - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE);
+
+    // the ring is full, the writer frees the oldest positions
+    while (used >= TRACE_RING_RECORDS)
+    {
+        wakeWriter(writer);
+        sched_yield();
+        used = pos - __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE);
+    }
+
+    BM_TraceRecord *record = &writer->ring[pos % TRACE_RING_RECORDS];
+    record->pageNum = pageNum;
+    record->thread = (uint16_t)traceThreadId;
+    record->op = (uint8_t)op;
+    record->file = (uint8_t)file;
+    record->nanos = traceNanos() - writer->startNanos;
+    __atomic_store_n(&writer->sequences[pos % TRACE_RING_RECORDS], pos + 1, __ATOMIC_RELEASE);
+
+    // only the record that fills half the ring wakes the writer up early
+    if (used == TRACE_RING_RECORDS / 2)
+    {
+        wakeWriter(writer);
+    }
+}
+
+int traceWriterDestroy(BM_TraceWriter *writer)
+{
+    pthread_mutex_lock(&writer->latch);
+    writer->stop = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->latch);
+    pthread_join(writer->thread, NULL);
+
+    bool failed = fclose(writer->file) != 0 || writer->failed;
+    pthread_mutex_destroy(&writer->latch);
+    pthread_cond_destroy(&writer->wake);
+    free(writer->ring);
+    free(writer->sequences);
+    free(writer);
+    return failed ? -1 : 0;
+}
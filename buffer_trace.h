@@ -0,0 +1,49 @@
+#ifndef BUFFER_TRACE_H
+#define BUFFER_TRACE_H
+
+#include <stdint.h>
+
+// Include the buffer pool types
+#include "buffer_mgr.h"
+
+/*
+    # A trace file, written by pools created with the traceFile option, is a BM_TraceHeader followed
+      by one BM_TraceRecord per pin, unpin and dirty mark, in the order the threads appended them.
+    # The fields are stored in the byte order of the machine that recorded the trace.
+*/
+#define BM_TRACE_MAGIC "BMTRACE1"
+
+// operations of trace records
+#define BM_TRACE_PIN 0	 // pinPage, pinPageReadOnly or a page of pinPages
+#define BM_TRACE_UNPIN 1 // unpinPage or a page of unpinPages
+#define BM_TRACE_DIRTY 2 // markDirty
+
+typedef struct BM_TraceHeader
+{
+	char magic[8];		 // BM_TRACE_MAGIC without its terminating zero
+	uint32_t recordSize; // sizeof(BM_TraceRecord)
+	uint32_t numFrames;	 // frames of the pool that recorded the trace
+} BM_TraceHeader;
+
+typedef struct BM_TraceRecord
+{
+	int32_t pageNum;
+	uint16_t thread; // small number of the thread, counted from 0 in the order threads first traced
+	uint8_t op;		 // one of BM_TRACE_PIN, BM_TRACE_UNPIN or BM_TRACE_DIRTY
+	uint8_t file;	 // fileId of the page in its pool, modulo 256, see openPoolFile
+	uint64_t nanos; // time since the trace was started
+} BM_TraceRecord;
+
+// Appends the records of a pool to its trace file through a ring buffer drained by a writer thread
+typedef struct BM_TraceWriter BM_TraceWriter;
+
+// Creates the trace file and starts its writer thread, returns NULL if either fails
+BM_TraceWriter *traceWriterCreate(const char *fileName, int numFrames);
+
+// Adds a record, waits for the writer thread while the ring buffer is full
+void traceWriterAppend(BM_TraceWriter *writer, int file, PageNumber pageNum, int op);
+
+// Writes the remaining records, closes the file and frees the writer, returns 0 if every record was written
+int traceWriterDestroy(BM_TraceWriter *writer);
+
+#endif
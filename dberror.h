@@ -4,6 +4,7 @@
 #include "stdio.h"
 
 /* module wide constants */
+// default page size of new page files, see createPageFileWithPageSize
 #define PAGE_SIZE 4096
 
 /* return code definitions */
@@ -14,6 +15,11 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_MEMORY_ALLOCATION_FAIL 5
+#define RC_INVALID_INPUT 6
+#define RC_INVALID_PAGE_FILE 7
+
+#define RC_BM_NO_FREE_FRAME 100
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
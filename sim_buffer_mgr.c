@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "buffer_mgr.h"
+#include "buffer_policy.h"
+#include "buffer_trace.h"
+#include "dberror.h"
+
+/*
+    # sim_buffer_mgr replays a trace file recorded with the traceFile option against the replacement
+      strategies at many pool sizes and prints the miss ratio curve of each strategy as CSV.
+    # Every pool is simulated by the policy the buffer manager uses, driven with the same hooks in
+      the same order, over a page table without frames, so the page file is never touched. The trace
+      is read once and every record is fed to all simulated pools.
+    # Unpins are ignored, the simulated pools never run out of unpinned frames. A dirty mark makes the
+      page a write back when it is replaced.
+    # With -R only the pages whose hash falls below the rate are replayed, against pools scaled down
+      by the same rate (SHARDS fixed rate sampling), which estimates the curve of a long trace at a
+      fraction of the work. Small rates need traces over many pages to stay close to the full replay.
+*/
+
+// records read from the trace at once
+#define SIM_CHUNK_RECORDS 4096
+// fraction of the hash space of pages kept by -R, see sampled()
+#define SIM_HASH_SPACE (1u << 24)
+// pool sizes of the default curve, as multiples of the frames of the recording pool
+static const double defaultScales[] = {0.125, 0.25, 0.5, 1, 2, 4, 8};
+#define NUM_DEFAULT_SCALES 7
+
+static const char *strategyNames[] = {"fifo", "lru", "clock", "lfu", "lru-k", "arc", "2q"};
+#define NUM_STRATEGIES 7
+
+// one simulated pool
+typedef struct SimPool
+{
+    ReplacementStrategy strategy;
+    const BM_ReplacementPolicy *policy;
+    void *state;
+    int frames;             // frames of the pool the row is reported for
+    int simFrames;          // frames actually simulated, frames scaled by the sampling rate
+    int usedFrames;         // frames are filled in order like takeFreeFrame does
+    PageNumber *pageNums;   // page held by each frame
+    bool *dirty;
+    int *fixCounts;         // always 0, handed to pickVictim
+    int *buckets;           // chained hash table from page to frame
+    int *hashNext;
+    int numBuckets;
+    long long pins;
+    long long misses;
+    long long writeBacks;
+} SimPool;
+
+static unsigned hashPage(PageNumber pageNum)
+{
+    uint64_t x = (uint64_t)(uint32_t)pageNum;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return (unsigned)x;
+}
+
+// whether the page is replayed with the given share of the hash space
+static bool sampled(PageNumber pageNum, unsigned threshold)
+{
+    return threshold >= SIM_HASH_SPACE || (hashPage(pageNum) >> 8) < threshold;
+}
+
+static int lookupFrame(const SimPool *pool, PageNumber pageNum)
+{
+    int frame = pool->buckets[hashPage(pageNum) % pool->numBuckets];
+    while (frame != NO_FRAME && pool->pageNums[frame] != pageNum)
+    {
+        frame = pool->hashNext[frame];
+    }
+    return frame;
+}
+
+static void removeFrame(SimPool *pool, int frame)
+{
+    int *link = &pool->buckets[hashPage(pool->pageNums[frame]) % pool->numBuckets];
+    while (*link != frame)
+    {
+        link = &pool->hashNext[*link];
+    }
+    *link = pool->hashNext[frame];
+}
+
+static void insertFrame(SimPool *pool, int frame)
+{
+    int *bucket = &pool->buckets[hashPage(pool->pageNums[frame]) % pool->numBuckets];
+    pool->hashNext[frame] = *bucket;
+    *bucket = frame;
+}
+
+static RC initSimPool(SimPool *pool, ReplacementStrategy strategy, int frames, int simFrames)
+{
+    memset(pool, 0, sizeof(SimPool));
+    pool->strategy = strategy;
+    pool->policy = getReplacementPolicy(strategy);
+    pool->frames = frames;
+    pool->simFrames = simFrames;
+    pool->numBuckets = simFrames;
+    pool->pageNums = (PageNumber *)malloc(sizeof(PageNumber) * simFrames);
+    pool->dirty = (bool *)calloc(simFrames, sizeof(bool));
+    pool->fixCounts = (int *)calloc(simFrames, sizeof(int));
+    pool->buckets = (int *)malloc(sizeof(int) * simFrames);
+    pool->hashNext = (int *)malloc(sizeof(int) * simFrames);
+    if (pool->policy == NULL || pool->pageNums == NULL || pool->dirty == NULL || pool->fixCounts == NULL ||
+        pool->buckets == NULL || pool->hashNext == NULL)
+    {
+        return RC_INVALID_INPUT;
+    }
+    for (int i = 0; i < simFrames; i++)
+    {
+        pool->pageNums[i] = NO_PAGE;
+        pool->buckets[i] = NO_FRAME;
+    }
+    return pool->policy->init(&pool->state, simFrames, NULL);
+}
+
+static void freeSimPool(SimPool *pool)
+{
+    if (pool->state != NULL && pool->policy->shutdown != NULL)
+    {
+        pool->policy->shutdown(pool->state);
+    }
+    free(pool->pageNums);
+    free(pool->dirty);
+    free(pool->fixCounts);
+    free(pool->buckets);
+    free(pool->hashNext);
+}
+
+// a pin of pageNum, in the order of hooks of pinResidentFrame and assignFrame
+static void simPin(SimPool *pool, PageNumber pageNum)
+{
+    pool->pins++;
+
+    int frame = lookupFrame(pool, pageNum);
+    if (frame != NO_FRAME)
+    {
+        if (pool->policy->onHit != NULL)
+        {
+            pool->policy->onHit(pool->state, frame);
+        }
+        return;
+    }
+
+    pool->misses++;
+    if (pool->usedFrames < pool->simFrames)
+    {
+        frame = pool->usedFrames++;
+    }
+    else
+    {
+        frame = pool->policy->pickVictim(pool->state, pool->fixCounts, pageNum);
+        if (frame == NO_FRAME)
+        {
+            return;
+        }
+        if (pool->dirty[frame])
+        {
+            pool->writeBacks++;
+        }
+        if (pool->policy->onEvict != NULL)
+        {
+            pool->policy->onEvict(pool->state, frame, pool->pageNums[frame]);
+        }
+        removeFrame(pool, frame);
+    }
+
+    pool->pageNums[frame] = pageNum;
+    pool->dirty[frame] = false;
+    insertFrame(pool, frame);
+    if (pool->policy->onInsert != NULL)
+    {
+        pool->policy->onInsert(pool->state, frame, pageNum);
+    }
+}
+
+static void simDirty(SimPool *pool, PageNumber pageNum)
+{
+    int frame = lookupFrame(pool, pageNum);
+    if (frame != NO_FRAME)
+    {
+        pool->dirty[frame] = true;
+    }
+}
+
+static int lookupName(const char *name, const char **names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// reads a comma separated list of strategies, or all
+static bool parseStrategies(const char *list, bool selected[NUM_STRATEGIES])
+{
+    char buffer[256];
+    strncpy(buffer, list, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char *name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ","))
+    {
+        int index = lookupName(name, strategyNames, NUM_STRATEGIES);
+        if (strcmp(name, "all") == 0)
+        {
+            for (int i = 0; i < NUM_STRATEGIES; i++)
+                selected[i] = true;
+        }
+        else if (index < 0)
+            return false;
+        else
+            selected[index] = true;
+    }
+    return true;
+}
+
+// reads a comma separated list of pool sizes, returns how many or -1
+static int parseSizes(const char *list, int **sizes)
+{
+    int count = 1;
+    for (const char *c = list; *c != '\0'; c++)
+    {
+        if (*c == ',')
+            count++;
+    }
+
+    *sizes = (int *)malloc(sizeof(int) * count);
+    const char *next = list;
+    for (int i = 0; i < count; i++)
+    {
+        char *end;
+        long size = strtol(next, &end, 10);
+        if (size <= 0 || (*end != ',' && *end != '\0'))
+        {
+            return -1;
+        }
+        (*sizes)[i] = (int)size;
+        next = end + 1;
+    }
+    return count;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: sim_buffer_mgr [options] trace\n"
+            "  -s strategies comma separated fifo, lru, clock, lfu, lru-k, arc, 2q or all (all)\n"
+            "  -f frames     comma separated pool sizes (1/8 up to 8 times the frames of the trace)\n"
+            "  -R rate       replay only this fraction of the pages, between 0 and 1 (1)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool strategies[NUM_STRATEGIES] = {false};
+    bool anyStrategy = false;
+    int *sizes = NULL;
+    int numSizes = 0;
+    double rate = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:f:R:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            if (!parseStrategies(optarg, strategies))
+            {
+                usage();
+                return 1;
+            }
+            anyStrategy = true;
+            break;
+        case 'f':
+            free(sizes);
+            if ((numSizes = parseSizes(optarg, &sizes)) < 0)
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'R':
+            rate = atof(optarg);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || rate <= 0 || rate > 1)
+    {
+        usage();
+        return 1;
+    }
+
+    const char *traceFile = argv[optind];
+    FILE *file = fopen(traceFile, "rb");
+    BM_TraceHeader header;
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, BM_TRACE_MAGIC, sizeof(header.magic)) != 0 || header.recordSize != sizeof(BM_TraceRecord))
+    {
+        fprintf(stderr, "%s is not a trace file\n", traceFile);
+        return 1;
+    }
+
+    if (!anyStrategy)
+    {
+        for (int i = 0; i < NUM_STRATEGIES; i++)
+            strategies[i] = true;
+    }
+    if (sizes == NULL)
+    {
+        sizes = (int *)malloc(sizeof(int) * NUM_DEFAULT_SCALES);
+        for (int i = 0; i < NUM_DEFAULT_SCALES; i++)
+        {
+            int size = (int)(defaultScales[i] * header.numFrames);
+            if (size > 0 && (numSizes == 0 || size != sizes[numSizes - 1]))
+                sizes[numSizes++] = size;
+        }
+    }
+
+    // one simulated pool per strategy and size, all fed from the same pass over the trace
+    int numPools = 0;
+    SimPool *pools = (SimPool *)calloc(NUM_STRATEGIES * numSizes, sizeof(SimPool));
+    for (int s = 0; s < NUM_STRATEGIES; s++)
+    {
+        for (int i = 0; i < numSizes && strategies[s]; i++)
+        {
+            int simFrames = (int)(sizes[i] * rate + 0.5);
+            if (initSimPool(&pools[numPools++], (ReplacementStrategy)s, sizes[i], simFrames > 0 ? simFrames : 1) != RC_OK)
+            {
+                fprintf(stderr, "cannot simulate %s with %d frames\n", strategyNames[s], sizes[i]);
+                return 1;
+            }
+        }
+    }
+
+    unsigned threshold = rate >= 1 ? SIM_HASH_SPACE : (unsigned)(rate * SIM_HASH_SPACE);
+    long long tracePins = 0;
+    BM_TraceRecord *records = (BM_TraceRecord *)malloc(sizeof(BM_TraceRecord) * SIM_CHUNK_RECORDS);
+    size_t count;
+
+    while ((count = fread(records, sizeof(BM_TraceRecord), SIM_CHUNK_RECORDS, file)) > 0)
+    {
+        for (size_t r = 0; r < count; r++)
+        {
+            if (records[r].op == BM_TRACE_PIN)
+                tracePins++;
+            // the pages of the files of a pool shared by several files are told apart as by the pool
+            PageNumber pageNum = pageKeyOf(records[r].file, records[r].pageNum);
+            if (records[r].op == BM_TRACE_UNPIN || !sampled(pageNum, threshold))
+                continue;
+
+            for (int p = 0; p < numPools; p++)
+            {
+                if (records[r].op == BM_TRACE_PIN)
+                    simPin(&pools[p], pageNum);
+                else
+                    simDirty(&pools[p], pageNum);
+            }
+        }
+    }
+    fclose(file);
+
+    // sampled counts are scaled back up to the whole trace. The miss ratio is taken over the pins a
+    // sample of exactly the rate would have, the pins by which the sample is off are mostly to hot
+    // pages, so they are counted as hits (SHARDS_adj)
+    printf("strategy,frames,pins,misses,miss_ratio,writebacks\n");
+    for (int p = 0; p < numPools; p++)
+    {
+        SimPool *pool = &pools[p];
+        double missRatio = tracePins > 0 ? pool->misses / (rate * tracePins) : 0;
+        printf("%s,%d,%lld,%lld,%.6f,%lld\n", strategyNames[pool->strategy], pool->frames, tracePins,
+               (long long)(missRatio * tracePins + 0.5), missRatio, (long long)(pool->writeBacks / rate + 0.5));
+        freeSimPool(pool);
+    }
+
+    free(pools);
+    free(records);
+    free(sizes);
+    return 0;
+}
@@ -0,0 +1,460 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "storage_io.h"
+
+/*
+    # The I/O engine used by the direct storage backends of the storage manager.
+    # A batch of tasks is either submitted to an io_uring, set up with the raw system calls, or
+      spread over a small pool of I/O threads doing preadv and pwritev, so that all tasks of the
+      batch are in flight at the same time.
+    # Batches on one engine run one after another, a batch of a single task is transferred by the
+      calling thread right away, so independent threads still do their I/O in parallel.
+    # A ring that fails is torn down once the entries the kernel took have completed, the later
+      batches of the engine are then transferred by the calling thread.
+*/
+
+// number of submission queue entries of the ring, larger batches are submitted in parts
+#define IO_RING_ENTRIES 64
+// number of I/O threads of the fallback without io_uring
+#define IO_THREADS 4
+
+struct SM_IOEngine
+{
+    int fd;                     // file the tasks are done on
+    pthread_mutex_t runLatch;   // one batch at a time
+
+    // io_uring, ringFd is -1 when the thread pool is used instead
+    int ringFd;
+    void *sqRing;
+    void *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned sqEntries;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+
+    // thread pool, the state of the current batch is protected by poolLatch
+    int numThreads;
+    pthread_t threads[IO_THREADS];
+    pthread_mutex_t poolLatch;
+    pthread_cond_t workReady;   // a batch was posted or the threads have to stop
+    pthread_cond_t workDone;    // the last task of the batch finished
+    SM_IOTask *tasks;
+    int numTasks;
+    int nextTask;               // next task nobody has taken yet
+    int pendingTasks;           // tasks of the batch that did not finish yet
+    int stop;
+};
+
+// moves the start of the task bytes further, after a call transferred only part of it
+static void advanceTask(SM_IOTask *task, size_t bytes)
+{
+    task->offset += bytes;
+    while (task->iovcnt > 0 && bytes >= task->iov->iov_len)
+    {
+        bytes -= task->iov->iov_len;
+        task->iov++;
+        task->iovcnt--;
+    }
+    if (task->iovcnt > 0)
+    {
+        task->iov->iov_base = (char *)task->iov->iov_base + bytes;
+        task->iov->iov_len -= bytes;
+    }
+}
+
+int ioTransfer(int fd, SM_IOTask *task)
+{
+    while (task->iovcnt > 0)
+    {
+        ssize_t moved = task->write ? pwritev(fd, task->iov, task->iovcnt, task->offset)
+                                    : preadv(fd, task->iov, task->iovcnt, task->offset);
+        if (moved < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        // a read that reaches the end of the file fails as well
+        if (moved <= 0)
+        {
+            task->failed = 1;
+            return -1;
+        }
+        advanceTask(task, moved);
+    }
+    return 0;
+}
+
+// ------------- io_uring -------------
+
+static void ringTeardown(SM_IOEngine *engine)
+{
+    if (engine->sqes != NULL)
+    {
+        munmap(engine->sqes, engine->sqEntries * sizeof(struct io_uring_sqe));
+    }
+    if (engine->cqRing != NULL && engine->cqRing != engine->sqRing)
+    {
+        munmap(engine->cqRing, engine->cqRingSize);
+    }
+    if (engine->sqRing != NULL)
+    {
+        munmap(engine->sqRing, engine->sqRingSize);
+    }
+    if (engine->ringFd >= 0)
+    {
+        close(engine->ringFd);
+    }
+    // a ring torn down after a failure is torn down again by ioEngineDestroy
+    engine->sqes = NULL;
+    engine->cqRing = NULL;
+    engine->sqRing = NULL;
+    engine->ringFd = -1;
+}
+
+// sets up the ring and maps its queues, returns -1 if the kernel does not allow io_uring
+static int ringSetup(SM_IOEngine *engine)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    engine->ringFd = (int)syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &params);
+    if (engine->ringFd < 0)
+    {
+        engine->ringFd = -1;
+        return -1;
+    }
+
+    engine->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    engine->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap && engine->cqRingSize > engine->sqRingSize)
+    {
+        engine->sqRingSize = engine->cqRingSize;
+    }
+
+    void *sqRing = mmap(NULL, engine->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        engine->ringFd, IORING_OFF_SQ_RING);
+    engine->sqRing = sqRing == MAP_FAILED ? NULL : sqRing;
+    if (engine->sqRing == NULL)
+    {
+        ringTeardown(engine);
+        return -1;
+    }
+
+    void *cqRing = engine->sqRing;
+    if (!singleMap)
+    {
+        cqRing = mmap(NULL, engine->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      engine->ringFd, IORING_OFF_CQ_RING);
+    }
+    engine->cqRing = cqRing == MAP_FAILED ? NULL : cqRing;
+
+    engine->sqEntries = params.sq_entries;
+    void *sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, engine->ringFd, IORING_OFF_SQES);
+    engine->sqes = sqes == MAP_FAILED ? NULL : (struct io_uring_sqe *)sqes;
+    if (engine->cqRing == NULL || engine->sqes == NULL)
+    {
+        ringTeardown(engine);
+        return -1;
+    }
+
+    char *sq = (char *)engine->sqRing;
+    char *cq = (char *)engine->cqRing;
+    engine->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    engine->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    engine->sqArray = (unsigned *)(sq + params.sq_off.array);
+    engine->cqHead = (unsigned *)(cq + params.cq_off.head);
+    engine->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    engine->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    engine->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+// finishes a task from its completion, a short or interrupted transfer is completed synchronously
+static void ringComplete(SM_IOEngine *engine, SM_IOTask *task, int result)
+{
+    size_t expected = 0;
+    for (int i = 0; i < task->iovcnt; i++)
+    {
+        expected += task->iov[i].iov_len;
+    }
+
+    if (result >= 0 && (size_t)result == expected)
+    {
+        task->iovcnt = 0;
+        return;
+    }
+    if (result >= 0 || result == -EINTR || result == -EAGAIN)
+    {
+        advanceTask(task, result > 0 ? (size_t)result : 0);
+        ioTransfer(engine->fd, task);
+        return;
+    }
+    task->failed = 1;
+}
+
+// finishes the tasks of the completions in the queue, returns how many there were
+static int ringReap(SM_IOEngine *engine, SM_IOTask *tasks)
+{
+    int reaped = 0;
+    unsigned head = *engine->cqHead;
+    unsigned cqTail = __atomic_load_n(engine->cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != cqTail; head++)
+    {
+        struct io_uring_cqe *cqe = &engine->cqes[head & *engine->cqMask];
+        ringComplete(engine, &tasks[cqe->user_data], cqe->res);
+        reaped++;
+    }
+    __atomic_store_n(engine->cqHead, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+/*
+    # Waits for the completions of the entries the kernel took before the ring failed, as it may
+      still use the buffers of their tasks, which the caller reuses once the batch returns.
+    # Gives up if the ring cannot even wait any more.
+*/
+static void ringDrain(SM_IOEngine *engine, SM_IOTask *tasks, int inFlight)
+{
+    while ((inFlight -= ringReap(engine, tasks)) > 0)
+    {
+        if (syscall(__NR_io_uring_enter, engine->ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR)
+        {
+            return;
+        }
+    }
+}
+
+// submits the tasks to the ring, as many at once as it has entries, and waits for all of them
+static int ringRun(SM_IOEngine *engine, SM_IOTask *tasks, int count)
+{
+    for (int first = 0; first < count;)
+    {
+        int batch = count - first < (int)engine->sqEntries ? count - first : (int)engine->sqEntries;
+        unsigned tail = *engine->sqTail;
+
+        for (int i = 0; i < batch; i++)
+        {
+            unsigned index = (tail + i) & *engine->sqMask;
+            struct io_uring_sqe *sqe = &engine->sqes[index];
+            SM_IOTask *task = &tasks[first + i];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = task->write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = engine->fd;
+            sqe->off = task->offset;
+            sqe->addr = (unsigned long)task->iov;
+            sqe->len = task->iovcnt;
+            sqe->user_data = first + i;
+            engine->sqArray[index] = index;
+        }
+        // the kernel reads the entries once it sees the new tail
+        __atomic_store_n(engine->sqTail, tail + batch, __ATOMIC_RELEASE);
+
+        int submitted = 0;
+        int completed = 0;
+        while (completed < batch)
+        {
+            int ret = (int)syscall(__NR_io_uring_enter, engine->ringFd, batch - submitted, 1,
+                                   IORING_ENTER_GETEVENTS, NULL, 0);
+            if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                // the ring is unusable, it is torn down once the submitted tasks are done so that no
+                // stale completion or entry is left for the next batch, the other tasks are lost
+                ringDrain(engine, tasks, submitted - completed);
+                ringTeardown(engine);
+                for (int i = first; i < count; i++)
+                {
+                    if (tasks[i].iovcnt > 0)
+                    {
+                        tasks[i].failed = 1;
+                    }
+                }
+                return -1;
+            }
+            if (ret > 0)
+            {
+                submitted += ret;
+            }
+
+            completed += ringReap(engine, tasks);
+        }
+        first += batch;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (tasks[i].failed)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ------------- thread pool -------------
+
+// takes the next task of the current batch and transfers it, the caller holds poolLatch
+static void poolTransferNext(SM_IOEngine *engine)
+{
+    SM_IOTask *task = &engine->tasks[engine->nextTask++];
+
+    pthread_mutex_unlock(&engine->poolLatch);
+    ioTransfer(engine->fd, task);
+    pthread_mutex_lock(&engine->poolLatch);
+
+    if (--engine->pendingTasks == 0)
+    {
+        pthread_cond_broadcast(&engine->workDone);
+    }
+}
+
+// body of the I/O threads
+static void *ioWorker(void *arg)
+{
+    SM_IOEngine *engine = (SM_IOEngine *)arg;
+
+    pthread_mutex_lock(&engine->poolLatch);
+    for (;;)
+    {
+        while (!engine->stop && engine->nextTask >= engine->numTasks)
+        {
+            pthread_cond_wait(&engine->workReady, &engine->poolLatch);
+        }
+        if (engine->stop)
+        {
+            break;
+        }
+        poolTransferNext(engine);
+    }
+    pthread_mutex_unlock(&engine->poolLatch);
+    return NULL;
+}
+
+// posts the tasks to the I/O threads, works on them as well and waits until all are done
+static int poolRun(SM_IOEngine *engine, SM_IOTask *tasks, int count)
+{
+    pthread_mutex_lock(&engine->poolLatch);
+    engine->tasks = tasks;
+    engine->numTasks = count;
+    engine->nextTask = 0;
+    engine->pendingTasks = count;
+    pthread_cond_broadcast(&engine->workReady);
+
+    while (engine->nextTask < engine->numTasks)
+    {
+        poolTransferNext(engine);
+    }
+    while (engine->pendingTasks > 0)
+    {
+        pthread_cond_wait(&engine->workDone, &engine->poolLatch);
+    }
+    engine->tasks = NULL;
+    engine->numTasks = 0;
+    engine->nextTask = 0;
+    pthread_mutex_unlock(&engine->poolLatch);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (tasks[i].failed)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ------------- engine interface -------------
+
+SM_IOEngine *ioEngineCreate(int fd, int useRing)
+{
+    SM_IOEngine *engine = (SM_IOEngine *)calloc(1, sizeof(SM_IOEngine));
+    if (engine == NULL)
+    {
+        return NULL;
+    }
+
+    engine->fd = fd;
+    engine->ringFd = -1;
+    pthread_mutex_init(&engine->runLatch, NULL);
+    pthread_mutex_init(&engine->poolLatch, NULL);
+    pthread_cond_init(&engine->workReady, NULL);
+    pthread_cond_init(&engine->workDone, NULL);
+
+    if (useRing && ringSetup(engine) == 0)
+    {
+        return engine;
+    }
+
+    // without io_uring the batches are spread over the I/O threads, if none can be started
+    // the caller does all transfers itself
+    while (engine->numThreads < IO_THREADS &&
+           pthread_create(&engine->threads[engine->numThreads], NULL, ioWorker, engine) == 0)
+    {
+        engine->numThreads++;
+    }
+    return engine;
+}
+
+void ioEngineDestroy(SM_IOEngine *engine)
+{
+    if (engine == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&engine->poolLatch);
+    engine->stop = 1;
+    pthread_cond_broadcast(&engine->workReady);
+    pthread_mutex_unlock(&engine->poolLatch);
+    for (int i = 0; i < engine->numThreads; i++)
+    {
+        pthread_join(engine->threads[i], NULL);
+    }
+
+    ringTeardown(engine);
+    pthread_mutex_destroy(&engine->runLatch);
+    pthread_mutex_destroy(&engine->poolLatch);
+    pthread_cond_destroy(&engine->workReady);
+    pthread_cond_destroy(&engine->workDone);
+    free(engine);
+}
+
+int ioEngineRun(SM_IOEngine *engine, SM_IOTask *tasks, int count)
+{
+    if (count <= 0)
+    {
+        return 0;
+    }
+    // a single task gains nothing from the ring or the threads
+    if (count == 1)
+    {
+        return ioTransfer(engine->fd, tasks);
+    }
+
+    pthread_mutex_lock(&engine->runLatch);
+    int result = engine->ringFd >= 0 ? ringRun(engine, tasks, count) : poolRun(engine, tasks, count);
+    pthread_mutex_unlock(&engine->runLatch);
+    return result;
+}
+
+int ioEngineUsesRing(SM_IOEngine *engine)
+{
+    return engine->ringFd >= 0;
+}
@@ -0,0 +1,33 @@
+#ifndef STORAGE_IO_H
+#define STORAGE_IO_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// One vectored read or write of consecutive bytes of a file
+typedef struct SM_IOTask
+{
+    int write;          // 1 to write the buffers to the file, 0 to read them
+    off_t offset;       // file offset of the first byte
+    struct iovec *iov;  // buffers, updated while a transfer is split into several calls
+    int iovcnt;
+    int failed;         // set when the transfer could not be completed
+} SM_IOTask;
+
+// Runs batches of tasks on one file descriptor with io_uring or a pool of I/O threads
+typedef struct SM_IOEngine SM_IOEngine;
+
+// Transfers all bytes of the task with preadv or pwritev, returns 0 on success and -1 on failure
+int ioTransfer(int fd, SM_IOTask *task);
+
+// Creates an engine for fd, using io_uring if useRing is set and the kernel supports it
+SM_IOEngine *ioEngineCreate(int fd, int useRing);
+void ioEngineDestroy(SM_IOEngine *engine);
+
+// Performs the tasks with all of them in flight at once, returns 0 if every task succeeded
+int ioEngineRun(SM_IOEngine *engine, SM_IOTask *tasks, int count);
+
+// Whether the engine submits through io_uring rather than its I/O threads
+int ioEngineUsesRing(SM_IOEngine *engine);
+
+#endif
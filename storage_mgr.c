@@ -1,93 +1,416 @@
+// O_DIRECT
+#define _GNU_SOURCE
+
 #include "storage_mgr.h"
+#include "storage_io.h"
 #include "dberror.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
 
-void initStorageManager(void)
+// number of pages passed to one preadv or pwritev call by readBlocks and writeBlocks
+#define BLOCKS_PER_IOV 64
+
+// size of the pieces in which SM_BACKEND_MMAP maps a page file, a multiple of every page size
+#define MMAP_CHUNK_SIZE (64 * 1024 * 1024)
+
+// most pages the direct backends hand to the I/O engine at once
+#define DIRECT_BATCH_PAGES 256
+
+// largest amount of disk space reserved ahead of the page count when a file grows
+#define MAX_RESERVE_BYTES (4 * 1024 * 1024)
+
+// alignment of the buffers and file offsets O_DIRECT needs, files with smaller pages are opened buffered
+#define DIRECT_ALIGNMENT 4096
+
+// first bytes of every page file, "PGF1" when read in little endian byte order
+#define SM_FILE_MAGIC 0x31464750u
+// version of the header layout, files with another version are rejected
+#define SM_FILE_VERSION 1
+
+/*
+    # The header page of a page file, the first pageSize bytes, starts with this fixed-width binary
+      header, in the byte order of the machine. The rest of the header page is zero.
+    # Page i of the file is stored at offset (i + 1) * pageSize.
+*/
+typedef struct SM_FileHeader
+{
+    uint32_t magic;        // SM_FILE_MAGIC
+    uint32_t version;      // SM_FILE_VERSION
+    int32_t totalNumPages; // number of pages after the header page
+    uint32_t pageSize;     // size of the pages, and of the header page, in bytes
+} SM_FileHeader;
+
+/*
+    # mgmtInfo of an open file handle, the page file is accessed through one of the backends:
+    # SM_BACKEND_STDIO reads and writes with pread and pwrite, or their vectored forms, on the file
+      descriptor. There is no shared file position, so the calls do not depend on each other.
+    # SM_BACKEND_MMAP copies pages from and to a shared mapping of the file, pages are added by
+      growing the file with ftruncate. The file is mapped in chunks of MMAP_CHUNK_SIZE bytes when
+      they are first used, which stay in place until the file is closed, so the addresses handed
+      out by mapBlock remain valid while the file grows.
+    # SM_BACKEND_DIRECT and SM_BACKEND_DIRECT_THREADS read and write the pages on a second file
+      descriptor opened with O_DIRECT, bypassing the kernel page cache, through the I/O engine of
+      storage_io.c, which runs batches of requests with io_uring or its I/O threads. Pages are added
+      with ftruncate as for the other backends.
+    # With the direct backends reads and writes of existing pages may run in parallel with each
+      other, only adding pages has to be serialised with all other calls on the file.
+    # The header is always read and updated with pread and pwrite on the file descriptor.
+*/
+typedef struct SM_FileMgmt
 {
+    int fd;             // descriptor of the page file, used by all backends for the header
+    SM_Backend backend;
+    char **chunks;      // mapped chunks of the file, NULL until first used
+    int numChunks;      // number of entries in chunks
+    int directFd;       // descriptor of the direct backends, -1 for the others
+    int directIO;       // directFd uses O_DIRECT, which needs aligned buffers
+    SM_IOEngine *engine; // I/O engine of the direct backends
+    int reservedPages;  // pages the disk space has been reserved for, see reserveBlocks
+    int pageSize;       // page size from the header
+} SM_FileMgmt;
+
+// returns the management information of an open file handle
+static SM_FileMgmt *mgmtOf(SM_FileHandle *fHandle)
+{
+    return (SM_FileMgmt *)(*fHandle).mgmtInfo;
+}
+
+// the page count and position are read and set atomically, as the direct backends allow reads and
+// writes in parallel with each other and with a thread adding pages
+static int pageCountOf(SM_FileHandle *fHandle)
+{
+    return __atomic_load_n(&(*fHandle).totalNumPages, __ATOMIC_ACQUIRE);
+}
+
+static void setBlockPos(SM_FileHandle *fHandle, int pageNum)
+{
+    __atomic_store_n(&(*fHandle).curPagePos, pageNum, __ATOMIC_RELAXED);
+}
+
+static int isDirect(SM_Backend backend)
+{
+    return backend == SM_BACKEND_DIRECT || backend == SM_BACKEND_DIRECT_THREADS;
+}
+
+// page sizes are powers of two, so pages never straddle the chunks of the mmap backend
+static int isValidPageSize(int pageSize)
+{
+    return pageSize >= SM_MIN_PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
 }
 
 /*
-    # It creates a new page file with "fileName"
-    # Uses fopen() function and writes data
-    # Returns RC_FILE_NOT_FOUND if unsuccessfull
+    # Returns the address of the byte at offset inside the mapping of the file, mapping its chunk
+      on first use, or NULL if the chunk cannot be mapped.
+    # The chunk may reach past the end of the file, only the part inside the file may be touched.
 */
-RC createPageFile(char *fileName)
+static char *mappedAddress(SM_FileMgmt *mgmt, off_t offset)
 {
-    // Open the file in write mode
-    FILE *filePtr = fopen(fileName, "w");
+    int chunk = (int)(offset / MMAP_CHUNK_SIZE);
 
-    // Check if the file was opened successfully
+    if (chunk >= mgmt->numChunks)
+    {
+        int numChunks = mgmt->numChunks > 0 ? mgmt->numChunks : 1;
+        while (numChunks <= chunk)
+            numChunks *= 2;
+
+        char **chunks = (char **)realloc(mgmt->chunks, sizeof(char *) * numChunks);
+        if (chunks == NULL)
+            return NULL;
+        memset(chunks + mgmt->numChunks, 0, sizeof(char *) * (numChunks - mgmt->numChunks));
+        mgmt->chunks = chunks;
+        mgmt->numChunks = numChunks;
+    }
 
-    if (filePtr != NULL)
+    if (mgmt->chunks[chunk] == NULL)
     {
-        // Allocate a blank page to store data
-        char *blankPage = (char *)calloc(PAGE_SIZE, sizeof(char));
+        void *mapping = mmap(NULL, MMAP_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                             mgmt->fd, (off_t)chunk * MMAP_CHUNK_SIZE);
+        if (mapping == MAP_FAILED)
+            return NULL;
+        mgmt->chunks[chunk] = (char *)mapping;
+    }
 
-        // Allocate headerPage to store file info like total number of pages
-        char *headerPage = (char *)calloc(PAGE_SIZE, sizeof(char));
+    return mgmt->chunks[chunk] + offset % MMAP_CHUNK_SIZE;
+}
 
-        // set initial page number to 1 and point the filePtr to headerPage
-        fputs("1", filePtr);
+// returns the address of a block inside the mapping of the file, or NULL if it cannot be mapped
+static char *mappedBlock(SM_FileMgmt *mgmt, int pageNum)
+{
+    return mappedAddress(mgmt, (off_t)(pageNum + 1) * mgmt->pageSize);
+}
 
-        // Write the headerPage with total number of pages
-        fwrite(headerPage, PAGE_SIZE, 1, filePtr);
+/*
+    # Performs the requests of a direct backend through the I/O engine, up to DIRECT_BATCH_PAGES
+      pages at a time are in flight, each request split into tasks of at most BLOCKS_PER_IOV pages.
+    # O_DIRECT needs buffers aligned to DIRECT_ALIGNMENT, pages in other buffers go through an aligned copy.
+    # Sets the status of every request and returns 0 if all of them succeeded.
+*/
+static int directSubmit(SM_FileMgmt *mgmt, SM_IORequest *requests, int numRequests)
+{
+    struct iovec iov[DIRECT_BATCH_PAGES];
+    SM_IOTask tasks[DIRECT_BATCH_PAGES];
+    int owners[DIRECT_BATCH_PAGES];       // request of each task
+    char *bounce[DIRECT_BATCH_PAGES];     // aligned copy of each page, NULL if the page is aligned
+    SM_PageHandle pages[DIRECT_BATCH_PAGES];
+    int reads[DIRECT_BATCH_PAGES];        // whether the page is read, so its copy has to be copied back
+    int failed = 0;
+    int request = 0, done = 0;            // next page to hand out, done pages into the request
+
+    for (int i = 0; i < numRequests; i++)
+        requests[i].status = RC_OK;
+
+    while (request < numRequests)
+    {
+        int numTasks = 0, numPages = 0;
+
+        // split the next requests into tasks until the batch is full
+        while (request < numRequests && numPages < DIRECT_BATCH_PAGES)
+        {
+            SM_IORequest *req = &requests[request];
+            int count = req->numPages - done;
+            if (count > BLOCKS_PER_IOV)
+                count = BLOCKS_PER_IOV;
+            if (count > DIRECT_BATCH_PAGES - numPages)
+                count = DIRECT_BATCH_PAGES - numPages;
+
+            SM_IOTask *task = &tasks[numTasks];
+            task->write = req->write;
+            task->offset = (off_t)(req->pageNum + done + 1) * mgmt->pageSize;
+            task->iov = &iov[numPages];
+            task->iovcnt = count;
+            task->failed = 0;
+            owners[numTasks++] = request;
+
+            for (int i = 0; i < count; i++, numPages++)
+            {
+                char *buffer = req->memPages[done + i];
+                pages[numPages] = buffer;
+                reads[numPages] = !req->write;
+                bounce[numPages] = NULL;
+                if (mgmt->directIO && (uintptr_t)buffer % DIRECT_ALIGNMENT != 0 &&
+                    posix_memalign((void **)&bounce[numPages], DIRECT_ALIGNMENT, mgmt->pageSize) == 0)
+                {
+                    if (req->write)
+                        memcpy(bounce[numPages], buffer, mgmt->pageSize);
+                    buffer = bounce[numPages];
+                }
+                iov[numPages].iov_base = buffer;
+                iov[numPages].iov_len = mgmt->pageSize;
+            }
+
+            done += count;
+            if (done == req->numPages)
+            {
+                request++;
+                done = 0;
+            }
+        }
+
+        ioEngineRun(mgmt->engine, tasks, numTasks);
+
+        for (int i = 0; i < numTasks; i++)
+        {
+            if (tasks[i].failed)
+            {
+                requests[owners[i]].status = requests[owners[i]].write ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+                failed = 1;
+            }
+        }
+        for (int i = 0; i < numPages; i++)
+        {
+            if (bounce[i] != NULL)
+            {
+                // copy read pages from the aligned copies to the buffers of the caller
+                if (reads[i])
+                    memcpy(pages[i], bounce[i], mgmt->pageSize);
+                free(bounce[i]);
+            }
+        }
+    }
+    return failed ? -1 : 0;
+}
 
-        // Write the blankPage
-        fwrite(blankPage, PAGE_SIZE, 1, filePtr);
+// writes the header of a file with totalNumPages pages of pageSize bytes, returns 0 on success
+static int writeHeader(int fd, int totalNumPages, int pageSize)
+{
+    SM_FileHeader header = {SM_FILE_MAGIC, SM_FILE_VERSION, totalNumPages, pageSize};
 
-        // Free the allocated memory
-        free(headerPage);
-        free(blankPage);
+    return pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) ? 0 : -1;
+}
 
-        // Close the file pointer
-        fclose(filePtr);
+/*
+    # Reserves disk space for at least numPages pages past the header page with fallocate, without
+      changing the size of the file. The reservation grows geometrically, doubling the file up to
+      MAX_RESERVE_BYTES at a time, so a file grown page by page gets few large extents.
+    # File systems without fallocate just grow the file on its size changes.
+*/
+static void reserveBlocks(SM_FileMgmt *mgmt, int numPages)
+{
+    int maxAhead = MAX_RESERVE_BYTES / mgmt->pageSize;
+    int ahead = numPages < maxAhead ? numPages : maxAhead;
+    int reserve = numPages + ahead;
+    off_t offset = (off_t)(mgmt->reservedPages + 1) * mgmt->pageSize;
 
-        return RC_OK;
-    }
-    else
-        return RC_FILE_NOT_FOUND;
+    fallocate(mgmt->fd, FALLOC_FL_KEEP_SIZE, offset, (off_t)(reserve + 1) * mgmt->pageSize - offset);
+    mgmt->reservedPages = reserve;
 }
 
 /*
-    # This method opens an existing page file
-    # Updates and stores the file attributes in mgmtInfo
-    # Returns RC_FILE_NOT_FOUND if the file does not exist
+    # Adds numPages pages at the end of the file with one ftruncate, the new pages read as zero bytes,
+      and updates the page count in the header once.
+    # The handle reports the new pages only once the header has them, a failed header write leaves
+      the page count as it was.
 */
-RC openPageFile(char *fileName, SM_FileHandle *fHandle)
+static RC growPageFile(SM_FileHandle *fHandle, int numPages)
 {
-    FILE *filePtr; // file pointer
+    SM_FileMgmt *mgmt = mgmtOf(fHandle);
+    int totalNumPages = pageCountOf(fHandle) + numPages;
 
-    filePtr = fopen(fileName, "r+"); // open the pageFile
+    if (totalNumPages > mgmt->reservedPages)
+        reserveBlocks(mgmt, totalNumPages);
 
-    if (filePtr != NULL) // if file exists
-    {
-        /*update the fileHandle attributes*/
+    if (ftruncate(mgmt->fd, (off_t)(totalNumPages + 1) * mgmt->pageSize) != 0)
+        return RC_WRITE_FAILED;
+
+    // update the total pages in the header first, the handle only reports pages a reopen finds too
+    if (writeHeader(mgmt->fd, totalNumPages, mgmt->pageSize) != 0)
+        return RC_WRITE_FAILED;
+
+    // update the attributes of fhandle as appending the pages one by one would
+    setBlockPos(fHandle, totalNumPages - 2);
+    __atomic_store_n(&(*fHandle).totalNumPages, totalNumPages, __ATOMIC_RELEASE);
 
-        (*fHandle).fileName = fileName; // store the file name
+    return RC_OK;
+}
 
-        /*read headerPage to get the Total Number of Pages*/
-        char *headerPage;
-        headerPage = (char *)calloc(PAGE_SIZE, sizeof(char));
-        fgets(headerPage, PAGE_SIZE, filePtr);
-        char *totalPage;
-        totalPage = headerPage;
+void initStorageManager(void)
+{
+}
 
-        (*fHandle).totalNumPages = atoi(totalPage); // convert to integer
-        (*fHandle).curPagePos = 0;                  // store the current page position
+/*
+    # It creates a new page file with "fileName" and pages of PAGE_SIZE bytes
+*/
+RC createPageFile(char *fileName)
+{
+    return createPageFileWithPageSize(fileName, PAGE_SIZE);
+}
 
-        // store the File pointer information in the Management info of Page Handle
-        (*fHandle).mgmtInfo = filePtr;
+/*
+    # It creates a new page file with "fileName" and pages of pageSize bytes, a power of two from
+      SM_MIN_PAGE_SIZE to SM_MAX_PAGE_SIZE, which is recorded in the header
+    # Writes the header page and one empty page, the pages are zero bytes
+    # Returns RC_FILE_NOT_FOUND if unsuccessfull and RC_INVALID_INPUT for an invalid page size
+*/
+RC createPageFileWithPageSize(char *fileName, int pageSize)
+{
+    if (!isValidPageSize(pageSize))
+        return RC_INVALID_INPUT;
 
-        free(headerPage); // free memory to avoid memory leaks
+    // Open the file, truncating an existing one
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
 
-        return RC_OK;
-    }
-    else // if file does not exists
+    // Check if the file was opened successfully
+    if (fd < 0)
+        return RC_FILE_NOT_FOUND;
+
+    // size the file for the header page and the first page, then write the header with a page count of 1
+    RC status = RC_OK;
+    if (ftruncate(fd, 2 * (off_t)pageSize) != 0 || writeHeader(fd, 1, pageSize) != 0)
+        status = RC_WRITE_FAILED;
+
+    // Close the file descriptor
+    if (close(fd) != 0 && status == RC_OK)
+        status = RC_WRITE_FAILED;
+
+    return status;
+}
+
+/*
+    # This method opens an existing page file with the stdio backend
+*/
+RC openPageFile(char *fileName, SM_FileHandle *fHandle)
+{
+    return openPageFileWithBackend(fileName, fHandle, SM_BACKEND_STDIO);
+}
+
+/*
+    # This method opens an existing page file, its blocks are accessed through the given backend
+    # Updates and stores the file attributes in mgmtInfo, the page count comes from the header
+    # Returns RC_FILE_NOT_FOUND if the file does not exist and RC_INVALID_PAGE_FILE if its header is not
+      one of a page file
+*/
+RC openPageFileWithBackend(char *fileName, SM_FileHandle *fHandle, SM_Backend backend)
+{
+    SM_FileHeader header;
+
+    if (backend != SM_BACKEND_STDIO && backend != SM_BACKEND_MMAP && !isDirect(backend))
+        return RC_INVALID_INPUT;
+
+    SM_FileMgmt *mgmt = (SM_FileMgmt *)calloc(1, sizeof(SM_FileMgmt));
+    if (mgmt == NULL)
+        return RC_MEMORY_ALLOCATION_FAIL;
+    mgmt->directFd = -1;
+
+    int fd = open(fileName, O_RDWR); // open the pageFile
+    if (fd < 0) // if file does not exists
     {
+        free(mgmt);
         return RC_FILE_NOT_FOUND;
     }
+
+    // read the header with one fixed-size read and check that it belongs to a page file
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || header.magic != SM_FILE_MAGIC ||
+        header.version != SM_FILE_VERSION || !isValidPageSize((int)header.pageSize) || header.totalNumPages < 0)
+    {
+        close(fd);
+        free(mgmt);
+        return RC_INVALID_PAGE_FILE;
+    }
+
+    // the direct backends use a second descriptor, file systems without O_DIRECT and pages smaller than
+    // its alignment get a buffered one
+    if (isDirect(backend))
+    {
+        if (header.pageSize % DIRECT_ALIGNMENT == 0)
+            mgmt->directFd = open(fileName, O_RDWR | O_DIRECT);
+        mgmt->directIO = mgmt->directFd >= 0;
+        if (mgmt->directFd < 0)
+            mgmt->directFd = open(fileName, O_RDWR);
+        if (mgmt->directFd >= 0)
+            mgmt->engine = ioEngineCreate(mgmt->directFd, backend == SM_BACKEND_DIRECT);
+        if (mgmt->engine == NULL)
+        {
+            if (mgmt->directFd >= 0)
+                close(mgmt->directFd);
+            close(fd);
+            free(mgmt);
+            return RC_FILE_NOT_FOUND;
+        }
+    }
+
+    /*update the fileHandle attributes*/
+
+    (*fHandle).fileName = fileName;                  // store the file name
+    (*fHandle).totalNumPages = header.totalNumPages; // store the Total Number of Pages
+    (*fHandle).curPagePos = 0;                       // store the current page position
+    (*fHandle).pageSize = header.pageSize;           // store the page size
+
+    // store the file descriptor and the backend in the Management info of Page Handle
+    mgmt->fd = fd;
+    mgmt->backend = backend;
+    mgmt->reservedPages = header.totalNumPages;
+    mgmt->pageSize = header.pageSize;
+    (*fHandle).mgmtInfo = mgmt;
+
+    return RC_OK;
 }
 
 /*
@@ -96,8 +419,32 @@ RC openPageFile(char *fileName, SM_FileHandle *fHandle)
 */
 RC closePageFile(SM_FileHandle *fHandle)
 {
+    SM_FileMgmt *mgmt = mgmtOf(fHandle);
+    int fd = mgmt->fd;
+
+    // stop the I/O engine of the direct backends
+    if (mgmt->engine != NULL)
+        ioEngineDestroy(mgmt->engine);
+    if (mgmt->directFd >= 0)
+        close(mgmt->directFd);
+
+    // release the disk space reserved past the end of the file
+    if (mgmt->reservedPages > (*fHandle).totalNumPages)
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)((*fHandle).totalNumPages + 1) * mgmt->pageSize,
+                  (off_t)(mgmt->reservedPages - (*fHandle).totalNumPages) * mgmt->pageSize);
+
+    // unmap the chunks used by the mmap backend
+    for (int i = 0; i < mgmt->numChunks; i++)
+    {
+        if (mgmt->chunks[i] != NULL)
+            munmap(mgmt->chunks[i], MMAP_CHUNK_SIZE);
+    }
+    free(mgmt->chunks);
+    free(mgmt);
+    (*fHandle).mgmtInfo = NULL;
+
     // if closing the file is success
-    if (fclose((*fHandle).mgmtInfo) == 0)
+    if (close(fd) == 0)
     {
         return RC_OK;
     }
@@ -123,6 +470,55 @@ RC destroyPageFile(char *fileName)
     }
 }
 
+/*
+    # Reads or writes numPages consecutive blocks starting at pageNum.
+    # The direct backends hand them to the I/O engine as one request.
+    # The mmap backend copies them from or to the mapping, the stdio backend uses preadv or pwritev on
+      the file descriptor through ioTransfer, BLOCKS_PER_IOV blocks per call.
+    # Returns 0 on success, -1 if a call fails or the file ends before the last block.
+*/
+static int transferBlocks(SM_FileMgmt *mgmt, int pageNum, int numPages, SM_PageHandle *memPages, int write)
+{
+    struct iovec iov[BLOCKS_PER_IOV];
+
+    if (isDirect(mgmt->backend))
+    {
+        SM_IORequest request = {pageNum, numPages, memPages, write, RC_OK};
+        return directSubmit(mgmt, &request, 1);
+    }
+
+    if (mgmt->backend == SM_BACKEND_MMAP)
+    {
+        for (int i = 0; i < numPages; i++)
+        {
+            char *block = mappedBlock(mgmt, pageNum + i);
+            if (block == NULL)
+                return -1;
+            if (write)
+                memcpy(block, memPages[i], mgmt->pageSize);
+            else
+                memcpy(memPages[i], block, mgmt->pageSize);
+        }
+        return 0;
+    }
+
+    for (int done = 0; done < numPages;)
+    {
+        int count = numPages - done < BLOCKS_PER_IOV ? numPages - done : BLOCKS_PER_IOV;
+        SM_IOTask task = {write, (off_t)(pageNum + done + 1) * mgmt->pageSize, iov, count, 0};
+
+        for (int i = 0; i < count; i++)
+        {
+            iov[i].iov_base = memPages[done + i];
+            iov[i].iov_len = mgmt->pageSize;
+        }
+        if (ioTransfer(mgmt->fd, &task) != 0)
+            return -1;
+        done += count;
+    }
+    return 0;
+}
+
 /*
     # This method checks if the page is valid or not and returns RC_READ_NON_EXISTING_PAGE if invalid
     # Reads a page specified by pageNum to memPage
@@ -134,23 +530,94 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_FILE_HANDLE_NOT_INIT;
 
     // Validate the page number for suring that it is in valid range
-    if (pageNum < 0 || pageNum > (*fHandle).totalNumPages - 1)
+    if (pageNum < 0 || pageNum > pageCountOf(fHandle) - 1)
     {
         // Return an error if the page does not exist
         return RC_READ_NON_EXISTING_PAGE;
     }
 
-    // Setting the file pointer at the correct position for reading a block
+    // Read the block through the I/O engine of the direct backends
+    else if (isDirect(mgmtOf(fHandle)->backend))
+    {
+        SM_IORequest request = {pageNum, 1, &memPage, 0, RC_OK};
+        if (directSubmit(mgmtOf(fHandle), &request, 1) != 0)
+            return RC_READ_NON_EXISTING_PAGE;
+        // Updates current page position
+        setBlockPos(fHandle, pageNum);
+        return RC_OK;
+    }
+
+    // Copy the block out of the mapping of the file
+    else if (mgmtOf(fHandle)->backend == SM_BACKEND_MMAP)
+    {
+        char *block = mappedBlock(mgmtOf(fHandle), pageNum);
+        if (block == NULL)
+            return RC_READ_NON_EXISTING_PAGE;
+        memcpy(memPage, block, mgmtOf(fHandle)->pageSize);
+        // Updates current page position
+        setBlockPos(fHandle, pageNum);
+        return RC_OK;
+    }
+
+    // Read the block at its offset with pread
     else
     {
-        fseek((*fHandle).mgmtInfo, (pageNum + 1) * PAGE_SIZE, SEEK_SET);
-        fread(memPage, sizeof(char), PAGE_SIZE, (*fHandle).mgmtInfo);
+        if (transferBlocks(mgmtOf(fHandle), pageNum, 1, &memPage, 0) != 0)
+            return RC_READ_NON_EXISTING_PAGE;
         // Updates current page position
-        (*fHandle).curPagePos = pageNum;
+        setBlockPos(fHandle, pageNum);
         return RC_OK;
     }
 }
 
+/*
+    # This method returns in memPage the address of a block inside the mapping of a file opened
+      with SM_BACKEND_MMAP, so that the block can be read without copying it
+    # The address stays valid until the file is closed, writes through it change the file
+    # Returns RC_INVALID_INPUT for files opened with another backend
+*/
+RC mapBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage)
+{
+    if (fHandle == NULL)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    if (mgmtOf(fHandle)->backend != SM_BACKEND_MMAP)
+        return RC_INVALID_INPUT;
+
+    if (pageNum < 0 || pageNum > pageCountOf(fHandle) - 1)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    char *block = mappedBlock(mgmtOf(fHandle), pageNum);
+    if (block == NULL)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    *memPage = block;
+    return RC_OK;
+}
+
+/*
+    # The following method reads numPages consecutive blocks starting at pageNum into memPages
+    # It uses vectored reads, so a run of adjacent pages costs one system call instead of a seek and read each
+    # Returns RC_READ_NON_EXISTING_PAGE if any of the pages does not exist in the file or the read fails.
+*/
+RC readBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    if (fHandle == NULL)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    if (pageNum < 0 || numPages < 0 || pageNum + numPages > pageCountOf(fHandle))
+        return RC_READ_NON_EXISTING_PAGE;
+
+    if (transferBlocks(mgmtOf(fHandle), pageNum, numPages, memPages, 0) != 0)
+        return RC_READ_NON_EXISTING_PAGE;
+
+    // update the curPagePos to the last page read
+    if (numPages > 0)
+        setBlockPos(fHandle, pageNum + numPages - 1);
+
+    return RC_OK;
+}
+
 /*
     # The following method returns the page currently pointed.
 */
@@ -263,24 +730,120 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_FILE_HANDLE_NOT_INIT;
 
     // check if the provided page number exists in the file or no
-    if (pageNum > (*fHandle).totalNumPages - 1 || pageNum < 0)
+    if (pageNum > pageCountOf(fHandle) - 1 || pageNum < 0)
     {
         // page with pageNum doesn't exist
         return RC_WRITE_FAILED;
     }
 
-    // moving the file cursor to the page number provided
-    fseek((*fHandle).mgmtInfo, (pageNum + 1) * PAGE_SIZE, SEEK_SET);
+    // write the block through the I/O engine of the direct backends
+    if (isDirect(mgmtOf(fHandle)->backend))
+    {
+        SM_IORequest request = {pageNum, 1, &memPage, 1, RC_OK};
+        if (directSubmit(mgmtOf(fHandle), &request, 1) != 0)
+            return RC_WRITE_FAILED;
+
+        // update the curPagePos to pageNum;
+        setBlockPos(fHandle, pageNum);
+
+        return RC_OK;
+    }
+
+    // copy the block into the mapping of the file
+    if (mgmtOf(fHandle)->backend == SM_BACKEND_MMAP)
     {
-        // write the block to memPage
-        fwrite(memPage, PAGE_SIZE, 1, (*fHandle).mgmtInfo);
+        char *block = mappedBlock(mgmtOf(fHandle), pageNum);
+        if (block == NULL)
+            return RC_WRITE_FAILED;
+        memcpy(block, memPage, mgmtOf(fHandle)->pageSize);
 
         // update the curPagePos to pageNum;
-        (*fHandle).curPagePos = pageNum;
+        setBlockPos(fHandle, pageNum);
 
         return RC_OK;
     }
+
+    // write the block at its offset with pwrite
+    if (transferBlocks(mgmtOf(fHandle), pageNum, 1, &memPage, 1) != 0)
+        return RC_WRITE_FAILED;
+
+    // update the curPagePos to pageNum;
+    setBlockPos(fHandle, pageNum);
+
+    return RC_OK;
 }
+
+/*
+    # The following method writes numPages consecutive blocks starting at pageNum from memPages
+    # It uses vectored writes, so a run of adjacent pages costs one system call instead of a seek and write each
+    # Returns RC_WRITE_FAILED if any of the pages does not exist in the file or the write fails.
+*/
+RC writeBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    if (fHandle == NULL)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    // all the pages have to exist in the file, as for writeBlock
+    if (pageNum < 0 || numPages < 0 || pageNum + numPages > pageCountOf(fHandle))
+        return RC_WRITE_FAILED;
+
+    if (transferBlocks(mgmtOf(fHandle), pageNum, numPages, memPages, 1) != 0)
+        return RC_WRITE_FAILED;
+
+    // update the curPagePos to the last page written
+    if (numPages > 0)
+        setBlockPos(fHandle, pageNum + numPages - 1);
+
+    return RC_OK;
+}
+
+/*
+    # The following method performs several reads and writes of consecutive blocks together
+    # With the direct backends all of them are in flight at once, the other backends do them one after another
+    # Every request gets its own status, the method returns the status of the first failed request or RC_OK
+*/
+RC submitBlocks(SM_FileHandle *fHandle, SM_IORequest *requests, int numRequests)
+{
+    if (fHandle == NULL)
+        return RC_FILE_HANDLE_NOT_INIT;
+
+    if (numRequests < 0 || (numRequests > 0 && requests == NULL))
+        return RC_INVALID_INPUT;
+
+    // the direct backends run the whole batch unless some request is out of range
+    int totalNumPages = pageCountOf(fHandle);
+    int valid = isDirect(mgmtOf(fHandle)->backend);
+    for (int i = 0; i < numRequests && valid; i++)
+    {
+        if (requests[i].pageNum < 0 || requests[i].numPages < 0 ||
+            requests[i].pageNum + requests[i].numPages > totalNumPages)
+            valid = 0;
+    }
+
+    if (valid && numRequests > 0)
+    {
+        directSubmit(mgmtOf(fHandle), requests, numRequests);
+        setBlockPos(fHandle, requests[numRequests - 1].pageNum + requests[numRequests - 1].numPages - 1);
+    }
+    else
+    {
+        for (int i = 0; i < numRequests; i++)
+        {
+            SM_IORequest *request = &requests[i];
+            request->status = request->write
+                                  ? writeBlocks(request->pageNum, request->numPages, fHandle, request->memPages)
+                                  : readBlocks(request->pageNum, request->numPages, fHandle, request->memPages);
+        }
+    }
+
+    for (int i = 0; i < numRequests; i++)
+    {
+        if (requests[i].status != RC_OK)
+            return requests[i].status;
+    }
+    return RC_OK;
+}
+
 /*
     # The method below writes the current page to memPage.
     # Returns RC_WRITE_FAILED in case of any error.
@@ -300,7 +863,7 @@ RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 /*
     # The method below creates a new block and fills it with zero bytes.
     # It also updates the required file attributes for the filepage.
-    # Writes the newly created block to the file.
+    # Adds the newly created block to the file and updates the page count in the header.
 */
 RC appendEmptyBlock(SM_FileHandle *fHandle)
 {
@@ -308,46 +871,14 @@ RC appendEmptyBlock(SM_FileHandle *fHandle)
     if (fHandle == NULL)
         return RC_FILE_HANDLE_NOT_INIT;
 
-    // create and allocate the new empty block.
-    char *newBlock;
-
-    newBlock = (char *)calloc(PAGE_SIZE, sizeof(char));
-
-    // move the cursor to the recently added block
-    fseek((*fHandle).mgmtInfo, ((*fHandle).totalNumPages + 1) * PAGE_SIZE, SEEK_SET);
-
-    // append the block to the file if possible
-    if (fwrite(newBlock, PAGE_SIZE, 1, (*fHandle).mgmtInfo))
-    {
-        // update the attributes of fhandle
-        (*fHandle).curPagePos = (*fHandle).totalNumPages - 1;
-        (*fHandle).totalNumPages += 1;
-
-        // seek to the header page to update the total pages
-        fseek((*fHandle).mgmtInfo, 0L, SEEK_SET);
-        // write with formatting required as totalNumPages is of int type
-        fprintf((*fHandle).mgmtInfo, "%d", (*fHandle).totalNumPages);
-
-        // free up the allocated space
-        free(newBlock);
-
-        // append to file successful
-        return RC_OK;
-    }
-    else
-    {
-        // free up the allocated space
-        free(newBlock);
-
-        // append to file unsuccessful
-        return RC_WRITE_FAILED;
-    }
+    // grow the file, the new block reads as zero bytes
+    return growPageFile(fHandle, 1);
 }
 
 /*
     # The following method ensures that the file has specified numberOfPages
     # If the file doesn't have specified numberOfPages.
-    # then the required number of pages are added to achieve the specified capacity.
+    # then the required number of pages are added in one step, with a single update of the header.
 */
 RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
 {
@@ -356,19 +887,10 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
         return RC_FILE_HANDLE_NOT_INIT;
 
     // check if the toatal pages equals the specified numberOFPages
-    if (numberOfPages <= (*fHandle).totalNumPages)
+    int totalNumPages = pageCountOf(fHandle);
+    if (numberOfPages <= totalNumPages)
         return RC_OK;
 
-    int i, requiredPages;
-
-    // calculate the number of pages to add
-    requiredPages = numberOfPages - (*fHandle).totalNumPages;
-
-    // iterate through and add required number of pages
-    for (int i = 0; i < requiredPages; i++)
-    {
-        // adds empty pages
-        appendEmptyBlock(fHandle);
-    }
-    return RC_OK;
+    // add the required number of pages
+    return growPageFile(fHandle, numberOfPages - totalNumPages);
 }
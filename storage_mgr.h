@@ -10,33 +10,61 @@ typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
+	int pageSize;		// size of the pages in bytes, read from the header of the file
 	void *mgmtInfo;
 } SM_FileHandle;
 
+// page sizes a page file can be created with, powers of two, PAGE_SIZE is the default
+#define SM_MIN_PAGE_SIZE 512
+#define SM_MAX_PAGE_SIZE (1024 * 1024)
+
 typedef char* SM_PageHandle;
 
+// How the blocks of an open page file are read and written
+typedef enum SM_Backend {
+	SM_BACKEND_STDIO = 0,	// pread and pwrite on a file descriptor
+	SM_BACKEND_MMAP = 1,	// memcpy from and to a shared mapping of the file
+	SM_BACKEND_DIRECT = 2,	// O_DIRECT, batches are submitted through io_uring, or I/O threads without it
+	SM_BACKEND_DIRECT_THREADS = 3	// O_DIRECT, batches always run on I/O threads
+} SM_Backend;
+
+// One read or write of consecutive blocks for submitBlocks
+typedef struct SM_IORequest {
+	int pageNum;
+	int numPages;
+	SM_PageHandle *memPages;
+	int write;		// 1 to write the blocks, 0 to read them
+	RC status;		// result of the request, set by submitBlocks
+} SM_IORequest;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithPageSize (char *fileName, int pageSize);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileWithBackend (char *fileName, SM_FileHandle *fHandle, SM_Backend backend);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern int getBlockPos (SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC mapBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *memPage);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC submitBlocks (SM_FileHandle *fHandle, SM_IORequest *requests, int numRequests);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
 
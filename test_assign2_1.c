@@ -1,12 +1,14 @@
 #include "storage_mgr.h"
 #include "buffer_mgr_stat.h"
 #include "buffer_mgr.h"
+#include "buffer_trace.h"
 #include "dberror.h"
 #include "test_helper.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // var to store the current test's name
 char *testName;
@@ -38,6 +40,25 @@ static void testReadPage(void);
 
 static void testFIFO(void);
 static void testLRU(void);
+static void testLRUHits(void);
+static void testForceFlushPool(void);
+static void testReadAhead(void);
+static void testPrefetchPages(void);
+static void testMappedStorage(void);
+static void testDirectStorage(void);
+static void testPageFileHeader(void);
+static void testEnsureCapacity(void);
+static void testPinPages(void);
+static void testPageSizes(void);
+static void testShardedPool(void);
+static void testNumaPlacement(void);
+static void testPoolStats(void);
+static void testTraceFile(void);
+static void testHotSet(void);
+static void testResize(void);
+static void testSharedFiles(void);
+static void testCompressedTier(void);
+static void testFramePages(void);
 
 // main method
 int main(void)
@@ -49,6 +70,25 @@ int main(void)
   testReadPage();
   testFIFO();
   testLRU();
+  testLRUHits();
+  testForceFlushPool();
+  testReadAhead();
+  testPrefetchPages();
+  testMappedStorage();
+  testDirectStorage();
+  testPageFileHeader();
+  testEnsureCapacity();
+  testPinPages();
+  testPageSizes();
+  testShardedPool();
+  testNumaPlacement();
+  testPoolStats();
+  testTraceFile();
+  testHotSet();
+  testResize();
+  testSharedFiles();
+  testCompressedTier();
+  testFramePages();
 }
 
 // create n pages with content "Page X" and read them back to check whether the content is right
@@ -291,3 +331,1322 @@ void testLRU(void)
   free(h);
   TEST_DONE();
 }
+
+// test that a buffer hit makes a page the most recently used one
+void testLRUHits(void)
+{
+  // expected results
+  const char *poolContents[] = {
+      "[0 0],[1 0],[2 0]",
+      // page 0 was used after 1 and 2, so 1 is replaced
+      "[0 0],[3 0],[2 0]",
+      // page 2 was used after 0 and 3, so 0 is replaced
+      "[4 0],[3 0],[2 0]"};
+  const int requests[] = {0, 1, 2, 0, 3, 2, 4};
+  const int snapshotAfter[] = {2, 4, 6};
+
+  int i;
+  int snapshot = 0;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LRU order after buffer hits";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  for (i = 0; i < 7; i++)
+  {
+    pinPage(bm, h, requests[i]);
+    unpinPage(bm, h);
+    if (i == snapshotAfter[snapshot])
+    {
+      ASSERT_EQUALS_POOL(poolContents[snapshot], bm, "check pool content using pages");
+      snapshot++;
+    }
+  }
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// dirty pages spread over the frames out of page order are all written by one flush,
+// pinned pages are left alone until they are unpinned
+void testForceFlushPool(void)
+{
+  const int requests[] = {7, 2, 3, 9, 1, 8, 5, 0};
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  bool *dirtyFlags;
+  testName = "Testing sorted and coalesced forceFlushPool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_FIFO, NULL));
+
+  for (i = 0; i < 8; i++)
+  {
+    CHECK(pinPage(bm, h, requests[i]));
+    sprintf(h->data, "%s-%i", "Flushed", h->pageNum);
+    CHECK(markDirty(bm, h));
+    if (requests[i] != 5)
+    {
+      CHECK(unpinPage(bm, h));
+    }
+  }
+
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(7, getNumWriteIO(bm), "every unpinned dirty page is written once");
+  dirtyFlags = getDirtyFlags(bm);
+  for (i = 0; i < 8; i++)
+  {
+    ASSERT_EQUALS_INT(requests[i] == 5, dirtyFlags[i], "only the pinned page is still dirty");
+  }
+
+  h->pageNum = 5;
+  CHECK(unpinPage(bm, h));
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(8, getNumWriteIO(bm), "the unpinned page is written by the next flush");
+  CHECK(shutdownBufferPool(bm));
+
+  // read the pages back through a new pool
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 10; i++)
+  {
+    char expected[64];
+    CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", (i == 4 || i == 6) ? "Page" : "Flushed", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "the flushed pages are on disk");
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a sequential scan is detected by its second miss, which reads the following pages as well
+void testReadAhead(void)
+{
+  int i, j;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  char expected[64];
+  testName = "Testing read ahead of sequential scans";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+
+  options.readAheadPages = -1;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_FIFO, NULL, &options),
+               "a negative read ahead is rejected");
+
+  options.readAheadPages = 4;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_FIFO, NULL, &options));
+
+  for (i = 0; i < 2; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0],[5 0],[-1 0],[-1 0],[-1 0],[-1 0]", bm,
+                     "the second miss reads the next four pages along");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+
+  for (i = 2; i < 20; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "read ahead pages have the right content");
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(20, getNumReadIO(bm), "every page is read once");
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  CHECK(shutdownBufferPool(bm));
+
+  // a dirty victim is written back and replaced, the read ahead goes on past it
+  options.readAheadPages = 2;
+  for (i = 0; i < 2; i++)
+  {
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, i == 0 ? RS_FIFO : RS_LRU, NULL, &options));
+    CHECK(pinPage(bm, h, 2));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    for (j = 5; j < 10; j += 2)
+    {
+      CHECK(pinPage(bm, h, j));
+      CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[2x0],[5 0],[7 0],[9 0]", bm, "the oldest page is dirty");
+
+    CHECK(pinPage(bm, h, 10));
+    ASSERT_EQUALS_POOL("[10 1],[11 0],[12 0],[9 0]", bm, "the read ahead replaces the pages in order");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty victim is written back");
+    ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+  }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// explicit prefetch hints read missing pages, skipping resident ones and the end of the file
+void testPrefetchPages(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing prefetchPages";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_FIFO, NULL));
+
+  CHECK(prefetchPages(bm, 12, 4));
+  ASSERT_EQUALS_POOL("[12 0],[13 0],[14 0],[15 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0]", bm,
+                     "the pages are read into free frames");
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(pinPage(bm, h, 13));
+  ASSERT_EQUALS_STRING("Page-13", h->data, "a prefetched page is pinned without a read");
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(prefetchPages(bm, 14, 10));
+  ASSERT_EQUALS_POOL("[12 0],[13 1],[14 0],[15 0],[16 0],[17 0],[18 0],[19 0],[-1 0],[-1 0]", bm,
+                     "resident pages and pages past the end of the file are skipped");
+  ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+  CHECK(unpinPage(bm, h));
+
+  ASSERT_ERROR(prefetchPages(bm, -1, 2), "a negative page number is rejected");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// with the mmap storage backend read only pins of pages that are not resident point into the
+// mapped file, pages written through the pool and pages added to the file end up on disk
+void testMappedStorage(void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  testName = "Testing the mmap storage backend";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  options.storageBackend = SM_BACKEND_MMAP;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+
+  CHECK(pinPageReadOnly(bm, h, 4));
+  ASSERT_EQUALS_STRING("Page-4", h->data, "a read only pin sees the page content");
+  ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0]", bm, "the page is not read into a frame");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(0, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(pinPage(bm, h, 2));
+  sprintf(h->data, "%s-%i", "Mapped", h->pageNum);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPageReadOnly(bm, h, 2));
+  ASSERT_EQUALS_STRING("Mapped-2", h->data, "a resident page is pinned in its frame");
+  ASSERT_EQUALS_POOL("[2x1],[-1 0],[-1 0]", bm, "check pool content");
+  CHECK(unpinPage(bm, h));
+
+  // grow the file, replacing the dirty page
+  for (i = 10; i < 13; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[12 0],[10 0],[11 0]", bm, "check pool content");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty page was written back");
+  CHECK(pinPageReadOnly(bm, h, 2));
+  ASSERT_EQUALS_STRING("Mapped-2", h->data, "the mapped file has the written page");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // read the file back with the stdio backend
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_STRING("Mapped-2", h->data, "the written page is on disk");
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 4));
+  ASSERT_EQUALS_STRING("Page-4", h->data, "the other pages are unchanged");
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 12));
+  ASSERT_EQUALS_STRING("", h->data, "the added pages are empty");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "the added pages are part of the file");
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// the direct backends write a flush and read a prefetch with one batch of requests, which
+// leaves the file readable by the stdio backend
+void testDirectStorage(void)
+{
+  int i, b;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  SM_Backend backends[] = {SM_BACKEND_DIRECT, SM_BACKEND_DIRECT_THREADS};
+  char expected[64];
+  testName = "Testing the direct storage backends";
+
+  for (b = 0; b < 2; b++)
+  {
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 4);
+
+    options.storageBackend = backends[b];
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_FIFO, NULL, &options));
+
+    // every other page, so the flush is a batch of separate runs, and pages past the end of the file
+    for (i = 0; i < 16; i++)
+    {
+      CHECK(pinPage(bm, h, 2 * i + 1));
+      sprintf(h->data, "%s-%i", "Direct", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+    CHECK(forceFlushPool(bm));
+    ASSERT_EQUALS_INT(16, getNumWriteIO(bm), "check number of write I/Os");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_FIFO, NULL, &options));
+    CHECK(prefetchPages(bm, 16, 16));
+    ASSERT_EQUALS_INT(16, getNumReadIO(bm), "the prefetched pages are read at once");
+    for (i = 16; i < 32; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, i % 2 == 1 ? "Direct-%i" : "", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "a prefetched page has its content");
+      CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(16, getNumReadIO(bm), "the pins hit the prefetched pages");
+    CHECK(shutdownBufferPool(bm));
+
+    // read the file back with the stdio backend
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 4; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", i % 2 == 1 ? "Direct" : "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "the written pages are on disk");
+      CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+  }
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// the page count is kept in the binary header, files with another header are rejected
+void testPageFileHeader(void)
+{
+  SM_FileHandle fh;
+  FILE *file;
+  testName = "Testing the page file header";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(1, fh.totalNumPages, "a new file has one page");
+  CHECK(ensureCapacity(5, &fh));
+  CHECK(closePageFile(&fh));
+
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(5, fh.totalNumPages, "the page count is read from the header");
+  CHECK(closePageFile(&fh));
+
+  // a header with the page count as text, as written by older versions
+  file = fopen("testbuffer.bin", "r+");
+  fputs("5", file);
+  fclose(file);
+  ASSERT_EQUALS_INT(RC_INVALID_PAGE_FILE, openPageFile("testbuffer.bin", &fh), "a file without the magic number is rejected");
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // a file too short for the header
+  file = fopen("testbuffer.bin", "w");
+  fclose(file);
+  ASSERT_EQUALS_INT(RC_INVALID_PAGE_FILE, openPageFile("testbuffer.bin", &fh), "an empty file is rejected");
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  TEST_DONE();
+}
+
+// ensureCapacity grows the file in one step, the file keeps the size of its pages
+void testEnsureCapacity(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle page = (SM_PageHandle)malloc(PAGE_SIZE);
+  FILE *file;
+  int i;
+  testName = "Testing bulk ensureCapacity";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(ensureCapacity(1000, &fh));
+  ASSERT_EQUALS_INT(1000, fh.totalNumPages, "the file has the requested pages");
+  CHECK(ensureCapacity(10, &fh));
+  ASSERT_EQUALS_INT(1000, fh.totalNumPages, "a file is never shrunk");
+
+  memset(page, 'x', PAGE_SIZE);
+  CHECK(readBlock(999, &fh, page));
+  for (i = 0; i < PAGE_SIZE && page[i] == 0; i++)
+    ;
+  ASSERT_EQUALS_INT(PAGE_SIZE, i, "the added pages are empty");
+
+  CHECK(appendEmptyBlock(&fh));
+  ASSERT_EQUALS_INT(1001, fh.totalNumPages, "appendEmptyBlock adds one page");
+  CHECK(closePageFile(&fh));
+
+  // the header page and the pages, no disk space reserved past them is part of the file
+  file = fopen("testbuffer.bin", "r");
+  fseek(file, 0L, SEEK_END);
+  ASSERT_EQUALS_INT(1002 * PAGE_SIZE, (int)ftell(file), "check file size");
+  fclose(file);
+
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(1001, fh.totalNumPages, "the header has the page count");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  TEST_DONE();
+}
+
+// pinPages pins the hits and reads the misses together, if one page cannot be pinned none is
+void testPinPages(void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle handles[7];
+  PageNumber pages[] = {7, 3, 5, 6, 7, 2};
+  PageNumber tooMany[] = {10, 11, 12, 13, 14, 15, 16};
+  PageNumber oldest[] = {5};
+  char expected[64];
+  int *fixCounts;
+  testName = "Testing pinPages and unpinPages";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_FIFO, NULL));
+
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(pinPages(bm, handles, pages, 6));
+  ASSERT_EQUALS_POOL("[3 1],[2 1],[5 1],[6 1],[7 2],[-1 0]", bm, "the misses are read in page number order");
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "check number of read I/Os");
+  for (i = 0; i < 6; i++)
+  {
+    sprintf(expected, "%s-%i", "Page", pages[i]);
+    ASSERT_EQUALS_STRING(expected, handles[i].data, "every handle has its page");
+  }
+  CHECK(unpinPages(bm, handles, 6));
+  ASSERT_EQUALS_POOL("[3 0],[2 0],[5 0],[6 0],[7 0],[-1 0]", bm, "all pins are released");
+
+  ASSERT_EQUALS_INT(RC_BM_NO_FREE_FRAME, pinPages(bm, handles, tooMany, 7), "more pages than frames");
+  fixCounts = getFixCounts(bm);
+  for (i = 0; i < bm->numPages; i++)
+  {
+    ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+  }
+
+  ASSERT_ERROR(pinPages(bm, handles, pages, -1), "a negative count is rejected");
+  CHECK(shutdownBufferPool(bm));
+
+  // the dirty victim the policy picks for a miss is the one written back and replaced
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 3; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    if (i == 0)
+    {
+      CHECK(markDirty(bm, h));
+    }
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(pinPages(bm, handles, oldest, 1));
+  ASSERT_EQUALS_POOL("[5 1],[1 0],[2 0]", bm, "the oldest page is replaced after it is written back");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty victim is written back");
+  CHECK(unpinPages(bm, handles, 1));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pools take the page size of their file, so pools with different page sizes can be open at once
+void testPageSizes(void)
+{
+  int i, b;
+  BM_BufferPool *large = MAKE_POOL();
+  BM_BufferPool *small = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  SM_Backend backends[] = {SM_BACKEND_STDIO, SM_BACKEND_MMAP, SM_BACKEND_DIRECT};
+  int sizes[] = {64 * 1024, 512};
+  char expected[64];
+  testName = "Testing page sizes of page files";
+
+  ASSERT_ERROR(createPageFileWithPageSize("testbuffer.bin", 3000), "a page size has to be a power of two");
+  ASSERT_ERROR(createPageFileWithPageSize("testbuffer.bin", 256), "too small a page size is rejected");
+
+  for (b = 0; b < 3; b++)
+  {
+    CHECK(createPageFileWithPageSize("testbuffer.bin", sizes[0]));
+    CHECK(createPageFileWithPageSize("testbuffer2.bin", sizes[1]));
+    options.storageBackend = backends[b];
+    CHECK(initBufferPoolWithOptions(large, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+    CHECK(initBufferPoolWithOptions(small, "testbuffer2.bin", 3, RS_FIFO, NULL, &options));
+    ASSERT_EQUALS_INT(sizes[0], getPageSize(large), "the pool takes the page size of its file");
+    ASSERT_EQUALS_INT(sizes[1], getPageSize(small), "the pool takes the page size of its file");
+
+    // write the number of each page into its last bytes, past the default page size in the large pool
+    for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(large, h, i));
+      sprintf(h->data + sizes[0] - 8, "L-%i", i);
+      CHECK(markDirty(large, h));
+      CHECK(unpinPage(large, h));
+      CHECK(pinPage(small, h, i));
+      sprintf(h->data + sizes[1] - 8, "S-%i", i);
+      CHECK(markDirty(small, h));
+      CHECK(unpinPage(small, h));
+    }
+    CHECK(shutdownBufferPool(large));
+    CHECK(shutdownBufferPool(small));
+
+    // read the pages back with the default backend
+    CHECK(initBufferPool(large, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(initBufferPool(small, "testbuffer2.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(large, h, i));
+      sprintf(expected, "L-%i", i);
+      ASSERT_EQUALS_STRING(expected, h->data + sizes[0] - 8, "the end of a large page is on disk");
+      CHECK(unpinPage(large, h));
+      CHECK(pinPage(small, h, i));
+      sprintf(expected, "S-%i", i);
+      ASSERT_EQUALS_STRING(expected, h->data + sizes[1] - 8, "the end of a small page is on disk");
+      CHECK(unpinPage(small, h));
+    }
+    CHECK(shutdownBufferPool(large));
+    CHECK(shutdownBufferPool(small));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+  }
+
+  // a pool asking for another page size than its file has is rejected
+  options.storageBackend = SM_BACKEND_STDIO;
+  options.pageSize = PAGE_SIZE;
+  ASSERT_ERROR(initBufferPoolWithOptions(large, "testbuffer.bin", 3, RS_FIFO, NULL, &options), "the page size has to match the file");
+  options.pageSize = sizes[0];
+  CHECK(initBufferPoolWithOptions(large, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+  CHECK(shutdownBufferPool(large));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(large);
+  free(small);
+  free(h);
+  TEST_DONE();
+}
+
+// a sharded pool keeps each page in the shard of its extent, replaces pages within that shard
+// and reports the frames and counters of all shards together
+void testShardedPool(void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle handles[3];
+  PageNumber pages[] = {17, 1, 16};
+  BM_PoolOptions options = {0};
+  char expected[64];
+  testName = "Testing sharded buffer pools";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 64);
+
+  options.numShards = 5;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options), "every shard needs a frame");
+  options.numShards = -1;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options), "a negative count is rejected");
+
+  // pages 0 to 15 belong to the first shard and pages 16 to 31 to the second one
+  options.numShards = 2;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options));
+  ASSERT_EQUALS_INT(2, getNumShards(bm), "check number of shards");
+
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPages(bm, handles, pages, 3));
+  ASSERT_EQUALS_POOL("[0 0],[1 1],[16 1],[17 1]", bm, "the shards fill their own frames");
+  for (i = 0; i < 3; i++)
+  {
+    sprintf(expected, "%s-%i", "Page", pages[i]);
+    ASSERT_EQUALS_STRING(expected, handles[i].data, "every handle has its page");
+  }
+  CHECK(unpinPages(bm, handles, 3));
+
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_POOL("[2 1],[1 0],[16 0],[17 0]", bm, "a miss replaces a page of its own shard");
+  sprintf(h->data, "%s-%i", "Sharded", 2);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "the read I/Os of all shards are counted");
+
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the write I/Os of all shards are counted");
+  CHECK(shutdownBufferPool(bm));
+
+  // a scan reads ahead across the extents of all shards
+  options.numShards = 4;
+  options.readAheadPages = 8;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 64, RS_FIFO, NULL, &options));
+  for (i = 0; i < 64; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    if (i == 2)
+      sprintf(expected, "%s-%i", "Sharded", i);
+    else
+      sprintf(expected, "%s-%i", "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "reading back pages through a sharded pool");
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(64, getNumReadIO(bm), "every page is read once");
+  CHECK(prefetchPages(bm, 0, 64));
+  ASSERT_EQUALS_INT(64, getNumReadIO(bm), "resident pages are skipped in every shard");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// with numaPlacement the frames of every shard are bound to a NUMA node and pages go to shards of
+// the node of the thread that uses them first, the pool works as any sharded pool otherwise
+void testNumaPlacement(void)
+{
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  char expected[64];
+  testName = "Testing NUMA placement of shards";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 64);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+  ASSERT_EQUALS_INT(-1, getPageNode(bm, 0), "the frames are not bound without the option");
+  CHECK(shutdownBufferPool(bm));
+
+  options.numaPlacement = TRUE;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options));
+  ASSERT_EQUALS_INT(-1, getPageNode(bm, 0), "a pool with one shard is not placed");
+  CHECK(shutdownBufferPool(bm));
+
+  options.numShards = 4;
+  options.readAheadPages = 4;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_LRU, NULL, &options));
+  ASSERT_EQUALS_INT(-1, getPageNode(bm, 0), "asking for the node does not place an extent");
+  for (i = 0; i < 64; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "reading pages through a placed pool");
+    sprintf(h->data, "%s-%i", "Placed", i);
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    ASSERT_TRUE(getPageNode(bm, i) >= 0, "the frames of every shard are bound to a node");
+  }
+  ASSERT_TRUE(getNumCrossNodePins(bm) <= 64, "cross node pins are counted once per pin");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+  for (i = 0; i < 64; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", "Placed", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "the pages of all shards were written back");
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_INT(0, getNumCrossNodePins(bm), "pins are not counted without the option");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// returns the number of latencies recorded in a histogram
+static long long histogramCount(const BM_Histogram *histogram)
+{
+  long long count = 0;
+  int i;
+
+  for (i = 0; i < BM_HISTOGRAM_BUCKETS; i++)
+    count += histogram->counts[i];
+  return count;
+}
+
+void testPoolStats(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  BM_PoolStats stats;
+  int i;
+  testName = "Testing the pool statistics";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 16);
+
+  // three misses fill the pool, a hit, then the dirty page 0 is the FIFO victim of page 3
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 3; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(pinPage(bm, h, 0));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int)stats.hits, "one pin found its page");
+  ASSERT_EQUALS_INT(4, (int)stats.misses, "four pins read their page");
+  ASSERT_EQUALS_INT(1, (int)stats.evictions, "page 3 replaced page 0");
+  ASSERT_EQUALS_INT(1, (int)stats.dirtyEvictions, "page 0 was written back first");
+  ASSERT_EQUALS_INT(4, (int)stats.readIO, "reads as getNumReadIO");
+  ASSERT_EQUALS_INT(1, (int)stats.writeIO, "writes as getNumWriteIO");
+  ASSERT_EQUALS_INT(4, (int)histogramCount(&stats.readLatency), "every read call is timed");
+  ASSERT_EQUALS_INT(1, (int)histogramCount(&stats.writeLatency), "every write call is timed");
+  ASSERT_EQUALS_INT(0, (int)histogramCount(&stats.pinLatency), "pins are not timed without the option");
+  ASSERT_TRUE(stats.ioStallNanos > 0, "the misses waited for their reads");
+  ASSERT_EQUALS_INT(RC_INVALID_INPUT, getPoolStats(bm, NULL), "the snapshot needs somewhere to go");
+
+  // only the first pin of a prefetched page is a prefetch hit
+  CHECK(prefetchPages(bm, 8, 2));
+  for (i = 0; i < 2; i++)
+  {
+    CHECK(pinPage(bm, h, 8));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(3, (int)stats.hits, "the prefetched page was found twice");
+  ASSERT_EQUALS_INT(1, (int)stats.prefetchHits, "the first pin of the prefetched page");
+  ASSERT_EQUALS_INT(3, (int)stats.evictions, "the prefetch replaced two pages");
+  CHECK(shutdownBufferPool(bm));
+
+  // every pin is timed with the option, the statistics of a new pool start from 0
+  options.timePins = TRUE;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_LRU, NULL, &options));
+  for (i = 0; i < 16; i++)
+  {
+    CHECK(pinPage(bm, h, i % 8));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(16, (int)histogramCount(&stats.pinLatency), "every pin is timed");
+  ASSERT_EQUALS_INT(16, (int)(stats.hits + stats.misses), "every pin is a hit or a miss");
+  ASSERT_EQUALS_INT(12, (int)stats.evictions, "LRU replaces a page on all but the first four misses");
+  ASSERT_TRUE(histogramPercentile(&stats.pinLatency, 0.5) > 0, "the median pin took some time");
+  ASSERT_TRUE(histogramPercentile(&stats.pinLatency, 0.5) <= histogramPercentile(&stats.pinLatency, 1.0),
+              "percentiles grow with the quantile");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// record the pins, unpins and dirty marks of a pool and read the trace file back
+void testTraceFile(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle handles[2];
+  PageNumber pageNums[2] = {4, 5};
+  BM_PoolOptions options = {0};
+  BM_TraceHeader header;
+  BM_TraceRecord records[16];
+  int expectedPages[] = {0, 0, 0, 1, 1, 4, 5, 4, 5};
+  int expectedOps[] = {BM_TRACE_PIN, BM_TRACE_DIRTY, BM_TRACE_UNPIN, BM_TRACE_PIN, BM_TRACE_UNPIN,
+                       BM_TRACE_PIN, BM_TRACE_PIN, BM_TRACE_UNPIN, BM_TRACE_UNPIN};
+  FILE *file;
+  size_t count;
+  int i;
+  testName = "Testing the trace file";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 8);
+
+  options.traceFile = "testbuffer_trace.bin";
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+  CHECK(pinPage(bm, h, 0));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPageReadOnly(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPages(bm, handles, pageNums, 2));
+  CHECK(unpinPages(bm, handles, 2));
+  CHECK(shutdownBufferPool(bm));
+
+  file = fopen("testbuffer_trace.bin", "rb");
+  ASSERT_TRUE(file != NULL, "the trace file was created");
+  count = fread(&header, sizeof(header), 1, file);
+  ASSERT_EQUALS_INT(1, (int)count, "the trace starts with a header");
+  ASSERT_TRUE(memcmp(header.magic, BM_TRACE_MAGIC, sizeof(header.magic)) == 0, "the header names the format");
+  ASSERT_EQUALS_INT((int)sizeof(BM_TraceRecord), (int)header.recordSize, "the header has the record size");
+  ASSERT_EQUALS_INT(3, (int)header.numFrames, "the header has the frames of the pool");
+  count = fread(records, sizeof(BM_TraceRecord), 16, file);
+  ASSERT_EQUALS_INT(9, (int)count, "one record per operation");
+  fclose(file);
+
+  for (i = 0; i < 9; i++)
+  {
+    ASSERT_EQUALS_INT(expectedPages[i], records[i].pageNum, "the page of the operation");
+    ASSERT_EQUALS_INT(expectedOps[i], records[i].op, "the kind of the operation");
+    ASSERT_EQUALS_INT(records[0].thread, records[i].thread, "all records come from this thread");
+    ASSERT_TRUE(i == 0 || records[i].nanos >= records[i - 1].nanos, "the records are in the order of their times");
+  }
+
+  // a trace file that cannot be created fails the pool
+  options.traceFile = "testbuffer_missing/trace.bin";
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options), "the trace file cannot be created");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer_trace.bin");
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// save the resident pages of a pool and load the hottest of them back into the next one
+void testHotSet(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  BM_PoolStats stats;
+  PageNumber *frames;
+  FILE *file;
+  int uses[] = {3, 1, 4, 1};
+  int i, j;
+  testName = "Testing the hot set";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 8);
+  remove("testbuffer_hot.bin");
+
+  // without a hot set file the pool starts cold
+  options.hotSetFile = "testbuffer_hot.bin";
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_LRU, NULL, &options));
+  ASSERT_EQUALS_INT(0, getNumReadIO(bm), "there is no hot set yet");
+  for (i = 0; i < 4; i++)
+  {
+    for (j = 0; j < uses[i]; j++)
+    {
+      CHECK(pinPage(bm, h, 2 * i));
+      CHECK(unpinPage(bm, h));
+    }
+  }
+  CHECK(saveHotSet(bm));
+  CHECK(shutdownBufferPool(bm));
+  ASSERT_EQUALS_INT(RC_INVALID_INPUT, saveHotSet(bm), "a pool that is shut down has no hot set");
+
+  // the two pages used most fit into the smaller pool, read with one call sorted by page number
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_LRU, NULL, &options));
+  frames = getFrameContents(bm);
+  ASSERT_EQUALS_INT(0, frames[0], "page 0 was pinned three times");
+  ASSERT_EQUALS_INT(4, frames[1], "page 4 was pinned four times");
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int)stats.readIO, "only the hot pages were read");
+  ASSERT_EQUALS_INT(1, (int)histogramCount(&stats.readLatency), "both runs were read together");
+  CHECK(pinPage(bm, h, 4));
+  ASSERT_EQUALS_STRING("Page-4", h->data, "the loaded page has its content");
+  CHECK(unpinPage(bm, h));
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int)stats.hits, "the pin found the loaded page");
+  ASSERT_EQUALS_INT(1, (int)stats.prefetchHits, "loaded pages count as prefetched");
+  CHECK(shutdownBufferPool(bm));
+
+  // the uses are carried over, so the same pages come back again
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+  ASSERT_EQUALS_POOL("[0 0],[4 0]", bm, "the hot set survives a restart without pins");
+  CHECK(shutdownBufferPool(bm));
+
+  // a file that is not a hot set is never overwritten
+  file = fopen("testbuffer_hot.bin", "wb");
+  fputs("not a hot set", file);
+  fclose(file);
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options), "the file is no hot set");
+  options.hotSetFile = "testbuffer.bin";
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options), "the page file is no hot set");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer_hot.bin");
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// shrink a pool that is in use and grow it back, the frames it gives up are written back and emptied
+void testResize(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle pinned;
+  BM_PageHandle handles[6];
+  PageNumber pages[] = {0, 1, 2, 3, 4, 5};
+  BM_PoolOptions options = {0};
+  ReplacementStrategy strategy;
+  char expected[64];
+  int i;
+  testName = "Testing online resize";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 8);
+
+  options.maxPages = 2;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options), "maxPages is below the size");
+  options.maxPages = 8;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 4, RS_FIFO, NULL, &options));
+  ASSERT_ERROR(resizeBufferPool(bm, 0), "a pool needs a frame");
+  ASSERT_ERROR(resizeBufferPool(bm, 9), "a pool cannot grow past maxPages");
+
+  for (i = 0; i < 4; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    if (i == 3)
+    {
+      sprintf(h->data, "%s-%i", "Resized", i);
+      CHECK(markDirty(bm, h));
+    }
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(pinPage(bm, &pinned, 0));
+
+  // the frames given up are the last ones, their dirty page is written back first
+  CHECK(resizeBufferPool(bm, 2));
+  ASSERT_EQUALS_INT(2, bm->numPages, "the pool has two frames");
+  ASSERT_EQUALS_POOL("[0 1],[1 0]", bm, "the pages of the last frames are gone");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty page was written back");
+
+  // a pinned page keeps its frame
+  CHECK(pinPage(bm, h, 1));
+  ASSERT_EQUALS_INT(RC_BM_NO_FREE_FRAME, resizeBufferPool(bm, 1), "a pinned frame is not given up");
+  ASSERT_EQUALS_POOL("[0 1],[1 1]", bm, "a failed resize leaves the pool alone");
+  CHECK(unpinPage(bm, h));
+
+  // the smaller pool replaces its own pages
+  CHECK(pinPage(bm, h, 4));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[0 1],[4 0]", bm, "a miss replaces the unpinned page");
+
+  // growing adds empty frames that are filled before any page is replaced
+  CHECK(resizeBufferPool(bm, 4));
+  ASSERT_EQUALS_POOL("[0 1],[4 0],[-1 0],[-1 0]", bm, "the new frames are empty");
+  for (i = 2; i < 4; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    sprintf(expected, "%s-%i", i == 3 ? "Resized" : "Page", i);
+    ASSERT_EQUALS_STRING(expected, h->data, "reading pages into the new frames");
+    CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 1],[4 0],[2 0],[3 0]", bm, "the new frames were used first");
+  CHECK(unpinPage(bm, &pinned));
+  CHECK(shutdownBufferPool(bm));
+
+  // every policy gets along with frames coming and going
+  for (strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+  {
+    options.maxPages = 6;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, strategy, NULL, &options));
+    CHECK(resizeBufferPool(bm, 6));
+    CHECK(pinPages(bm, handles, pages, 6));
+    CHECK(unpinPages(bm, handles, 6));
+    CHECK(resizeBufferPool(bm, 3));
+    for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", i == 3 ? "Resized" : "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading pages through the smaller pool");
+      CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(3, bm->numPages, "the pool kept its new size");
+    CHECK(shutdownBufferPool(bm));
+  }
+
+  // the frames are split over the shards as when the pool is created
+  options.numShards = 2;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+  ASSERT_ERROR(resizeBufferPool(bm, 1), "every shard keeps a frame");
+  CHECK(resizeBufferPool(bm, 5));
+  CHECK(pinPages(bm, handles, pages, 3));
+  CHECK(unpinPages(bm, handles, 3));
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[-1 0],[-1 0]", bm, "the first shard got three frames");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// two page files share the frames of one pool, pages of the same number stay apart
+void testSharedFiles(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_BufferPool *other = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle pinned;
+  BM_PoolOptions options = {0};
+  ReplacementStrategy strategy;
+  char expected[64];
+  int i;
+  testName = "Testing page files sharing a pool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 4);
+  CHECK(createPageFile("testbuffer2.bin"));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  ASSERT_ERROR(openPoolFile(other, bm, "testbuffer2.bin"), "a pool holds one file without maxFiles");
+  CHECK(shutdownBufferPool(bm));
+
+  options.maxFiles = 2;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+  ASSERT_ERROR(openPoolFile(other, bm, "testbuffer.bin"), "a file is opened once per pool");
+  CHECK(openPoolFile(other, bm, "testbuffer2.bin"));
+  ASSERT_EQUALS_INT(1, other->fileId, "the file got the next slot");
+
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  for (i = 0; i < 2; i++)
+  {
+    CHECK(pinPage(other, h, i));
+    sprintf(h->data, "%s-%i", "Other", i);
+    CHECK(markDirty(other, h));
+    CHECK(unpinPage(other, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[0x0],[1x0]", bm, "the frames hold the pages of both files");
+
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "page 0 of the first file is not that of the second");
+  CHECK(unpinPage(bm, h));
+
+  // a flush only writes the pages of its own file
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "the first file had no dirty page");
+  CHECK(forceFlushPool(other));
+  ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "the pages of the second file were written");
+  ASSERT_EQUALS_POOL("[0 0],[0 0],[1 0]", bm, "the flush left the pages resident");
+
+  ASSERT_ERROR(shutdownBufferPool(bm), "the pool outlives the files opened in it");
+
+  // closing a file evicts its pages, a pinned one keeps it open
+  CHECK(pinPage(other, &pinned, 0));
+  ASSERT_EQUALS_INT(RC_BM_NO_FREE_FRAME, shutdownBufferPool(other), "a pinned page keeps its file open");
+  CHECK(unpinPage(other, &pinned));
+  CHECK(shutdownBufferPool(other));
+  ASSERT_EQUALS_POOL("[0 0],[-1 0],[-1 0]", bm, "the frames of the closed file are empty");
+
+  // the slot is reused and the pages were written to the file
+  CHECK(openPoolFile(other, bm, "testbuffer2.bin"));
+  ASSERT_EQUALS_INT(1, other->fileId, "the slot of the closed file is reused");
+  CHECK(pinPage(other, h, 1));
+  ASSERT_EQUALS_STRING("Other-1", h->data, "reading back the page of the second file");
+  CHECK(unpinPage(other, h));
+
+  // a resize through one handle changes the size every handle of the pool reports
+  CHECK(resizeBufferPool(bm, 2));
+  ASSERT_EQUALS_INT(2, other->numPages, "the other handle sees the pool shrink");
+  ASSERT_EQUALS_POOL("[1 0],[-1 0]", other, "the other handle walks the frames that are left");
+  CHECK(resizeBufferPool(other, 3));
+  ASSERT_EQUALS_INT(3, bm->numPages, "the first handle sees the pool grow");
+  ASSERT_EQUALS_POOL("[1 0],[-1 0],[-1 0]", bm, "the first handle walks the new frame");
+  CHECK(shutdownBufferPool(other));
+  CHECK(shutdownBufferPool(bm));
+
+  // every policy replaces the pages of both files
+  for (strategy = RS_FIFO; strategy <= RS_2Q; strategy++)
+  {
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, strategy, NULL, &options));
+    CHECK(openPoolFile(other, bm, "testbuffer2.bin"));
+    for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, i % 4));
+      sprintf(expected, "%s-%i", "Page", i % 4);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading the first file through the shared pool");
+      CHECK(unpinPage(bm, h));
+      CHECK(pinPage(other, h, i % 2));
+      sprintf(expected, "%s-%i", "Other", i % 2);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading the second file through the shared pool");
+      CHECK(unpinPage(other, h));
+    }
+    CHECK(shutdownBufferPool(other));
+    CHECK(shutdownBufferPool(bm));
+  }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(bm);
+  free(other);
+  free(h);
+  TEST_DONE();
+}
+
+// clean pages evicted from the frames are kept compressed and decompressed on their next miss
+void testCompressedTier(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_BufferPool *other = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  BM_PoolStats stats;
+  char noise[PAGE_SIZE];
+  unsigned seed = 1;
+  int i;
+  testName = "Testing the compressed tier";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(createPageFile("testbuffer2.bin"));
+
+  options.compressedTierPages = -1;
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options),
+               "the tier cannot have a negative size");
+
+  options.compressedTierPages = 2;
+  options.maxFiles = 2;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+  for (i = 0; i < 6; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(3, (int)stats.compressedStores, "the three evicted pages were compressed");
+  ASSERT_EQUALS_INT(3, (int)stats.compressedPages, "and are held by the tier");
+  ASSERT_EQUALS_INT(2 * PAGE_SIZE, (int)stats.compressedCapacity, "the tier has the size of two pages");
+  ASSERT_TRUE(stats.compressionRatio > 3, "the mostly empty pages compress well");
+
+  // a miss of a page of the tier reads nothing
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "page 0 comes back from the tier");
+  CHECK(unpinPage(bm, h));
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int)stats.compressedHits, "the miss was served by the tier");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "without reading the page file");
+  ASSERT_EQUALS_POOL("[0 0],[4 0],[5 0]", bm, "page 0 replaced page 3");
+
+  // a dirty page is compressed once it was written back, so the tier holds its new content
+  CHECK(pinPage(bm, h, 4));
+  sprintf(h->data, "%s-%i", "Changed", 4);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty victim was written back");
+  CHECK(pinPage(bm, h, 4));
+  ASSERT_EQUALS_STRING("Changed-4", h->data, "the tier holds the page as it was written");
+  CHECK(unpinPage(bm, h));
+
+  // read ahead and prefetches take their pages from the tier as well
+  CHECK(prefetchPages(bm, 2, 2));
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_STRING("Page-3", h->data, "page 3 was prefetched from the tier");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "no page of the tier was read again");
+
+  // a page that does not compress is left to the page file
+  CHECK(pinPage(bm, h, 6));
+  for (i = 0; i < PAGE_SIZE; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    noise[i] = (char)(seed >> 16);
+  }
+  memcpy(h->data, noise, PAGE_SIZE);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(forceFlushPool(bm));
+  for (i = 7; i < 10; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int)stats.compressedRejects, "the page of noise was not kept");
+  CHECK(pinPage(bm, h, 6));
+  ASSERT_TRUE(memcmp(noise, h->data, PAGE_SIZE) == 0, "the page of noise is read from the page file");
+  CHECK(unpinPage(bm, h));
+
+  // the pages of a closed file are dropped, the next file in its slot does not find them
+  CHECK(openPoolFile(other, bm, "testbuffer2.bin"));
+  for (i = 0; i < 4; i++)
+  {
+    CHECK(pinPage(other, h, i));
+    sprintf(h->data, "%s-%i", "Other", i);
+    CHECK(markDirty(other, h));
+    CHECK(unpinPage(other, h));
+  }
+  CHECK(shutdownBufferPool(other));
+  CHECK(createPageFile("testbuffer3.bin"));
+  CHECK(openPoolFile(other, bm, "testbuffer3.bin"));
+  ASSERT_EQUALS_INT(1, other->fileId, "the new file took the slot of the closed one");
+  CHECK(pinPage(other, h, 0));
+  ASSERT_EQUALS_INT(0, (int)strlen(h->data), "page 0 of the new file is empty");
+  CHECK(unpinPage(other, h));
+  CHECK(shutdownBufferPool(other));
+  CHECK(shutdownBufferPool(bm));
+
+  // the pages a shrink evicts go to the tier as well
+  options.maxFiles = 0;
+  options.maxPages = 3;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+  for (i = 0; i < 3; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(resizeBufferPool(bm, 1));
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int)stats.compressedStores, "the pages of the frames given up were compressed");
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_STRING("Page-2", h->data, "page 2 comes back from the tier");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "without reading the page file");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+  CHECK(destroyPageFile("testbuffer3.bin"));
+
+  free(bm);
+  free(other);
+  free(h);
+  TEST_DONE();
+}
+
+// test mapping the frames from huge pages, locking and prefaulting them, whatever backing the system gives
+void testFramePages(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = {0};
+  BM_PoolStats stats;
+  long long memPageSize = sysconf(_SC_PAGESIZE);
+  long long hugeSize;
+  int i;
+  testName = "Testing huge page, locked and prefaulted frames";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  options.framePages = (BM_FramePages)(BM_FRAME_PAGES_HUGE_1GB + 1);
+  ASSERT_ERROR(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options),
+               "unknown kinds of pages are rejected");
+
+  // without options the frames are in normal pages and not locked
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(BM_FRAME_PAGES_DEFAULT, stats.framePages, "normal pages by default");
+  ASSERT_TRUE(!stats.framesLocked, "frames are not locked by default");
+  ASSERT_TRUE(stats.frameBytes >= 3 * PAGE_SIZE && stats.frameBytes % memPageSize == 0,
+              "the frames are mapped in whole memory pages");
+  CHECK(shutdownBufferPool(bm));
+
+  // the largest pages fall back to whatever the system has, the size of the mapping tells which
+  options.framePages = BM_FRAME_PAGES_HUGE_1GB;
+  options.lockFrames = TRUE;
+  options.prefaultFrames = TRUE;
+  options.maxPages = 6;
+  options.numShards = 2;
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_CLOCK, NULL, &options));
+  CHECK(getPoolStats(bm, &stats));
+  if (stats.framePages == BM_FRAME_PAGES_HUGE_1GB)
+    hugeSize = 1LL << 30;
+  else if (stats.framePages != BM_FRAME_PAGES_DEFAULT)
+    hugeSize = 1LL << 21;
+  else
+    hugeSize = memPageSize;
+  ASSERT_TRUE(stats.frameBytes >= 6 * PAGE_SIZE && stats.frameBytes % hugeSize == 0,
+              "every shard maps its frames in whole pages of the backing it got");
+
+  // the pool works the same on any backing, also after growing into the frames kept for resizing
+  for (i = 0; i < 3; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    sprintf(h->data, "%s-%i", "Changed", i);
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(resizeBufferPool(bm, 6));
+  for (i = 3; i < 9; i++)
+  {
+    CHECK(pinPage(bm, h, i));
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(resizeBufferPool(bm, 2));
+  for (i = 0; i < 3; i++)
+  {
+    char expected[PAGE_SIZE];
+    sprintf(expected, "%s-%i", "Changed", i);
+    CHECK(pinPage(bm, h, i));
+    ASSERT_EQUALS_STRING(expected, h->data, "the changed pages were written back and read again");
+    CHECK(unpinPage(bm, h));
+  }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
@@ -37,6 +37,7 @@ static void checkDummyPages(BM_BufferPool *bm, int num);
 static void testReadPage(void);
 
 static void testCLOCK(void);
+static void testCLOCKBlocks(void);
 
 // main method
 int main()
@@ -47,6 +48,7 @@ int main()
     testCreatingAndReadingDummyPages();
     testReadPage();
     testCLOCK();
+    testCLOCKBlocks();
 
     return 0;
 }
@@ -199,4 +201,68 @@ void testCLOCK(void)
     free(bm);
     free(h);
     TEST_DONE();
-}
\ No newline at end of file
+}
+
+// test CLOCK and forceFlushPool on a pool whose frames span several blocks of the scan kernels
+void testCLOCKBlocks(void)
+{
+    const PageNumber unpinned[] = {5, 70, 140, 149};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = (BM_PageHandle *)calloc(150, sizeof(BM_PageHandle));
+    BM_PageHandle *extra = MAKE_PAGE_HANDLE();
+    int i;
+    testName = "Testing CLOCK over several scan blocks";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 300);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 150, RS_CLOCK, NULL));
+
+    // fill the pool, pages 49, 99 and 149 dirty, and release four frames of different blocks
+    for (i = 0; i < 150; i++)
+    {
+        CHECK(pinPage(bm, &h[i], i));
+        if (i % 50 == 49)
+        {
+            CHECK(markDirty(bm, &h[i]));
+        }
+    }
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(unpinPage(bm, &h[unpinned[i]]));
+    }
+
+    // only the dirty page nobody is using is written
+    CHECK(forceFlushPool(bm));
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "only the unpinned dirty page is written");
+    bool *dirty = getDirtyFlags(bm);
+    ASSERT_TRUE(dirty[49] && dirty[99] && !dirty[149], "pinned dirty pages stay dirty");
+
+    // the first round of the hand clears the reference bits, the second replaces the released frames in order
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, extra, 200 + i));
+        ASSERT_EQUALS_INT(200 + i, getFrameContents(bm)[unpinned[i]], "released frame is replaced in order");
+    }
+    ASSERT_EQUALS_INT(RC_BM_NO_FREE_FRAME, pinPage(bm, extra, 250), "no frame left once all are pinned");
+    ASSERT_EQUALS_INT(154, getNumReadIO(bm), "check number of read I/Os");
+
+    for (i = 0; i < 4; i++)
+    {
+        extra->pageNum = 200 + i;
+        CHECK(unpinPage(bm, extra));
+    }
+    for (i = 0; i < 150; i++)
+    {
+        if (i != 5 && i != 70 && i != 140 && i != 149)
+        {
+            CHECK(unpinPage(bm, &h[i]));
+        }
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    free(extra);
+    TEST_DONE();
+}
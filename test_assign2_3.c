@@ -0,0 +1,837 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+#define NUM_THREADS 4
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+static void checkDummyPages(BM_BufferPool *bm, int num);
+
+static void testConcurrentHits(void);
+static void testConcurrentReplacement(void);
+static void testBackgroundFlush(void);
+static void testConcurrentPinPages(void);
+static void testOptimisticHits(void);
+static void testConcurrentShards(void);
+static void testLatchProfile(void);
+static void testWarmInBackground(void);
+static void testConcurrentResize(void);
+static void testConcurrentSharedFiles(void);
+static void testConcurrentCompressedTier(void);
+
+// work shared by the threads of a test
+typedef struct ThreadWork
+{
+    BM_BufferPool *bm;
+    int id;
+    int numPages;
+    int rounds;
+    bool writePages;
+    int errors;
+} ThreadWork;
+
+// main method
+int main()
+{
+    initStorageManager();
+    testName = "";
+
+    testConcurrentHits();
+    testConcurrentReplacement();
+    testBackgroundFlush();
+    testConcurrentPinPages();
+    testOptimisticHits();
+    testConcurrentShards();
+    testLatchProfile();
+    testWarmInBackground();
+    testConcurrentResize();
+    testConcurrentSharedFiles();
+    testConcurrentCompressedTier();
+
+    return 0;
+}
+
+void createDummyPages(BM_BufferPool *bm, int num)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(shutdownBufferPool(bm));
+
+    free(h);
+}
+
+void checkDummyPages(BM_BufferPool *bm, int num)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char *expected = malloc(sizeof(char) * 512);
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+
+        sprintf(expected, "%s-%i", "Page", h->pageNum);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back dummy page content");
+
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(shutdownBufferPool(bm));
+
+    free(expected);
+    free(h);
+}
+
+// pins pages in a thread specific order, checks their content and optionally rewrites them
+static void *pinPagesWorker(void *arg)
+{
+    ThreadWork *work = (ThreadWork *)arg;
+    BM_PageHandle h;
+    char expected[64];
+    int r, i;
+
+    for (r = 0; r < work->rounds; r++)
+    {
+        for (i = 0; i < work->numPages; i++)
+        {
+            int pageNum = (i * (2 * work->id + 1) + r) % work->numPages;
+
+            if (pinPage(work->bm, &h, pageNum) != RC_OK)
+            {
+                work->errors++;
+                continue;
+            }
+            sprintf(expected, "%s-%i", "Page", pageNum);
+            if (h.pageNum != pageNum || strcmp(expected, h.data) != 0)
+            {
+                work->errors++;
+            }
+            if (work->writePages)
+            {
+                sprintf(h.data, "%s-%i", "Page", pageNum);
+                markDirty(work->bm, &h);
+            }
+            unpinPage(work->bm, &h);
+        }
+    }
+    return NULL;
+}
+
+// runs pinPagesWorker on NUM_THREADS threads and returns the number of errors they saw
+static int runWorkers(BM_BufferPool *bm, int numPages, int rounds, bool writePages)
+{
+    pthread_t threads[NUM_THREADS];
+    ThreadWork work[NUM_THREADS];
+    int i, errors = 0;
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        work[i].bm = bm;
+        work[i].id = i;
+        work[i].numPages = numPages;
+        work[i].rounds = rounds;
+        work[i].writePages = writePages;
+        work[i].errors = 0;
+        pthread_create(&threads[i], NULL, pinPagesWorker, &work[i]);
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += work[i].errors;
+    }
+    return errors;
+}
+
+// several threads pin the same pages of a pool large enough to hold all of them,
+// every page must be read from disk exactly once
+void testConcurrentHits(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    int *fixCounts;
+    int i;
+    testName = "Testing concurrent pinning of shared pages";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 50);
+
+    // the first thread scans the pages in order, so read ahead runs next to the other pins
+    options.concurrent = TRUE;
+    options.readAheadPages = 8;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 64, RS_CLOCK, NULL, &options));
+
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 50, 20, FALSE), "all threads read the right page content");
+    ASSERT_EQUALS_INT(50, getNumReadIO(bm), "each page is read only once");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+
+    fixCounts = getFixCounts(bm);
+    for (i = 0; i < bm->numPages; i++)
+    {
+        ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+    }
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// several threads pin and modify more pages than the pool holds, so dirty pages are
+// replaced and written back while other threads keep pinning
+void testConcurrentReplacement(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    int s;
+    testName = "Testing concurrent page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+
+    options.concurrent = TRUE;
+    for (s = 0; s < 7; s++)
+    {
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, strategies[s], NULL, &options));
+        ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+        ASSERT_TRUE(getNumReadIO(bm) >= 100, "pages are replaced while threads pin them");
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    // reads and writes of the direct backend run without the file latch
+    options.storageBackend = SM_BACKEND_DIRECT;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_LRU, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+    CHECK(shutdownBufferPool(bm));
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// returns the number of dirty frames of the pool
+static int countDirtyFrames(BM_BufferPool *bm)
+{
+    bool *dirtyFlags = getDirtyFlags(bm);
+    int i, count = 0;
+
+    for (i = 0; i < bm->numPages; i++)
+    {
+        if (dirtyFlags[i])
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// the page cleaner writes dirty pages back once a fifth of the pool is dirty, so replacing
+// pages later finds them clean, and flushing still leaves everything on disk
+void testBackgroundFlush(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options = {0};
+    int i, waited;
+    testName = "Testing the background page cleaner";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20);
+
+    options.backgroundFlush = TRUE;
+    options.dirtyRatio = 0.2;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_LRU, NULL, &options));
+
+    for (i = 0; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+
+    // the cleaner writes until at most half of the threshold of 2 pages is dirty
+    for (waited = 0; waited < 2000 && countDirtyFrames(bm) > 1; waited++)
+    {
+        usleep(1000);
+    }
+    ASSERT_TRUE(countDirtyFrames(bm) <= 1, "the page cleaner wrote the dirty pages");
+    ASSERT_TRUE(getNumWriteIO(bm) >= 9, "the writes happened in the background");
+
+    // pages pinned by the user are left alone
+    CHECK(pinPage(bm, h, 0));
+    CHECK(markDirty(bm, h));
+    CHECK(pinPage(bm, h, 1));
+    CHECK(markDirty(bm, h));
+    usleep(50000);
+    ASSERT_TRUE(getDirtyFlags(bm)[0] && getDirtyFlags(bm)[1], "pinned pages are not written");
+    h->pageNum = 0;
+    CHECK(unpinPage(bm, h));
+    h->pageNum = 1;
+    CHECK(unpinPage(bm, h));
+
+    // replace the pages while the cleaner may still be writing some of them
+    for (i = 10; i < 20; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(forceFlushPool(bm));
+    ASSERT_EQUALS_INT(0, countDirtyFrames(bm), "no page is dirty after a flush");
+    CHECK(shutdownBufferPool(bm));
+
+    checkDummyPages(bm, 20);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+#define PIN_BATCH 4
+
+// pins batches of pages with pinPages, checks their content and unpins them with unpinPages
+static void *pinBatchesWorker(void *arg)
+{
+    ThreadWork *work = (ThreadWork *)arg;
+    BM_PageHandle handles[PIN_BATCH];
+    PageNumber pages[PIN_BATCH];
+    char expected[64];
+    int r, i, j;
+
+    for (r = 0; r < work->rounds; r++)
+    {
+        for (i = 0; i < work->numPages; i += PIN_BATCH)
+        {
+            for (j = 0; j < PIN_BATCH; j++)
+            {
+                pages[j] = ((i + j) * (2 * work->id + 1) + r) % work->numPages;
+            }
+            if (pinPages(work->bm, handles, pages, PIN_BATCH) != RC_OK)
+            {
+                work->errors++;
+                continue;
+            }
+            for (j = 0; j < PIN_BATCH; j++)
+            {
+                sprintf(expected, "%s-%i", "Page", pages[j]);
+                if (handles[j].pageNum != pages[j] || strcmp(expected, handles[j].data) != 0)
+                {
+                    work->errors++;
+                }
+            }
+            unpinPages(work->bm, handles, PIN_BATCH);
+        }
+    }
+    return NULL;
+}
+
+// several threads pin overlapping batches of pages in a pool smaller than the file
+void testConcurrentPinPages(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    pthread_t threads[NUM_THREADS];
+    ThreadWork work[NUM_THREADS];
+    int *fixCounts;
+    int i, errors = 0;
+    testName = "Testing concurrent pinPages";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 60);
+
+    // each thread holds at most PIN_BATCH pins, so the pool never runs out of frames
+    options.concurrent = TRUE;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", NUM_THREADS * PIN_BATCH + 4, RS_LRU, NULL, &options));
+
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        work[i].bm = bm;
+        work[i].id = i;
+        work[i].numPages = 60;
+        work[i].rounds = 5;
+        work[i].writePages = FALSE;
+        work[i].errors = 0;
+        pthread_create(&threads[i], NULL, pinBatchesWorker, &work[i]);
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += work[i].errors;
+    }
+    ASSERT_EQUALS_INT(0, errors, "all threads read the right page content");
+
+    fixCounts = getFixCounts(bm);
+    for (i = 0; i < bm->numPages; i++)
+    {
+        ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+    }
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// with optimistic hits threads pin resident pages without latches, while misses replace pages
+// next to them
+void testOptimisticHits(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    ReplacementStrategy strategies[] = {RS_FIFO, RS_CLOCK};
+    int *fixCounts;
+    int s, i;
+    testName = "Testing optimistic buffer hits";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+
+    options.optimisticHits = TRUE;
+    for (s = 0; s < 2; s++)
+    {
+        // all pages fit, so every page is read once however the hits race
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 64, strategies[s], NULL, &options));
+        ASSERT_EQUALS_INT(0, runWorkers(bm, 50, 20, FALSE), "all threads read the right page content");
+        ASSERT_EQUALS_INT(50, getNumReadIO(bm), "each page is read only once");
+        CHECK(shutdownBufferPool(bm));
+
+        // replacements change the pages of frames that optimistic pins are looking at
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, strategies[s], NULL, &options));
+        ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+        fixCounts = getFixCounts(bm);
+        for (i = 0; i < bm->numPages; i++)
+        {
+            ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+        }
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// threads pin pages of different shards of a sharded pool, each shard loading and replacing
+// its own pages, with the page cleaners of the shards writing next to them
+void testConcurrentShards(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    int *fixCounts;
+    int i;
+    testName = "Testing concurrent sharded pools";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 48);
+
+    // the pages cover three extents that go to three different shards, each of which holds its extent,
+    // with numaPlacement the threads place the extents while they pin
+    options.concurrent = TRUE;
+    options.numShards = 4;
+    options.readAheadPages = 8;
+    for (i = 0; i < 2; i++)
+    {
+        options.numaPlacement = i == 1;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 64, RS_CLOCK, NULL, &options));
+        ASSERT_EQUALS_INT(0, runWorkers(bm, 48, 20, FALSE), "all threads read the right page content");
+        ASSERT_EQUALS_INT(48, getNumReadIO(bm), "each page is read only once");
+        CHECK(shutdownBufferPool(bm));
+    }
+    options.numaPlacement = FALSE;
+
+    // every shard has more frames than there are threads, the shards replace and write back
+    // pages while the threads keep pinning
+    createDummyPages(bm, 100);
+    options.optimisticHits = TRUE;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 40, RS_FIFO, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+    ASSERT_TRUE(getNumReadIO(bm) >= 100, "pages are replaced while threads pin them");
+    fixCounts = getFixCounts(bm);
+    for (i = 0; i < bm->numPages; i++)
+    {
+        ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    // the page cleaner of every shard writes the pages the threads keep dirtying, the pins of
+    // a cleaning pass would starve the threads of victims in small shards, so all pages fit
+    options.backgroundFlush = TRUE;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 128, RS_FIFO, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+    ASSERT_EQUALS_INT(100, getNumReadIO(bm), "each page is read only once");
+    CHECK(shutdownBufferPool(bm));
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// checks that every kind of latch was taken at most as often as threads pinned pages and sums up consistently
+static void checkLatchStats(BM_LatchStats *stats)
+{
+    int kind;
+
+    for (kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+    {
+        ASSERT_TRUE(stats[kind].contended <= stats[kind].acquisitions, "only acquisitions can be contended");
+        ASSERT_TRUE(stats[kind].waitNanos >= 0 && stats[kind].holdNanos >= 0, "latch times are not negative");
+        ASSERT_TRUE(stats[kind].acquisitions > 0 || stats[kind].holdNanos == 0, "a latch never taken was not held");
+    }
+}
+
+void testLatchProfile(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    BM_LatchStats stats[BM_NUM_LATCH_KINDS];
+    int kind;
+    testName = "Testing the latch profile";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+
+    // without the option nothing is counted
+    options.concurrent = TRUE;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_LRU, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 2, FALSE), "all threads read the right page content");
+    CHECK(getLatchStats(bm, stats));
+    for (kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+    {
+        ASSERT_TRUE(stats[kind].acquisitions == 0 && stats[kind].holdNanos == 0, "latches are not profiled");
+    }
+    ASSERT_EQUALS_INT(RC_INVALID_INPUT, getLatchStats(bm, NULL), "the profile needs somewhere to go");
+    CHECK(shutdownBufferPool(bm));
+
+    // the hits of LRU take the replacement latch, the misses the exclusive page table latch and
+    // the frame latches, all of it summed over both shards
+    options.profileLatches = TRUE;
+    options.numShards = 2;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 20, RS_LRU, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+    CHECK(getLatchStats(bm, stats));
+    checkLatchStats(stats);
+    ASSERT_TRUE(stats[BM_LATCH_TABLE_SHARED].acquisitions > 0, "hits and unpins take the page table latch shared");
+    ASSERT_TRUE(stats[BM_LATCH_TABLE_SHARED].holdNanos > 0, "the shared page table latch was held");
+    ASSERT_TRUE(stats[BM_LATCH_TABLE_EXCLUSIVE].acquisitions >= getNumReadIO(bm) / 64,
+                "misses take the page table latch exclusive");
+    ASSERT_TRUE(stats[BM_LATCH_FRAME].acquisitions >= getNumReadIO(bm), "every read holds the frame latch");
+    ASSERT_TRUE(stats[BM_LATCH_REPLACEMENT].acquisitions > 0, "LRU hits take the replacement latch");
+
+    // a reset starts a new profile
+    CHECK(resetLatchStats(bm));
+    CHECK(getLatchStats(bm, stats));
+    for (kind = 0; kind < BM_NUM_LATCH_KINDS; kind++)
+    {
+        ASSERT_TRUE(stats[kind].acquisitions == 0 && stats[kind].waitNanos == 0, "the profile was reset");
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    // the mmap backend maps chunks of the file under the file latch
+    options.numShards = 0;
+    options.storageBackend = SM_BACKEND_MMAP;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_CLOCK, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 2, TRUE), "all threads read the right page content");
+    CHECK(getLatchStats(bm, stats));
+    checkLatchStats(stats);
+    ASSERT_TRUE(stats[BM_LATCH_FILE].acquisitions > 0, "reads of the mmap backend take the file latch");
+    ASSERT_TRUE(stats[BM_LATCH_REPLACEMENT].acquisitions == 0, "CLOCK hits take no replacement latch");
+    CHECK(shutdownBufferPool(bm));
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// threads pin pages while the hot set is loaded, checkpoints save it while the pool runs
+void testWarmInBackground(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    FILE *file;
+    testName = "Testing the hot set loaded in the background";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    remove("testbuffer_hot.bin");
+
+    options.concurrent = TRUE;
+    options.hotSetFile = "testbuffer_hot.bin";
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 50, RS_LRU, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 2, FALSE), "all threads read the right page content");
+    CHECK(shutdownBufferPool(bm));
+
+    // the workers race the warm thread for the free frames and the pages
+    options.warmInBackground = TRUE;
+    options.checkpointSeconds = 1;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 50, RS_LRU, NULL, &options));
+    ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 2, TRUE), "all threads read the right page content");
+    remove("testbuffer_hot.bin");
+    sleep(2);
+    file = fopen("testbuffer_hot.bin", "rb");
+    ASSERT_TRUE(file != NULL, "a checkpoint saved the hot set");
+    fclose(file);
+    CHECK(shutdownBufferPool(bm));
+
+    // a pool shut down while the hot set is still loading
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 50, RS_CLOCK, NULL, &options));
+    CHECK(shutdownBufferPool(bm));
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+    remove("testbuffer_hot.bin");
+
+    free(bm);
+    TEST_DONE();
+}
+
+// the pool shrinks and grows while threads pin, rewrite and replace its pages, with optimistic
+// hits and the page cleaner working next to the resizes
+void testConcurrentResize(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    ReplacementStrategy strategies[] = {RS_FIFO, RS_CLOCK, RS_LRU, RS_ARC};
+    int sizes[] = {8, 64, 16, 40};
+    pthread_t threads[NUM_THREADS];
+    ThreadWork work[NUM_THREADS];
+    int *fixCounts;
+    int s, i, errors, resized;
+    testName = "Testing resizes of a pool in use";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+
+    options.concurrent = TRUE;
+    options.maxPages = 64;
+    for (s = 0; s < 4; s++)
+    {
+        options.optimisticHits = strategies[s] == RS_FIFO || strategies[s] == RS_CLOCK;
+        options.backgroundFlush = s % 2 == 1;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 32, strategies[s], NULL, &options));
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            work[i].bm = bm;
+            work[i].id = i;
+            work[i].numPages = 100;
+            work[i].rounds = 10;
+            work[i].writePages = TRUE;
+            work[i].errors = 0;
+            pthread_create(&threads[i], NULL, pinPagesWorker, &work[i]);
+        }
+
+        // a shrink fails while a page it has to give up is pinned, the next one may succeed
+        resized = 0;
+        for (i = 0; i < 100; i++)
+        {
+            if (resizeBufferPool(bm, sizes[i % 4]) == RC_OK)
+            {
+                resized++;
+            }
+        }
+
+        errors = 0;
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+            errors += work[i].errors;
+        }
+        ASSERT_EQUALS_INT(0, errors, "all threads read the right page content");
+        ASSERT_TRUE(resized > 0, "the pool was resized while in use");
+
+        // the page cleaner pins the pages it is writing
+        fixCounts = getFixCounts(bm);
+        for (i = 0; i < bm->numPages && !options.backgroundFlush; i++)
+        {
+            ASSERT_EQUALS_INT(0, fixCounts[i], "no page is left pinned");
+        }
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// as pinPagesWorker, the threads with an odd id work on the second file, whose pages read Other-N
+static void *sharedFilesWorker(void *arg)
+{
+    ThreadWork *work = (ThreadWork *)arg;
+    const char *prefix = work->id % 2 == 0 ? "Page" : "Other";
+    BM_PageHandle h;
+    char expected[64];
+    int r, i;
+
+    for (r = 0; r < work->rounds; r++)
+    {
+        for (i = 0; i < work->numPages; i++)
+        {
+            int pageNum = (i * (2 * work->id + 1) + r) % work->numPages;
+
+            if (pinPage(work->bm, &h, pageNum) != RC_OK)
+            {
+                work->errors++;
+                continue;
+            }
+            sprintf(expected, "%s-%i", prefix, pageNum);
+            if (h.pageNum != pageNum || strcmp(expected, h.data) != 0)
+            {
+                work->errors++;
+            }
+            sprintf(h.data, "%s-%i", prefix, pageNum);
+            markDirty(work->bm, &h);
+            unpinPage(work->bm, &h);
+        }
+    }
+    return NULL;
+}
+
+// threads pin the pages of two files sharing a pool too small for either of them
+void testConcurrentSharedFiles(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_BufferPool *other = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options = {0};
+    ReplacementStrategy strategies[] = {RS_CLOCK, RS_ARC};
+    pthread_t threads[NUM_THREADS];
+    ThreadWork work[NUM_THREADS];
+    char expected[64];
+    int s, i, errors;
+    testName = "Testing page files sharing a pool in use";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 50);
+    CHECK(createPageFile("testbuffer2.bin"));
+    CHECK(initBufferPool(other, "testbuffer2.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 50; i++)
+    {
+        CHECK(pinPage(other, h, i));
+        sprintf(h->data, "%s-%i", "Other", i);
+        CHECK(markDirty(other, h));
+        CHECK(unpinPage(other, h));
+    }
+    CHECK(shutdownBufferPool(other));
+
+    options.concurrent = TRUE;
+    options.maxFiles = 2;
+    for (s = 0; s < 2; s++)
+    {
+        options.optimisticHits = strategies[s] == RS_CLOCK;
+        options.backgroundFlush = s == 1;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, strategies[s], NULL, &options));
+        CHECK(openPoolFile(other, bm, "testbuffer2.bin"));
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            work[i].bm = i % 2 == 0 ? bm : other;
+            work[i].id = i;
+            work[i].numPages = 50;
+            work[i].rounds = 10;
+            work[i].writePages = TRUE;
+            work[i].errors = 0;
+            pthread_create(&threads[i], NULL, sharedFilesWorker, &work[i]);
+        }
+        errors = 0;
+        for (i = 0; i < NUM_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+            errors += work[i].errors;
+        }
+        ASSERT_EQUALS_INT(0, errors, "all threads read the pages of their own file");
+        CHECK(shutdownBufferPool(other));
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    checkDummyPages(bm, 50);
+    CHECK(initBufferPool(other, "testbuffer2.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 50; i++)
+    {
+        CHECK(pinPage(other, h, i));
+        sprintf(expected, "%s-%i", "Other", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back the pages of the second file");
+        CHECK(unpinPage(other, h));
+    }
+    CHECK(shutdownBufferPool(other));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+
+    free(bm);
+    free(other);
+    free(h);
+    TEST_DONE();
+}
+
+// threads rewrite the pages of a pool much smaller than the file, whose misses are mostly served by
+// the compressed tier, with the page cleaner, shards and read ahead loading pages next to them
+void testConcurrentCompressedTier(void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options = {0};
+    BM_PoolStats stats;
+    ReplacementStrategy strategies[] = {RS_CLOCK, RS_LRU, RS_ARC};
+    int s;
+    testName = "Testing the compressed tier of a concurrent pool";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+
+    options.concurrent = TRUE;
+    options.compressedTierPages = 16;
+    for (s = 0; s < 3; s++)
+    {
+        options.optimisticHits = s == 0;
+        options.backgroundFlush = s == 1;
+        options.numShards = s == 1 ? 2 : 0;
+        options.readAheadPages = s == 2 ? 8 : 0;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, strategies[s], NULL, &options));
+        ASSERT_EQUALS_INT(0, runWorkers(bm, 100, 5, TRUE), "all threads read the right page content");
+        CHECK(getPoolStats(bm, &stats));
+        ASSERT_TRUE(stats.compressedHits > 0, "misses were served by the tier");
+        ASSERT_TRUE(stats.compressedPages <= 100, "the tier holds every page at most once");
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    checkDummyPages(bm, 100);
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
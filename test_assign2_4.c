@@ -0,0 +1,442 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "buffer_policy.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected, bm, message)                                                              \
+    do                                                                                                         \
+    {                                                                                                          \
+        char *real;                                                                                            \
+        char *_exp = (char *)(expected);                                                                       \
+        real = sprintPoolContent(bm);                                                                          \
+        if (strcmp((_exp), real) != 0)                                                                         \
+        {                                                                                                      \
+            printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n", TEST_INFO, _exp, real, message); \
+            free(real);                                                                                        \
+            exit(1);                                                                                           \
+        }                                                                                                      \
+        printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n", TEST_INFO, _exp, real, message);         \
+        free(real);                                                                                            \
+    } while (0)
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+
+static void testLFU(void);
+static void testLRUK(void);
+static void testLRUKCorrelatedReferences(void);
+static void testARC(void);
+static void test2Q(void);
+static void testCustomPolicy(void);
+static void testInvalidStrategy(void);
+
+// main method
+int main()
+{
+    initStorageManager();
+    testName = "";
+
+    testLFU();
+    testLRUK();
+    testLRUKCorrelatedReferences();
+    testARC();
+    test2Q();
+    testCustomPolicy();
+    testInvalidStrategy();
+
+    return 0;
+}
+
+void createDummyPages(BM_BufferPool *bm, int num)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+
+    CHECK(shutdownBufferPool(bm));
+
+    free(h);
+}
+
+// test the LFU page replacement strategy, ties on the use count are replaced LRU
+void testLFU(void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        // page 2 was used once, 0 three times and 1 twice
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[4 0]",
+        // page 4 has been used four times now, more than page 1
+        "[0 0],[5 0],[4 0]"};
+    const int orderRequests[] = {0, 1, 2, 0, 0, 1, 3, 4, 4, 4, 4, 5};
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LFU page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+
+    for (i = 0; i < 12; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content reading in pages");
+    }
+
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the LRU-2 page replacement strategy, pages seen once are replaced before pages seen twice
+void testLRUK(void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[3 0]",
+        // LRU would replace page 0 here, LRU-2 replaces the page that was only used once
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[4 0]",
+        // page 0 has the oldest second to last reference
+        "[5 0],[1 0],[4 0]",
+        "[0 0],[1 0],[4 0]",
+        // page 0 kept its history while it was not in the pool
+        "[0 0],[6 0],[4 0]"};
+    const int orderRequests[] = {0, 1, 2, 0, 1, 3, 4, 4, 5, 0, 6};
+
+    int i;
+    BM_LRUKParams params = {2, 0};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LRU-K page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &params));
+
+    for (i = 0; i < 11; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content reading in pages");
+    }
+
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a reference right after another one of the same page only counts with no correlated reference period
+void testLRUKCorrelatedReferences(void)
+{
+    const int orderRequests[] = {0, 0, 1, 2};
+
+    int i;
+    BM_LRUKParams params = {2, 0};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LRU-K correlated reference period";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+
+    // page 0 was referenced twice, page 1 only once
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &params));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "uncorrelated references keep page 0");
+    CHECK(shutdownBufferPool(bm));
+
+    // both references of page 0 fall into one correlated period, so it is older than page 1
+    params.correlatedReferencePeriod = 2;
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &params));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[2 0],[1 0]", bm, "correlated references count once");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the ARC page replacement strategy, a scan only replaces pages of T1 and ghost hits adapt the target
+void testARC(void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[2 0]",
+        // pages 0 and 1 are in T2, the scan over pages 3 to 5 keeps replacing T1
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[5 0]",
+        // page 3 is a hit in B1, the target of T1 grows to 1 and T2 gives up page 0
+        "[3 0],[1 0],[5 0]",
+        // page 0 is a hit in B2, the target shrinks back and T1 gives up page 5
+        "[3 0],[1 0],[0 0]"};
+    const int orderRequests[] = {0, 1, 2, 0, 1, 3, 4, 5, 3, 0};
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing ARC page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+
+    for (i = 0; i < 10; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content reading in pages");
+    }
+
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the 2Q page replacement strategy, only pages read again while in A1out make it into Am
+void test2Q(void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[2 0],[-1 0]",
+        "[0 0],[1 0],[2 0],[3 0]",
+        "[0 0],[1 0],[2 0],[3 0]",
+        // a hit in A1in does not count, page 0 is the oldest of A1in
+        "[4 0],[1 0],[2 0],[3 0]",
+        // page 0 is in A1out and is read into Am
+        "[4 0],[0 0],[2 0],[3 0]",
+        "[4 0],[0 0],[5 0],[3 0]",
+        "[4 0],[0 0],[5 0],[6 0]",
+        // page 1 fell out of A1out before it was read again
+        "[1 0],[0 0],[5 0],[6 0]",
+        "[1 0],[0 0],[3 0],[6 0]",
+        "[1 0],[0 0],[3 0],[6 0]",
+        // pages 0 and 3 in Am survive the scan
+        "[1 0],[0 0],[3 0],[7 0]"};
+    const int orderRequests[] = {0, 1, 2, 3, 0, 4, 0, 5, 6, 1, 3, 0, 7};
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing 2Q page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_2Q, NULL));
+
+    for (i = 0; i < 13; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content reading in pages");
+    }
+
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(11, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a most recently used policy registered by the test, it replaces the page used last
+typedef struct MRUState
+{
+    int numFrames;
+    int last;
+} MRUState;
+
+static RC mruInit(void **state, int numFrames, void *stratData)
+{
+    MRUState *mru = (MRUState *)malloc(sizeof(MRUState));
+    mru->numFrames = numFrames;
+    mru->last = NO_FRAME;
+    *state = mru;
+    return RC_OK;
+}
+
+static void mruShutdown(void *state)
+{
+    free(state);
+}
+
+static void mruOnHit(void *state, int frame)
+{
+    ((MRUState *)state)->last = frame;
+}
+
+static void mruOnInsert(void *state, int frame, PageNumber pageNum)
+{
+    ((MRUState *)state)->last = frame;
+}
+
+static int mruPickVictim(void *state, const int *fixCounts, PageNumber pageNum)
+{
+    MRUState *mru = (MRUState *)state;
+    int i;
+
+    if (mru->last != NO_FRAME && fixCounts[mru->last] == 0)
+    {
+        return mru->last;
+    }
+    for (i = 0; i < mru->numFrames; i++)
+    {
+        if (fixCounts[i] == 0)
+        {
+            return i;
+        }
+    }
+    return NO_FRAME;
+}
+
+static const BM_ReplacementPolicy mruPolicy = {
+    .name = "MRU",
+    .init = mruInit,
+    .shutdown = mruShutdown,
+    .onHit = mruOnHit,
+    .onInsert = mruOnInsert,
+    .pickVictim = mruPickVictim,
+};
+
+#define RS_TEST_MRU ((ReplacementStrategy)(RS_2Q + 1))
+
+// test a replacement policy plugged in through the policy registry
+void testCustomPolicy(void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[-1 0],[-1 0]",
+        "[0 0],[1 0],[-1 0]",
+        "[0 0],[1 0],[2 0]",
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[3 0]",
+        "[4 0],[1 0],[3 0]"};
+    const int orderRequests[] = {0, 1, 2, 3, 0, 4};
+
+    int i;
+    RC rc;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing a registered replacement policy";
+
+    // the assert macros evaluate their arguments twice, so calls are made once up front
+    rc = registerReplacementPolicy(RS_TEST_MRU, &mruPolicy);
+    ASSERT_EQUALS_INT(RC_OK, rc, "register the policy");
+    rc = registerReplacementPolicy(RS_LRU, &mruPolicy);
+    ASSERT_EQUALS_INT(RC_INVALID_INPUT, rc, "a strategy id that is taken cannot be registered again");
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_TEST_MRU, NULL));
+
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, orderRequests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content reading in pages");
+    }
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// unknown strategies and invalid LRU-K parameters are rejected when the pool is created
+void testInvalidStrategy(void)
+{
+    BM_LRUKParams params = {0, 0};
+    RC rc;
+    BM_BufferPool *bm = MAKE_POOL();
+    testName = "Testing invalid replacement strategies";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    rc = initBufferPool(bm, "testbuffer.bin", 3, (ReplacementStrategy)(RS_2Q + 2), NULL);
+    ASSERT_EQUALS_INT(RC_INVALID_INPUT, rc, "unknown strategy is rejected");
+    rc = initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &params);
+    ASSERT_EQUALS_INT(RC_INVALID_INPUT, rc, "K of 0 is rejected");
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}